@@ -2,13 +2,50 @@
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
+#include <cstdio>
+#include <random>
+
+// Stable LSD radix sort of (handle << 32 | payload) entries by handle, one
+// byte per pass and only as many passes as the largest handle needs. For a
+// batch of a few thousand this is several times faster than std::sort.
+static void sortByHandle(std::vector<uint64_t>& entries, std::vector<uint64_t>& scratch,
+                         uint32_t maxHandle) {
+    scratch.resize(entries.size());
+    for (uint32_t shift = 32; shift < 64 && (maxHandle >> (shift - 32)) != 0; shift += 8) {
+        size_t offsets[257] = {};
+        for (uint64_t entry : entries) {
+            offsets[((entry >> shift) & 0xFF) + 1]++;
+        }
+        for (size_t digit = 1; digit < 257; ++digit) {
+            offsets[digit] += offsets[digit - 1];
+        }
+        for (uint64_t entry : entries) {
+            scratch[offsets[(entry >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+static uint64_t randomSeed() {
+    std::random_device device;
+    return static_cast<uint64_t>(device()) << 32 | device();
+}
 
-AMF::AMF() : NetworkFunction(NFType::AMF, "AMF") {
+AMF::AMF() : NetworkFunction(NFType::AMF, "AMF"), tmsiAllocator_(randomSeed()),
+             globalAdmission_(), admissionStats_(), timerEpoch_(TokenBucket::Clock::now()),
+             implicitDetaches_(0), pendingCount_(0), registrationLatency_() {
+    guami_.mcc = 310;
+    guami_.mnc = 410;
+    guami_.amfRegionId = 1;
+    guami_.amfSetId = 1;
+    guami_.amfPointer = 0;
+    configureAdmission(AdmissionConfig{0, 0, 0, 0, 1000, 60000});
+    configureRegistrationTimers(std::chrono::seconds(54 * 60), std::chrono::seconds(4 * 60));
     logger_.info(name_, "AMF initialized");
 }
 
 bool AMF::registerUe(UeId ueId, Imsi imsi, Imei imei) {
-    if (registeredUes_.find(ueId) != registeredUes_.end()) {
+    if (ueContexts_.find(ueId) != UeContextStore::INVALID_HANDLE) {
         logger_.warning(name_, "UE already registered: " + std::to_string(ueId));
         return false;
     }
@@ -23,129 +60,627 @@ bool AMF::registerUe(UeId ueId, Imsi imsi, Imei imei) {
         return false;
     }
 
-    UeRegistration registration;
-    registration.ueId = ueId;
-    registration.imsi = imsi;
-    registration.imei = imei;
-    registration.isAuthenticated = false;
-    registration.isAuthorized = false;
-    registration.connectedGnb = 0;
-    registration.registrationTime = std::chrono::system_clock::now();
+    // A UE that reattached under a new ID is found by IMSI, not by a scan
+    UeContextStore::Handle handle = ueContexts_.findByImsi(imsi);
+    if (handle != UeContextStore::INVALID_HANDLE) {
+        UeContextStore::UeContext& stale = ueContexts_.at(handle);
+        logger_.info(name_, "UE re-registration | ID=" + std::to_string(ueId) + 
+                           " | Previous ID=" + std::to_string(stale.ueId));
+        paging_.cancel(stale.ueId);
+        ueContexts_.changeUeId(handle, ueId);
+        moveGnbUe(stale.connectedGnb, 0);
+        stale.connectedGnb = 0;
+        ueContexts_.setFlag(stale, UeContextStore::CONNECTED, false);
+        ueContexts_.setFlag(stale, UeContextStore::AUTHENTICATED, false);
+        ueContexts_.setFlag(stale, UeContextStore::AUTHORIZED, false);
+        ueContexts_.setFlag(stale, UeContextStore::PAGING, false);
+    } else {
+        handle = ueContexts_.create(ueId, imsi);
+    }
 
-    registeredUes_[ueId] = registration;
+    UeContextStore::UeContext& context = ueContexts_.at(handle);
+    context.imei = imei;
+    context.registrationTime = std::chrono::system_clock::now();
+    Tmsi tmsi = assignNewTmsi(handle);
+    startReachabilityTimer(context, handle);
 
-    logUeRegistration(ueId, imsi);
+    logUeRegistration(ueId, imsi, tmsi);
     createRegistrationContext(ueId);
 
     return true;
 }
 
+void AMF::configureAdmission(const AdmissionConfig& config) {
+    TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+    admissionConfig_ = config;
+    globalAdmission_.bucket.configure(config.globalRate, config.globalBurst, now);
+    globalAdmission_.nextRetry = now;
+    gnbAdmission_.clear();   // Recreated with the new rates on next use
+
+    if (config.globalRate > 0 || config.perGnbRate > 0) {
+        logger_.info(name_, "Admission control | Global=" + std::to_string(config.globalRate) + 
+                           "/s | Per gNB=" + std::to_string(config.perGnbRate) + "/s");
+    }
+}
+
+AdmissionDecision AMF::admitRegistration(GnbId gnbId) {
+    return admitRegistration(gnbId, TokenBucket::Clock::now());
+}
+
+AdmissionDecision AMF::admitRegistration(GnbId gnbId, TokenBucket::Clock::time_point now) {
+    auto it = gnbAdmission_.find(gnbId);
+    if (it == gnbAdmission_.end()) {
+        it = gnbAdmission_.emplace(gnbId, Admission()).first;
+        it->second.bucket.configure(admissionConfig_.perGnbRate, admissionConfig_.perGnbBurst, now);
+        it->second.nextRetry = now;
+    }
+    Admission& gnb = it->second;
+
+    // Both buckets must have a token before either is charged
+    globalAdmission_.bucket.refill(now);
+    gnb.bucket.refill(now);
+    if (!globalAdmission_.bucket.hasToken()) {
+        admissionStats_.rejectedGlobal++;
+        gnb.stats.rejectedGlobal++;
+        return AdmissionDecision{false, assignBackoffMs(globalAdmission_, now)};
+    }
+    if (!gnb.bucket.hasToken()) {
+        admissionStats_.rejectedGnb++;
+        gnb.stats.rejectedGnb++;
+        return AdmissionDecision{false, assignBackoffMs(gnb, now)};
+    }
+
+    globalAdmission_.bucket.take();
+    gnb.bucket.take();
+    admissionStats_.admitted++;
+    gnb.stats.admitted++;
+    return AdmissionDecision{true, 0};
+}
+
+bool AMF::requestRegistration(UeId ueId, Imsi imsi, Imei imei, GnbId gnbId,
+                              AdmissionDecision& decision) {
+    decision = admitRegistration(gnbId);
+    if (!decision.admitted) {
+        if (logger_.isEnabled(LogLevel::DEBUG)) {
+            logger_.debug(name_, "Registration rejected (congestion) | UE=" + std::to_string(ueId) + 
+                                " | gNB=" + std::to_string(gnbId) + 
+                                " | T3346=" + std::to_string(decision.backoffMs) + "ms");
+        }
+        return false;
+    }
+    return registerUe(ueId, imsi, imei);
+}
+
+bool AMF::startRegistration(UeId ueId, Imsi imsi, Imei imei, GnbId gnbId) {
+    return beginRegistration(ueId, imsi, imei, gnbId, std::chrono::steady_clock::now());
+}
+
+bool AMF::beginRegistration(UeId ueId, Imsi imsi, Imei imei, GnbId gnbId,
+                            std::chrono::steady_clock::time_point start) {
+    if (!hasMessageSender(NFType::UDM)) {
+        logger_.warning(name_, "Cannot start registration: no UDM connected");
+        return false;
+    }
+
+    AdmissionDecision decision = admitRegistration(gnbId);
+    if (!decision.admitted) {
+        reportRegistration(ueId, false, decision.backoffMs, start);
+        return false;
+    }
+
+    if (!validateImsi(imsi) || !validateImei(imei) ||
+        pendingRegistrations_.find(ueId) != pendingRegistrations_.end()) {
+        logger_.warning(name_, "Registration request refused for UE: " + std::to_string(ueId));
+        reportRegistration(ueId, false, 0, start);
+        return false;
+    }
+
+    pendingRegistrations_[ueId] = PendingRegistration{imsi, imei, gnbId, start};
+    pendingCount_.fetch_add(1, std::memory_order_relaxed);
+    send(NFType::UDM, std::make_shared<AuthVectorRequestMessage>(ueId, imsi));
+    return true;
+}
+
+void AMF::completeRegistration(const AuthVectorResponseMessage& response) {
+    UeId ueId = response.getSourceId();
+    auto it = pendingRegistrations_.find(ueId);
+    if (it == pendingRegistrations_.end() || it->second.imsi != response.getImsi()) {
+        logger_.warning(name_, "Unexpected auth vector for UE: " + std::to_string(ueId));
+        return;
+    }
+    PendingRegistration pending = it->second;
+    pendingRegistrations_.erase(it);
+    pendingCount_.fetch_sub(1, std::memory_order_relaxed);
+
+    bool accepted = response.isAuthorized() &&
+                    registerUe(ueId, pending.imsi, pending.imei) &&
+                    authenticateUe(ueId, pending.imsi) &&
+                    authorizeUe(ueId);
+    if (accepted && pending.gnbId != 0) {
+        handleUeAttach(ueId, pending.gnbId);
+    }
+    reportRegistration(ueId, accepted, 0, pending.start);
+}
+
+void AMF::reportRegistration(UeId ueId, bool accepted, uint32_t backoffMs,
+                             std::chrono::steady_clock::time_point start) {
+    RegistrationResult result = {ueId, accepted, backoffMs, Guti(), 0};
+    if (accepted) {
+        getGuti(ueId, result.guti);
+    }
+    result.latencyUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    registrationLatency_.record(result.latencyUs);
+    registrationResults_.push_back(result);
+}
+
+LatencyStats AMF::getRegistrationLatency() const {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    return registrationLatency_;
+}
+
+size_t AMF::collectRegistrationResults(std::vector<RegistrationResult>& results) {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    size_t count = registrationResults_.size();
+    results.insert(results.end(), registrationResults_.begin(), registrationResults_.end());
+    registrationResults_.clear();
+    return count;
+}
+
+AdmissionStats AMF::getGnbAdmissionStats(GnbId gnbId) const {
+    auto it = gnbAdmission_.find(gnbId);
+    return it == gnbAdmission_.end() ? AdmissionStats() : it->second.stats;
+}
+
+bool AMF::reregisterUe(UeId ueId, const Guti& guti) {
+    if (guti.guami.amfRegionId != guami_.amfRegionId || guti.guami.amfSetId != guami_.amfSetId ||
+        guti.guami.amfPointer != guami_.amfPointer) {
+        logger_.warning(name_, "Re-registration with foreign GUTI: " + formatGuti(guti));
+        return false;
+    }
+
+    UeContextStore::Handle handle = ueContexts_.findByTmsi(guti.tmsi);
+    if (handle == UeContextStore::INVALID_HANDLE) {
+        logger_.warning(name_, "Re-registration with unknown GUTI: " + formatGuti(guti));
+        return false;
+    }
+
+    UeContextStore::UeContext& context = ueContexts_.at(handle);
+    if (context.ueId != ueId) {
+        if (ueContexts_.find(ueId) != UeContextStore::INVALID_HANDLE) {
+            logger_.warning(name_, "Re-registration rejected: UE ID in use - " + std::to_string(ueId));
+            return false;
+        }
+        stopPaging(context);
+        ueContexts_.changeUeId(handle, ueId);
+    }
+
+    // The security context carries over; only the GUTI is reallocated
+    context.registrationTime = std::chrono::system_clock::now();
+    Tmsi tmsi = assignNewTmsi(handle);
+    startReachabilityTimer(context, handle);
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "UE re-registered by GUTI | ID=" + std::to_string(ueId) + 
+                           " | 5G-TMSI=" + std::to_string(tmsi));
+    }
+    return true;
+}
+
 bool AMF::deregisterUe(UeId ueId) {
-    auto it = registeredUes_.find(ueId);
-    if (it == registeredUes_.end()) {
+    paging_.cancel(ueId);
+    UeContextStore::Handle handle = ueContexts_.find(ueId);
+    if (handle != UeContextStore::INVALID_HANDLE) {
+        moveGnbUe(ueContexts_.at(handle).connectedGnb, 0);
+        ueTimers_.cancel(handle);
+    }
+    if (!ueContexts_.erase(ueId)) {
         logger_.warning(name_, "UE not registered: " + std::to_string(ueId));
         return false;
     }
 
-    registeredUes_.erase(it);
-    connectedUes_.erase(ueId);
-    ueContextMap_.erase(ueId);
-
     logUeDeregistration(ueId);
 
     return true;
 }
 
 bool AMF::isUeRegistered(UeId ueId) const {
-    return registeredUes_.find(ueId) != registeredUes_.end();
+    return ueContexts_.find(ueId) != UeContextStore::INVALID_HANDLE;
+}
+
+bool AMF::getGuti(UeId ueId, Guti& guti) const {
+    const UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (!context || context->tmsi == UeContextStore::NO_TMSI) {
+        return false;
+    }
+    guti.guami = guami_;
+    guti.tmsi = context->tmsi;
+    return true;
+}
+
+bool AMF::findUeByTmsi(Tmsi tmsi, UeId& ueId) const {
+    UeContextStore::Handle handle = ueContexts_.findByTmsi(tmsi);
+    if (handle == UeContextStore::INVALID_HANDLE) {
+        return false;
+    }
+    ueId = ueContexts_.at(handle).ueId;
+    return true;
+}
+
+bool AMF::findUeByImsi(Imsi imsi, UeId& ueId) const {
+    UeContextStore::Handle handle = ueContexts_.findByImsi(imsi);
+    if (handle == UeContextStore::INVALID_HANDLE) {
+        return false;
+    }
+    ueId = ueContexts_.at(handle).ueId;
+    return true;
+}
+
+std::string AMF::formatGuti(const Guti& guti) {
+    // <MCC><MNC>-<AMF Region ID>-<AMF Set ID>-<AMF Pointer>-<5G-TMSI>
+    char text[48];
+    std::snprintf(text, sizeof(text), "%03u%02u-%02x-%03x-%02x-%08x", guti.guami.mcc, guti.guami.mnc,
+                  guti.guami.amfRegionId, guti.guami.amfSetId, guti.guami.amfPointer, guti.tmsi);
+    return text;
 }
 
 bool AMF::authenticateUe(UeId ueId, Imsi imsi) {
-    auto it = registeredUes_.find(ueId);
-    if (it == registeredUes_.end()) {
+    UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (!context) {
         logger_.warning(name_, "Cannot authenticate: UE not found - " + std::to_string(ueId));
         return false;
     }
 
-    if (it->second.imsi != imsi) {
+    if (context->imsi != imsi) {
         logger_.error(name_, "Authentication failed: IMSI mismatch for UE " + 
                             std::to_string(ueId));
         return false;
     }
 
-    it->second.isAuthenticated = true;
-    logger_.info(name_, "UE authenticated: " + std::to_string(ueId));
+    ueContexts_.setFlag(*context, UeContextStore::AUTHENTICATED, true);
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "UE authenticated: " + std::to_string(ueId));
+    }
 
     return true;
 }
 
 bool AMF::authorizeUe(UeId ueId) {
-    auto it = registeredUes_.find(ueId);
-    if (it == registeredUes_.end() || !it->second.isAuthenticated) {
+    UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (!context || !context->has(UeContextStore::AUTHENTICATED)) {
         logger_.warning(name_, "Cannot authorize: UE not authenticated - " + 
                                std::to_string(ueId));
         return false;
     }
 
-    it->second.isAuthorized = true;
-    logger_.info(name_, "UE authorized: " + std::to_string(ueId));
+    ueContexts_.setFlag(*context, UeContextStore::AUTHORIZED, true);
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "UE authorized: " + std::to_string(ueId));
+    }
 
     return true;
 }
 
 void AMF::handleUeAttach(UeId ueId, GnbId gnbId) {
-    auto it = registeredUes_.find(ueId);
-    if (it == registeredUes_.end()) {
+    UeContextStore::Handle handle = ueContexts_.find(ueId);
+    if (handle == UeContextStore::INVALID_HANDLE) {
         logger_.error(name_, "UE attach failed: UE not registered - " + 
                             std::to_string(ueId));
         return;
     }
+    UeContextStore::UeContext* context = &ueContexts_.at(handle);
+    stopReachabilityTimer(*context, handle);
 
-    it->second.connectedGnb = gnbId;
-    connectedUes_.insert(ueId);
+    moveGnbUe(context->connectedGnb, gnbId);
+    context->connectedGnb = gnbId;
+    updateLocation(*context, gnbId);
+    ueContexts_.setFlag(*context, UeContextStore::CONNECTED, true);
 
-    logger_.info(name_, "UE attached: " + std::to_string(ueId) + 
-                       " to gNodeB " + std::to_string(gnbId));
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "UE attached: " + std::to_string(ueId) + 
+                           " to gNodeB " + std::to_string(gnbId));
+    }
 }
 
 void AMF::handleUeDetach(UeId ueId) {
-    auto it = registeredUes_.find(ueId);
-    if (it == registeredUes_.end()) {
+    UeContextStore::Handle handle = ueContexts_.find(ueId);
+    if (handle == UeContextStore::INVALID_HANDLE) {
         logger_.warning(name_, "UE detach: UE not found - " + std::to_string(ueId));
         return;
     }
-
-    GnbId previousGnb = it->second.connectedGnb;
-    it->second.connectedGnb = 0;
-    connectedUes_.erase(ueId);
-
-    logger_.info(name_, "UE detached: " + std::to_string(ueId) + 
-                       " from gNodeB " + std::to_string(previousGnb));
+    UeContextStore::UeContext* context = &ueContexts_.at(handle);
+    startReachabilityTimer(*context, handle);
+
+    // The last location stays behind for paging the now idle UE
+    GnbId previousGnb = context->connectedGnb;
+    moveGnbUe(previousGnb, 0);
+    context->connectedGnb = 0;
+    ueContexts_.setFlag(*context, UeContextStore::CONNECTED, false);
+
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "UE detached: " + std::to_string(ueId) + 
+                           " from gNodeB " + std::to_string(previousGnb) + 
+                           " | TAC=" + std::to_string(context->lastTac));
+    }
 }
 
 void AMF::handleHandover(UeId ueId, GnbId sourceGnb, GnbId targetGnb) {
-    auto it = registeredUes_.find(ueId);
-    if (it == registeredUes_.end()) {
+    UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (!context) {
         logger_.warning(name_, "Handover failed: UE not found - " + std::to_string(ueId));
         return;
     }
 
-    if (it->second.connectedGnb != sourceGnb) {
+    if (context->connectedGnb != sourceGnb) {
         logger_.error(name_, "Handover failed: Source gNodeB mismatch for UE " + 
                             std::to_string(ueId));
         return;
     }
 
-    it->second.connectedGnb = targetGnb;
+    moveGnbUe(sourceGnb, targetGnb);
+    context->connectedGnb = targetGnb;
+    updateLocation(*context, targetGnb);
+
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Handover complete: UE " + std::to_string(ueId) + 
+                           " from gNodeB " + std::to_string(sourceGnb) + 
+                           " to gNodeB " + std::to_string(targetGnb));
+    }
+}
+
+size_t AMF::handleHandovers(const HandoverRequest* requests, size_t count,
+                            std::vector<UeId>* rejected) {
+    // Resolve every UE first, then walk the contexts in slot order. The
+    // sort is stable, so one UE's handovers keep their order.
+    const size_t lookahead = 8;
+    uint32_t maxHandle = 0;
+    handoverOrder_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (i + lookahead < count) {
+            ueContexts_.prefetch(requests[i + lookahead].ueId);
+        }
+        UeContextStore::Handle handle = ueContexts_.find(requests[i].ueId);
+        if (handle == UeContextStore::INVALID_HANDLE) {
+            if (rejected) {
+                rejected->push_back(requests[i].ueId);
+            }
+            continue;
+        }
+        handoverOrder_.push_back(static_cast<uint64_t>(handle) << 32 | i);
+        maxHandle = std::max(maxHandle, handle);
+    }
+    sortByHandle(handoverOrder_, handoverScratch_, maxHandle);
+
+    // A group moves together, so the target's location is usually the last one
+    gnbDeltas_.clear();
+    GnbId cachedGnb = 0;
+    UeContextStore::UeContext location = UeContextStore::UeContext();
+    size_t applied = 0;
+    for (size_t k = 0; k < handoverOrder_.size(); ++k) {
+        if (k + lookahead < handoverOrder_.size()) {
+            ueContexts_.prefetchContext(static_cast<UeContextStore::Handle>(handoverOrder_[k + lookahead] >> 32));
+        }
+        uint64_t entry = handoverOrder_[k];
+        const HandoverRequest& request = requests[static_cast<uint32_t>(entry)];
+        UeContextStore::UeContext& context = ueContexts_.at(static_cast<UeContextStore::Handle>(entry >> 32));
+        if (context.connectedGnb != request.sourceGnb || request.targetGnb == 0) {
+            if (rejected) {
+                rejected->push_back(request.ueId);
+            }
+            continue;
+        }
+
+        if (request.targetGnb != cachedGnb) {
+            cachedGnb = request.targetGnb;
+            updateLocation(location, cachedGnb);
+        }
+        context.connectedGnb = request.targetGnb;
+        context.lastGnb = location.lastGnb;
+        context.lastTac = location.lastTac;
+        context.taListId = location.taListId;
+
+        // Consecutive moves between the same pair of gNBs are one delta
+        if (gnbDeltas_.size() < 2 || gnbDeltas_[gnbDeltas_.size() - 2].first != request.sourceGnb ||
+            gnbDeltas_.back().first != request.targetGnb) {
+            gnbDeltas_.emplace_back(request.sourceGnb, 0);
+            gnbDeltas_.emplace_back(request.targetGnb, 0);
+        }
+        gnbDeltas_[gnbDeltas_.size() - 2].second--;
+        gnbDeltas_.back().second++;
+        applied++;
+    }
+
+    // Collapse the deltas and touch each gNB's count once
+    std::sort(gnbDeltas_.begin(), gnbDeltas_.end());
+    for (size_t i = 0; i < gnbDeltas_.size();) {
+        GnbId gnbId = gnbDeltas_[i].first;
+        int64_t delta = 0;
+        for (; i < gnbDeltas_.size() && gnbDeltas_[i].first == gnbId; ++i) {
+            delta += gnbDeltas_[i].second;
+        }
+        if (delta != 0 && gnbId != 0) {
+            uint32_t& ues = gnbUeCounts_[gnbId];
+            ues = static_cast<uint32_t>(ues + delta);
+        }
+    }
+
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Batch handover | Applied=" + std::to_string(applied) + 
+                           " | Rejected=" + std::to_string(count - applied));
+    }
+    return applied;
+}
+
+uint32_t AMF::getGnbUeCount(GnbId gnbId) const {
+    auto it = gnbUeCounts_.find(gnbId);
+    return it == gnbUeCounts_.end() ? 0 : it->second;
+}
+
+void AMF::requestPaging(UeId ueId) {
+    UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (!context) {
+        logger_.warning(name_, "Paging failed: UE not registered - " + std::to_string(ueId));
+        return;
+    }
+
+    if (context->has(UeContextStore::PAGING)) {
+        return;  // Paging already in progress
+    }
+    ueContexts_.setFlag(*context, UeContextStore::PAGING, true);
+    paging_.request(PagingTarget{ueId, context->tmsi, context->lastGnb, context->lastTac,
+                                 context->taListId});
+
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Paging UE " + std::to_string(ueId) + 
+                           " | Last gNB=" + std::to_string(context->lastGnb) + 
+                           " | TAC=" + std::to_string(context->lastTac));
+    }
+}
+
+void AMF::configureRegistrationTimers(std::chrono::seconds t3512, std::chrono::seconds implicitDetach) {
+    t3512_ = t3512;
+    mobileReachable_ = t3512 + std::chrono::seconds(4 * 60);
+    implicitDetach_ = implicitDetach;
+    logger_.info(name_, "Registration timers | T3512=" + std::to_string(t3512.count()) + 
+                       "s | Mobile reachable=" + std::to_string(mobileReachable_.count()) + 
+                       "s | Implicit deregistration=" + std::to_string(implicitDetach.count()) + "s");
+}
+
+size_t AMF::runTimers() {
+    return runTimers(TokenBucket::Clock::now());
+}
 
-    logger_.info(name_, "Handover complete: UE " + std::to_string(ueId) + 
-                       " from gNodeB " + std::to_string(sourceGnb) + 
-                       " to gNodeB " + std::to_string(targetGnb));
+size_t AMF::runTimers(TokenBucket::Clock::time_point now, std::vector<UeId>* deregistered) {
+    uint64_t tick = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(now - timerEpoch_).count());
+
+    expiredTimers_.clear();
+    ueTimers_.advance(tick, expiredTimers_);
+    for (uint32_t handle : expiredTimers_) {
+        UeContextStore::UeContext& context = ueContexts_.at(handle);
+        if (!context.has(UeContextStore::UNREACHABLE)) {
+            // Mobile reachable timer: keep the context a while longer
+            ueContexts_.setFlag(context, UeContextStore::UNREACHABLE, true);
+            ueTimers_.schedule(handle, tick + implicitDetach_.count());
+        } else {
+            pendingDetaches_.push_back(context.ueId);
+        }
+    }
+
+    // UEs heard from since they were queued are skipped
+    size_t detached = 0;
+    while (!pendingDetaches_.empty() && detached < MAX_IMPLICIT_DETACHES) {
+        UeId ueId = pendingDetaches_.front();
+        pendingDetaches_.pop_front();
+        UeContextStore::Handle handle = ueContexts_.find(ueId);
+        if (handle == UeContextStore::INVALID_HANDLE || ueTimers_.isArmed(handle) ||
+            !ueContexts_.at(handle).has(UeContextStore::UNREACHABLE)) {
+            continue;
+        }
+        deregisterUe(ueId);
+        if (deregistered) {
+            deregistered->push_back(ueId);
+        }
+        detached++;
+    }
+
+    implicitDetaches_ += detached;
+    if (detached > 0 && logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Implicit deregistration | UEs=" + std::to_string(detached) + 
+                           " | Queued=" + std::to_string(pendingDetaches_.size()));
+    }
+    return detached;
+}
+
+bool AMF::isUeReachable(UeId ueId) const {
+    const UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    return context && !context->has(UeContextStore::UNREACHABLE);
+}
+
+void AMF::addGnb(GnbId gnbId, const std::vector<Tac>& tacs) {
+    paging_.addGnb(gnbId, tacs);
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "NG Setup | gNodeB " + std::to_string(gnbId) + 
+                           " | TACs=" + std::to_string(tacs.size()) + 
+                           " | First TAC=" + std::to_string(tacs.empty() ? 0 : tacs.front()));
+    }
+}
+
+void AMF::setRegistrationArea(const std::vector<Tac>& tacs) {
+    uint16_t taListId = paging_.addTaList(tacs);
+    if (taListId == 0) {
+        logger_.warning(name_, "Registration area not added: too many TA lists");
+        return;
+    }
+    for (Tac tac : tacs) {
+        registrationAreas_[tac] = taListId;
+    }
+    logger_.info(name_, "Registration area " + std::to_string(taListId) + 
+                       " | TACs=" + std::to_string(tacs.size()));
+}
+
+std::vector<std::shared_ptr<Message>> AMF::runPagingTick() {
+    pagingBatches_.clear();
+    pagingFailures_.clear();
+    paging_.tick(pagingBatches_, pagingFailures_);
+
+    std::vector<std::shared_ptr<Message>> messages;
+    messages.reserve(pagingBatches_.size());
+    for (PagingBatch& batch : pagingBatches_) {
+        messages.push_back(std::make_shared<PagingMessage>(batch.gnbId, std::move(batch.tmsis)));
+    }
+
+    for (UeId ueId : pagingFailures_) {
+        UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+        if (context) {
+            ueContexts_.setFlag(*context, UeContextStore::PAGING, false);
+        }
+        logger_.warning(name_, "Paging failed: no response from UE " + std::to_string(ueId));
+    }
+    return messages;
+}
+
+bool AMF::isPagingPending(UeId ueId) const {
+    const UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    return context && context->has(UeContextStore::PAGING);
+}
+
+void AMF::handleServiceRequest(UeId ueId) {
+    UeContextStore::Handle handle = ueContexts_.find(ueId);
+    if (handle != UeContextStore::INVALID_HANDLE) {
+        stopPaging(ueContexts_.at(handle));
+        startReachabilityTimer(ueContexts_.at(handle), handle);
+    }
+    logger_.info(name_, "Service request from UE " + std::to_string(ueId));
+}
+
+bool AMF::handleServiceRequestByTmsi(Tmsi tmsi) {
+    UeContextStore::Handle handle = ueContexts_.findByTmsi(tmsi);
+    if (handle == UeContextStore::INVALID_HANDLE) {
+        logger_.warning(name_, "Service request with unknown 5G-TMSI: " + std::to_string(tmsi));
+        return false;
+    }
+
+    UeContextStore::UeContext& context = ueContexts_.at(handle);
+    stopPaging(context);
+    startReachabilityTimer(context, handle);
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Service request from UE " + std::to_string(context.ueId) + 
+                           " | 5G-TMSI=" + std::to_string(tmsi));
+    }
+    return true;
 }
 
 void AMF::createRegistrationContext(UeId ueId) {
-    ueContextMap_[ueId] = "REG_CONTEXT_" + std::to_string(ueId);
-    logger_.debug(name_, "Registration context created for UE " + std::to_string(ueId));
+    UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (!context) {
+        return;
+    }
+    ueContexts_.setFlag(*context, UeContextStore::REGISTRATION_CONTEXT, true);
+    if (logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Registration context created for UE " + std::to_string(ueId));
+    }
 }
 
 void AMF::createAmfContext(UeId ueId) {
@@ -153,23 +688,38 @@ void AMF::createAmfContext(UeId ueId) {
 }
 
 void AMF::deleteRegistrationContext(UeId ueId) {
-    ueContextMap_.erase(ueId);
+    UeContextStore::UeContext* context = ueContexts_.findContext(ueId);
+    if (context) {
+        ueContexts_.setFlag(*context, UeContextStore::REGISTRATION_CONTEXT, false);
+    }
     logger_.debug(name_, "Registration context deleted for UE " + std::to_string(ueId));
 }
 
 void AMF::handleMessage(std::shared_ptr<Message> message) {
     if (!message) return;
 
-    logger_.debug(name_, "Handling message: " + message->toString());
+    if (logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Handling message: " + message->toString());
+    }
 
     switch (message->getType()) {
         case MessageType::UE_ATTACH_REQUEST: {
             auto attachMsg = std::dynamic_pointer_cast<AttachRequestMessage>(message);
-            if (attachMsg) {
+            if (attachMsg && hasMessageSender(NFType::UDM)) {
+                beginRegistration(message->getSourceId(), attachMsg->getImsi(), attachMsg->getImei(),
+                                  attachMsg->getGnbId(), message->getTimestamp());
+            } else if (attachMsg) {
                 registerUe(message->getSourceId(), attachMsg->getImsi(), attachMsg->getImei());
             }
             break;
         }
+        case MessageType::AUTH_VECTOR_RESPONSE: {
+            auto authMsg = std::dynamic_pointer_cast<AuthVectorResponseMessage>(message);
+            if (authMsg) {
+                completeRegistration(*authMsg);
+            }
+            break;
+        }
         case MessageType::REGISTRATION_REQUEST: {
             auto regMsg = std::dynamic_pointer_cast<RegistrationRequestMessage>(message);
             if (regMsg) {
@@ -181,6 +731,9 @@ void AMF::handleMessage(std::shared_ptr<Message> message) {
         case MessageType::UE_DETACH_REQUEST:
             deregisterUe(message->getSourceId());
             break;
+        case MessageType::DOWNLINK_DATA_NOTIFICATION:
+            requestPaging(message->getSourceId());
+            break;
         default:
             logger_.warning(name_, "Unknown message type");
             break;
@@ -189,27 +742,104 @@ void AMF::handleMessage(std::shared_ptr<Message> message) {
 
 void AMF::printRegisteredUes() const {
     std::cout << "\n================== AMF Registered UEs ==================\n";
-    std::cout << "Total Registered UEs: " << registeredUes_.size() << "\n";
-    std::cout << "Connected UEs: " << connectedUes_.size() << "\n\n";
-
-    for (const auto& pair : registeredUes_) {
-        const auto& reg = pair.second;
-        std::cout << "UE ID: " << reg.ueId << " | IMSI: " << reg.imsi 
-                  << " | Authenticated: " << (reg.isAuthenticated ? "Yes" : "No")
-                  << " | Connected gNB: " << reg.connectedGnb << "\n";
-    }
+    std::cout << "Total Registered UEs: " << getRegisteredUeCount() << "\n";
+    std::cout << "Connected UEs: " << getConnectedUeCount() << "\n\n";
+
+    ueContexts_.forEach([this](const UeContextStore::UeContext& context) {
+        std::cout << "UE ID: " << context.ueId << " | IMSI: " << context.imsi 
+                  << " | GUTI: " << formatGuti(Guti{guami_, context.tmsi})
+                  << " | Authenticated: " << (context.has(UeContextStore::AUTHENTICATED) ? "Yes" : "No")
+                  << " | Connected gNB: " << context.connectedGnb << "\n";
+    });
     std::cout << "========================================================\n\n";
 }
 
 std::string AMF::getAMFStatus() const {
     std::ostringstream oss;
     oss << "AMF Status:\n"
-        << "  Registered UEs: " << registeredUes_.size() << "\n"
-        << "  Connected UEs: " << connectedUes_.size() << "\n"
-        << "  Registration Contexts: " << ueContextMap_.size() << "\n";
+        << "  Registered UEs: " << getRegisteredUeCount() << "\n"
+        << "  Connected UEs: " << getConnectedUeCount() << "\n"
+        << "  Registration Contexts: " << ueContexts_.count(UeContextStore::REGISTRATION_CONTEXT) << "\n"
+        << "  Admission: " << admissionStats_.admitted << " admitted, "
+        << admissionStats_.rejectedGlobal << " rejected (AMF limit), "
+        << admissionStats_.rejectedGnb << " rejected (gNB limit)\n"
+        << "  Paging: " << paging_.getStats().requested << " requested, "
+        << paging_.getStats().messages << " messages, "
+        << paging_.getPendingCount() << " pending, "
+        << paging_.getStats().failed << " failed\n"
+        << "  Reachability timers: " << ueTimers_.size() << " armed, "
+        << ueContexts_.count(UeContextStore::UNREACHABLE) << " unreachable, "
+        << implicitDetaches_ << " implicitly deregistered\n";
     return oss.str();
 }
 
+Tmsi AMF::assignNewTmsi(UeContextStore::Handle handle) {
+    // The allocator never repeats within 2^32 draws; the loop only guards
+    // against a wrapped counter meeting a long-lived TMSI
+    Tmsi tmsi = tmsiAllocator_.allocate();
+    while (!ueContexts_.assignTmsi(handle, tmsi)) {
+        tmsi = tmsiAllocator_.allocate();
+    }
+    return tmsi;
+}
+
+void AMF::updateLocation(UeContextStore::UeContext& context, GnbId gnbId) {
+    context.lastGnb = gnbId;
+    context.lastTac = paging_.getGnbTac(gnbId);
+    auto area = registrationAreas_.find(context.lastTac);
+    context.taListId = area == registrationAreas_.end() ? 0 : area->second;
+}
+
+void AMF::moveGnbUe(GnbId fromGnb, GnbId toGnb) {
+    if (fromGnb == toGnb) {
+        return;
+    }
+    if (fromGnb != 0) {
+        auto it = gnbUeCounts_.find(fromGnb);
+        if (it != gnbUeCounts_.end() && it->second > 0) {
+            it->second--;
+        }
+    }
+    if (toGnb != 0) {
+        gnbUeCounts_[toGnb]++;
+    }
+}
+
+void AMF::startReachabilityTimer(UeContextStore::UeContext& context, UeContextStore::Handle handle) {
+    ueContexts_.setFlag(context, UeContextStore::UNREACHABLE, false);
+
+    // The wheel only moves in runTimers, so its tick lags the clock between
+    // runs; callers driving runTimers with their own clock may be ahead of it
+    uint64_t tick = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        TokenBucket::Clock::now() - timerEpoch_).count());
+    tick = std::max(tick, ueTimers_.getCurrentTick());
+    ueTimers_.schedule(handle, tick + mobileReachable_.count());
+}
+
+void AMF::stopReachabilityTimer(UeContextStore::UeContext& context, UeContextStore::Handle handle) {
+    ueContexts_.setFlag(context, UeContextStore::UNREACHABLE, false);
+    ueTimers_.cancel(handle);
+}
+
+void AMF::stopPaging(UeContextStore::UeContext& context) {
+    if (context.has(UeContextStore::PAGING)) {
+        paging_.answer(context.ueId);
+        ueContexts_.setFlag(context, UeContextStore::PAGING, false);
+    }
+}
+
+uint32_t AMF::assignBackoffMs(Admission& limiting, TokenBucket::Clock::time_point now) {
+    // Each rejected UE gets the next retry slot; slots are 1/rate apart
+    TokenBucket::Clock::time_point earliest = now + std::chrono::milliseconds(admissionConfig_.minBackoffMs);
+    if (limiting.nextRetry < earliest) {
+        limiting.nextRetry = earliest;
+    }
+    auto backoff = std::chrono::duration_cast<std::chrono::milliseconds>(limiting.nextRetry - now);
+    limiting.nextRetry += std::chrono::duration_cast<TokenBucket::Clock::duration>(
+        std::chrono::duration<double>(1.0 / limiting.bucket.getRate()));
+    return static_cast<uint32_t>(std::min<int64_t>(backoff.count(), admissionConfig_.maxBackoffMs));
+}
+
 bool AMF::validateImsi(Imsi imsi) {
     // Basic IMSI validation: IMSI should be between certain ranges
     return imsi > 0 && imsi < 1000000000000000ULL;
@@ -220,12 +850,19 @@ bool AMF::validateImei(Imei imei) {
     return imei > 0 && imei < 1000000000000000ULL;
 }
 
-void AMF::logUeRegistration(UeId ueId, Imsi imsi) {
+void AMF::logUeRegistration(UeId ueId, Imsi imsi, Tmsi tmsi) {
+    if (!logger_.isEnabled(LogLevel::INFO)) {
+        return;
+    }
     logger_.info(name_, "UE Registration | ID=" + std::to_string(ueId) + 
-                       " | IMSI=" + std::to_string(imsi));
+                       " | IMSI=" + std::to_string(imsi) + 
+                       " | GUTI=" + formatGuti(Guti{guami_, tmsi}));
 }
 
 void AMF::logUeDeregistration(UeId ueId) {
+    if (!logger_.isEnabled(LogLevel::INFO)) {
+        return;
+    }
     logger_.info(name_, "UE Deregistration | ID=" + std::to_string(ueId));
 }
 
@@ -236,7 +873,12 @@ void AMF::start() {
 
 void AMF::stop() {
     NetworkFunction::stop();
-    registeredUes_.clear();
-    connectedUes_.clear();
+    paging_.clear();
+    gnbUeCounts_.clear();
+    ueTimers_.clear();
+    pendingDetaches_.clear();
+    pendingRegistrations_.clear();
+    pendingCount_ = 0;
+    ueContexts_.clear();
     logger_.info(name_, "AMF stopped");
 }
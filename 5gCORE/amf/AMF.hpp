@@ -2,20 +2,111 @@
 #define AMF_HPP
 
 #include "../common/NetworkFunction.hpp"
+#include "../common/TimerWheel.hpp"
+#include "../common/TokenBucket.hpp"
 #include "../common/Types.hpp"
-#include <map>
-#include <set>
+#include "PagingEngine.hpp"
+#include "TmsiAllocator.hpp"
+#include "UeContextStore.hpp"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+struct AdmissionConfig {
+    double globalRate;          // Registrations/s across the AMF, 0 = unlimited
+    double globalBurst;
+    double perGnbRate;          // Registrations/s from one gNB, 0 = unlimited
+    double perGnbBurst;
+    uint32_t minBackoffMs;      // Bounds of the T3346 value sent with a reject
+    uint32_t maxBackoffMs;
+};
+
+struct AdmissionDecision {
+    bool admitted;
+    uint32_t backoffMs;         // T3346 for a rejected UE, 0 when admitted
+};
+
+struct AdmissionStats {
+    uint64_t admitted;
+    uint64_t rejectedGlobal;    // Over the AMF-wide limit
+    uint64_t rejectedGnb;       // Over the sending gNB's limit
+};
+
+struct HandoverRequest {
+    UeId ueId;
+    GnbId sourceGnb;
+    GnbId targetGnb;
+};
+
+struct RegistrationResult {
+    UeId ueId;
+    bool accepted;
+    uint32_t backoffMs;         // T3346 when rejected by admission control
+    Guti guti;                  // Valid when accepted
+    uint64_t latencyUs;         // From the attach request to the outcome
+};
 
 class AMF : public NetworkFunction {
 public:
     explicit AMF();
     ~AMF() override = default;
 
-    // UE Registration Management
+    // UE Registration Management. Every registration allocates a new
+    // 5G-GUTI; a UE that registers again with a known IMSI under a new UeId
+    // takes over its old context instead of leaving it behind.
     bool registerUe(UeId ueId, Imsi imsi, Imei imei);
+    bool reregisterUe(UeId ueId, const Guti& guti);   // Mobility/periodic update by GUTI
     bool deregisterUe(UeId ueId);
     bool isUeRegistered(UeId ueId) const;
 
+    // Registration admission control: one token bucket for the AMF and one
+    // per gNB. A registration over either limit is rejected with a back-off
+    // timer; back-offs are handed out as retry slots at the limiting rate,
+    // so rejected UEs come back about as fast as they can be admitted.
+    // Unlimited until configured.
+    void configureAdmission(const AdmissionConfig& config);
+    AdmissionDecision admitRegistration(GnbId gnbId);
+    AdmissionDecision admitRegistration(GnbId gnbId, TokenBucket::Clock::time_point now);
+    bool requestRegistration(UeId ueId, Imsi imsi, Imei imei, GnbId gnbId,
+                             AdmissionDecision& decision);
+    const AdmissionStats& getAdmissionStats() const { return admissionStats_; }
+
+    // Message-driven registration: the AMF asks the UDM for an auth vector,
+    // the UDM fetches the subscription from the UDR, and the registration
+    // completes when the answer comes back. Needs a UDM message sender;
+    // any number of UEs can be in flight. Outcomes are queued for
+    // collectRegistrationResults, which may be called from any thread.
+    bool startRegistration(UeId ueId, Imsi imsi, Imei imei, GnbId gnbId);
+    size_t collectRegistrationResults(std::vector<RegistrationResult>& results);
+    size_t getPendingRegistrationCount() const { return pendingCount_.load(std::memory_order_relaxed); }
+    LatencyStats getRegistrationLatency() const;
+    AdmissionStats getGnbAdmissionStats(GnbId gnbId) const;
+
+    // Temporary and permanent identity lookups, O(1)
+    bool getGuti(UeId ueId, Guti& guti) const;
+    bool findUeByTmsi(Tmsi tmsi, UeId& ueId) const;
+    bool findUeByImsi(Imsi imsi, UeId& ueId) const;
+    const Guami& getGuami() const { return guami_; }
+    static std::string formatGuti(const Guti& guti);
+
+    // Reachability of registered UEs. Each UE has one timer on a timing
+    // wheel keyed by its context: the mobile reachable timer (T3512 plus
+    // four minutes) runs from registration or from going idle, and a
+    // connected UE has none. On expiry the UE is marked unreachable and
+    // the implicit deregistration timer starts; when that expires too the
+    // UE is deregistered. Time moves only in runTimers, at one-second
+    // resolution, and at most MAX_IMPLICIT_DETACHES UEs are deregistered
+    // per call; the rest wait for the next one.
+    static constexpr size_t MAX_IMPLICIT_DETACHES = 4096;
+    void configureRegistrationTimers(std::chrono::seconds t3512, std::chrono::seconds implicitDetach);
+    std::chrono::seconds getPeriodicRegistrationTimer() const { return t3512_; }
+    size_t runTimers();
+    size_t runTimers(TokenBucket::Clock::time_point now, std::vector<UeId>* deregistered = nullptr);
+    bool isUeReachable(UeId ueId) const;
+    size_t getArmedTimerCount() const { return ueTimers_.size(); }
+    uint64_t getImplicitDeregistrationCount() const { return implicitDetaches_; }
+
     // Authentication
     bool authenticateUe(UeId ueId, Imsi imsi);
     bool authorizeUe(UeId ueId);
@@ -24,6 +115,30 @@ public:
     void handleUeAttach(UeId ueId, GnbId gnbId);
     void handleUeDetach(UeId ueId);
     void handleHandover(UeId ueId, GnbId sourceGnb, GnbId targetGnb);
+    uint32_t getGnbUeCount(GnbId gnbId) const;   // Connected UEs
+
+    // Group mobility (a train crossing a cell border): handovers are applied
+    // in context order, and per-gNB UE counts updated once per gNB. Requests
+    // for one UE are applied in the order given. Returns the number applied;
+    // the UEs of the others are appended to rejected when it is given.
+    size_t handleHandovers(const HandoverRequest* requests, size_t count,
+                           std::vector<UeId>* rejected = nullptr);
+
+    // Tracking areas: gNBs announce theirs at NG Setup; a registration
+    // area (TA list) is handed to every UE that attaches in one of its TAs
+    void addGnb(GnbId gnbId, const std::vector<Tac>& tacs);
+    void setRegistrationArea(const std::vector<Tac>& tacs);
+
+    // Paging. Requests are queued and sent on the next paging tick, one
+    // message per gNB, escalating from the UE's last gNB to its tracking
+    // area and then its registration area.
+    void requestPaging(UeId ueId);
+    void handleServiceRequest(UeId ueId);
+    bool handleServiceRequestByTmsi(Tmsi tmsi);
+    bool isPagingPending(UeId ueId) const;
+    std::vector<std::shared_ptr<Message>> runPagingTick();
+    PagingEngine& getPagingEngine() { return paging_; }
+    const PagingStats& getPagingStats() const { return paging_.getStats(); }
 
     // Session Management
     void createRegistrationContext(UeId ueId);
@@ -36,30 +151,76 @@ public:
     // Statistics and Information
     void printRegisteredUes() const;
     std::string getAMFStatus() const;
-    uint32_t getRegisteredUeCount() const { return registeredUes_.size(); }
-    uint32_t getConnectedUeCount() const { return connectedUes_.size(); }
+    uint32_t getRegisteredUeCount() const { return static_cast<uint32_t>(ueContexts_.size()); }
+    uint32_t getConnectedUeCount() const {
+        return static_cast<uint32_t>(ueContexts_.count(UeContextStore::CONNECTED));
+    }
+    size_t getUeContextMemoryBytes() const { return ueContexts_.getMemoryBytes(); }
+    const UeContextStore& getUeContextStore() const { return ueContexts_; }
 
     void start() override;
     void stop() override;
 
 private:
-    struct UeRegistration {
-        UeId ueId;
+    struct Admission {
+        TokenBucket bucket;
+        TokenBucket::Clock::time_point nextRetry;   // Next free retry slot
+        AdmissionStats stats;
+    };
+
+    UeContextStore ueContexts_;
+    TmsiAllocator tmsiAllocator_;
+    PagingEngine paging_;
+    std::unordered_map<Tac, uint16_t> registrationAreas_;   // TAC -> TA list
+    std::vector<PagingBatch> pagingBatches_;
+    std::vector<UeId> pagingFailures_;
+    std::unordered_map<GnbId, uint32_t> gnbUeCounts_;
+    std::vector<uint64_t> handoverOrder_;               // Handle << 32 | request
+    std::vector<uint64_t> handoverScratch_;
+    std::vector<std::pair<GnbId, int32_t>> gnbDeltas_;
+    Guami guami_;
+    AdmissionConfig admissionConfig_;
+    Admission globalAdmission_;
+    std::unordered_map<GnbId, Admission> gnbAdmission_;
+    AdmissionStats admissionStats_;
+    TimerWheel ueTimers_;                               // Keyed by context handle
+    TokenBucket::Clock::time_point timerEpoch_;         // Tick 0
+    std::chrono::seconds t3512_;
+    std::chrono::seconds mobileReachable_;
+    std::chrono::seconds implicitDetach_;
+    std::vector<uint32_t> expiredTimers_;
+    std::deque<UeId> pendingDetaches_;
+    uint64_t implicitDetaches_;
+
+    struct PendingRegistration {
         Imsi imsi;
         Imei imei;
-        bool isAuthenticated;
-        bool isAuthorized;
-        GnbId connectedGnb;
-        std::chrono::system_clock::time_point registrationTime;
+        GnbId gnbId;
+        std::chrono::steady_clock::time_point start;
     };
+    std::unordered_map<UeId, PendingRegistration> pendingRegistrations_;
+    std::atomic<size_t> pendingCount_;
+    mutable std::mutex resultMutex_;    // Guards the two below
+    LatencyStats registrationLatency_;
+    std::vector<RegistrationResult> registrationResults_;
+
+    bool beginRegistration(UeId ueId, Imsi imsi, Imei imei, GnbId gnbId,
+                           std::chrono::steady_clock::time_point start);
+    void completeRegistration(const AuthVectorResponseMessage& response);
+    void reportRegistration(UeId ueId, bool accepted, uint32_t backoffMs,
+                            std::chrono::steady_clock::time_point start);
 
-    std::map<UeId, UeRegistration> registeredUes_;
-    std::set<UeId> connectedUes_;
-    std::map<UeId, std::string> ueContextMap_;
+    Tmsi assignNewTmsi(UeContextStore::Handle handle);
+    void updateLocation(UeContextStore::UeContext& context, GnbId gnbId);
+    void stopPaging(UeContextStore::UeContext& context);
+    void moveGnbUe(GnbId fromGnb, GnbId toGnb);
+    void startReachabilityTimer(UeContextStore::UeContext& context, UeContextStore::Handle handle);
+    void stopReachabilityTimer(UeContextStore::UeContext& context, UeContextStore::Handle handle);
+    uint32_t assignBackoffMs(Admission& limiting, TokenBucket::Clock::time_point now);
 
     bool validateImsi(Imsi imsi);
     bool validateImei(Imei imei);
-    void logUeRegistration(UeId ueId, Imsi imsi);
+    void logUeRegistration(UeId ueId, Imsi imsi, Tmsi tmsi);
     void logUeDeregistration(UeId ueId);
 };
 
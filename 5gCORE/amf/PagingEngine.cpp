@@ -0,0 +1,199 @@
+#include "PagingEngine.hpp"
+
+PagingEngine::PagingEngine()
+    : taLists_(1), responseTicks_(2), tick_(0), sends_(0), stats_() {
+    strategy_ = {PagingScope::LAST_GNB, PagingScope::TRACKING_AREA, PagingScope::TA_LIST};
+}
+
+void PagingEngine::addGnb(GnbId gnbId, const std::vector<Tac>& tacs) {
+    if (gnbIndex_.find(gnbId) != DenseIndex::NOT_FOUND || tacs.empty()) {
+        return;
+    }
+
+    uint32_t slot = static_cast<uint32_t>(gnbs_.size());
+    gnbs_.push_back(GnbSlot{gnbId, tacs.front(), 0, {}});
+    gnbIndex_.insert(gnbId, slot);
+    for (Tac tac : tacs) {
+        taGnbs_[tac].push_back(slot);
+    }
+}
+
+uint16_t PagingEngine::addTaList(const std::vector<Tac>& tacs) {
+    if (taLists_.size() > 0xFFFF) {
+        return 0;
+    }
+    taLists_.push_back(tacs);
+    return static_cast<uint16_t>(taLists_.size() - 1);
+}
+
+Tac PagingEngine::getGnbTac(GnbId gnbId) const {
+    uint32_t slot = gnbIndex_.find(gnbId);
+    return slot == DenseIndex::NOT_FOUND ? 0 : gnbs_[slot].tac;
+}
+
+void PagingEngine::setStrategy(const std::vector<PagingScope>& steps) {
+    if (!steps.empty()) {
+        strategy_ = steps;
+    }
+}
+
+bool PagingEngine::request(const PagingTarget& target) {
+    if (isPaging(target.ueId)) {
+        return false;
+    }
+
+    uint32_t handle = pool_.acquire();
+    Attempt& attempt = pool_.at(handle);
+    attempt.target = target;
+    attempt.deadline = 0;
+    attempt.step = 0;
+    index_.insert(target.ueId, handle);
+    due_.push_back(target.ueId);
+    stats_.requested++;
+    return true;
+}
+
+bool PagingEngine::answer(UeId ueId) {
+    uint32_t handle = index_.find(ueId);
+    if (handle == DenseIndex::NOT_FOUND) {
+        return false;
+    }
+
+    const Attempt& attempt = pool_.at(handle);
+    stats_.answered[static_cast<size_t>(scopeOf(attempt, attempt.step))]++;
+    remove(ueId, handle);
+    return true;
+}
+
+bool PagingEngine::cancel(UeId ueId) {
+    uint32_t handle = index_.find(ueId);
+    if (handle == DenseIndex::NOT_FOUND) {
+        return false;
+    }
+    remove(ueId, handle);
+    return true;
+}
+
+void PagingEngine::tick(std::vector<PagingBatch>& batches, std::vector<UeId>& failed) {
+    tick_++;
+
+    // Closed windows escalate. Entries of answered, cancelled or already
+    // escalated attempts no longer match and are dropped.
+    while (!deadlines_.empty() && deadlines_.front().tick <= tick_) {
+        Deadline expired = deadlines_.front();
+        deadlines_.pop_front();
+
+        uint32_t handle = index_.find(expired.ueId);
+        if (handle == DenseIndex::NOT_FOUND) {
+            continue;
+        }
+        Attempt& attempt = pool_.at(handle);
+        if (attempt.step != expired.step || attempt.deadline != expired.tick) {
+            continue;
+        }
+
+        // Steps that would page the same gNBs again are skipped
+        PagingScope current = scopeOf(attempt, attempt.step);
+        uint8_t step = attempt.step + 1;
+        while (step < strategy_.size() && scopeOf(attempt, step) == current) {
+            step++;
+        }
+        if (step >= strategy_.size()) {
+            failed.push_back(expired.ueId);
+            stats_.failed++;
+            remove(expired.ueId, handle);
+            continue;
+        }
+        attempt.step = step;
+        send(attempt);
+    }
+
+    for (UeId ueId : due_) {
+        uint32_t handle = index_.find(ueId);
+        // A UE cancelled and paged again in one tick is listed twice
+        if (handle != DenseIndex::NOT_FOUND && pool_.at(handle).deadline == 0) {
+            send(pool_.at(handle));
+        }
+    }
+    due_.clear();
+
+    for (uint32_t slot : touched_) {
+        GnbSlot& gnb = gnbs_[slot];
+        stats_.messages++;
+        stats_.records += gnb.tmsis.size();
+        batches.push_back(PagingBatch{gnb.gnbId, std::move(gnb.tmsis)});
+        gnb.tmsis.clear();
+    }
+    touched_.clear();
+}
+
+void PagingEngine::clear() {
+    pool_.clear();
+    index_.clear();
+    due_.clear();
+    deadlines_.clear();
+    for (uint32_t slot : touched_) {
+        gnbs_[slot].tmsis.clear();
+    }
+    touched_.clear();
+}
+
+PagingScope PagingEngine::scopeOf(const Attempt& attempt, uint8_t step) const {
+    PagingScope scope = strategy_[step];
+    if (scope == PagingScope::LAST_GNB && gnbIndex_.find(attempt.target.lastGnb) == DenseIndex::NOT_FOUND) {
+        return PagingScope::TRACKING_AREA;
+    }
+    if (scope == PagingScope::TA_LIST &&
+        (attempt.target.taListId == 0 || attempt.target.taListId >= taLists_.size())) {
+        return PagingScope::TRACKING_AREA;
+    }
+    return scope;
+}
+
+void PagingEngine::send(Attempt& attempt) {
+    sends_++;
+    const PagingTarget& target = attempt.target;
+    switch (scopeOf(attempt, attempt.step)) {
+        case PagingScope::LAST_GNB:
+            addToGnb(gnbIndex_.find(target.lastGnb), target.tmsi);
+            break;
+        case PagingScope::TRACKING_AREA:
+            addToTa(target.lastTac, target.tmsi);
+            break;
+        case PagingScope::TA_LIST:
+            for (Tac tac : taLists_[target.taListId]) {
+                addToTa(tac, target.tmsi);
+            }
+            break;
+    }
+
+    attempt.deadline = tick_ + responseTicks_;
+    deadlines_.push_back(Deadline{attempt.deadline, target.ueId, attempt.step});
+}
+
+void PagingEngine::addToTa(Tac tac, Tmsi tmsi) {
+    auto it = taGnbs_.find(tac);
+    if (it == taGnbs_.end()) {
+        return;
+    }
+    for (uint32_t slot : it->second) {
+        addToGnb(slot, tmsi);
+    }
+}
+
+void PagingEngine::addToGnb(uint32_t slot, Tmsi tmsi) {
+    GnbSlot& gnb = gnbs_[slot];
+    if (gnb.mark == sends_) {
+        return;     // Already in this batch through another TA of the list
+    }
+    if (gnb.tmsis.empty()) {
+        touched_.push_back(slot);
+    }
+    gnb.mark = sends_;
+    gnb.tmsis.push_back(tmsi);
+}
+
+void PagingEngine::remove(UeId ueId, uint32_t handle) {
+    index_.erase(ueId);
+    pool_.release(handle);
+}
@@ -0,0 +1,123 @@
+#ifndef PAGING_ENGINE_HPP
+#define PAGING_ENGINE_HPP
+
+#include "../common/Types.hpp"
+#include "../common/DenseIndex.hpp"
+#include "../common/SlabPool.hpp"
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+enum class PagingScope : uint8_t {
+    LAST_GNB,           // The gNB the UE was last connected to
+    TRACKING_AREA,      // Every gNB in the UE's last tracking area
+    TA_LIST             // Every gNB in the UE's registration area
+};
+
+constexpr size_t PAGING_SCOPE_COUNT = 3;
+
+// Where an idle UE was last seen, as the AMF knows it
+struct PagingTarget {
+    UeId ueId;
+    Tmsi tmsi;
+    GnbId lastGnb;          // 0 = unknown
+    Tac lastTac;
+    uint16_t taListId;      // 0 = registration area is the last TA alone
+};
+
+// One paging message's worth of UEs for one gNB
+struct PagingBatch {
+    GnbId gnbId;
+    std::vector<Tmsi> tmsis;
+};
+
+struct PagingStats {
+    uint64_t requested;
+    uint64_t messages;                       // Per-gNB paging messages
+    uint64_t records;                        // UE entries across those messages
+    uint64_t answered[PAGING_SCOPE_COUNT];   // By the scope that reached the UE
+    uint64_t failed;                         // No answer after the last step
+};
+
+// Paging scheduler of the AMF.
+//
+// Requests are collected between scheduling ticks. Each tick sends every
+// due UE to the gNBs of its current scope, and all UEs bound for the same
+// gNB go out in one batch, so a gNB gets at most one paging message per
+// tick however many UEs it is asked to page. An attempt that is not
+// answered within the response window escalates to the next scope of the
+// strategy (by default last gNB, then tracking area, then TA list) and is
+// reported as failed after the last one. Attempts live in a slab pool keyed
+// by UeId; a tick costs O(due UEs + gNBs paged). Not thread-safe; the AMF
+// serializes access.
+class PagingEngine {
+public:
+    PagingEngine();
+
+    // Topology, from NG Setup and the AMF's registration area configuration
+    void addGnb(GnbId gnbId, const std::vector<Tac>& tacs);
+    uint16_t addTaList(const std::vector<Tac>& tacs);   // ID of the new list, from 1
+    Tac getGnbTac(GnbId gnbId) const;                   // First TAC, 0 if unknown
+    size_t getGnbCount() const { return gnbs_.size(); }
+
+    void setStrategy(const std::vector<PagingScope>& steps);
+    void setResponseTicks(uint32_t ticks) { responseTicks_ = ticks ? ticks : 1; }
+
+    bool request(const PagingTarget& target);   // False if already being paged
+    bool answer(UeId ueId);                     // Service request from a paged UE
+    bool cancel(UeId ueId);
+    bool isPaging(UeId ueId) const { return index_.find(ueId) != DenseIndex::NOT_FOUND; }
+
+    // Escalates attempts whose response window has closed and sends this
+    // tick's pages. Appends one batch per gNB paged and the UEs that ran
+    // out of steps.
+    void tick(std::vector<PagingBatch>& batches, std::vector<UeId>& failed);
+
+    void clear();
+    size_t getPendingCount() const { return index_.size(); }
+    uint64_t getTickCount() const { return tick_; }
+    const PagingStats& getStats() const { return stats_; }
+
+private:
+    struct Attempt {
+        PagingTarget target;
+        uint64_t deadline;      // Tick the response window closes, 0 until sent
+        uint8_t step;           // Index into strategy_
+    };
+
+    struct Deadline {
+        uint64_t tick;
+        UeId ueId;
+        uint8_t step;
+    };
+
+    struct GnbSlot {
+        GnbId gnbId;
+        Tac tac;
+        uint64_t mark;              // Last send that added a UE here
+        std::vector<Tmsi> tmsis;    // This tick's batch
+    };
+
+    SlabPool<Attempt> pool_;
+    DenseIndex index_;                      // UeId -> attempt
+    std::vector<UeId> due_;                 // To send on the next tick
+    std::deque<Deadline> deadlines_;        // In tick order; windows are equal
+    std::vector<GnbSlot> gnbs_;
+    DenseIndex gnbIndex_;                   // GnbId -> slot
+    std::unordered_map<Tac, std::vector<uint32_t>> taGnbs_;
+    std::vector<std::vector<Tac>> taLists_;  // [0] unused
+    std::vector<uint32_t> touched_;         // Slots with a batch this tick
+    std::vector<PagingScope> strategy_;
+    uint32_t responseTicks_;
+    uint64_t tick_;
+    uint64_t sends_;
+    PagingStats stats_;
+
+    PagingScope scopeOf(const Attempt& attempt, uint8_t step) const;
+    void send(Attempt& attempt);
+    void addToTa(Tac tac, Tmsi tmsi);
+    void addToGnb(uint32_t slot, Tmsi tmsi);
+    void remove(UeId ueId, uint32_t handle);
+};
+
+#endif // PAGING_ENGINE_HPP
@@ -0,0 +1,29 @@
+#include "TmsiAllocator.hpp"
+
+TmsiAllocator::TmsiAllocator(uint64_t seed) : counter_(0), allocated_(0) {
+    for (int round = 0; round < ROUNDS; ++round) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        keys_[round] = static_cast<uint16_t>(seed >> 48);
+    }
+}
+
+Tmsi TmsiAllocator::allocate() {
+    Tmsi tmsi = permute(counter_++);
+    if (tmsi == 0xFFFFFFFF) {
+        tmsi = permute(counter_++);   // Reserved value, at most once per cycle
+    }
+    allocated_++;
+    return tmsi;
+}
+
+uint32_t TmsiAllocator::permute(uint32_t value) const {
+    uint16_t left = static_cast<uint16_t>(value >> 16);
+    uint16_t right = static_cast<uint16_t>(value);
+    for (int round = 0; round < ROUNDS; ++round) {
+        uint32_t mixed = (static_cast<uint32_t>(right ^ keys_[round]) + 0x9E37u) * 0x85EBCA6Bu;
+        uint16_t next = static_cast<uint16_t>(left ^ (mixed >> 16) ^ mixed);
+        left = right;
+        right = next;
+    }
+    return static_cast<uint32_t>(left) << 16 | right;
+}
@@ -0,0 +1,32 @@
+#ifndef TMSI_ALLOCATOR_HPP
+#define TMSI_ALLOCATOR_HPP
+
+#include "../common/Types.hpp"
+#include <cstdint>
+
+// Collision-free 5G-TMSI source.
+//
+// A 32-bit counter is run through a keyed four-round Feistel network. The
+// network is a bijection on 32 bits, so no TMSI repeats until the counter
+// wraps after 2^32 allocations, and no table of issued values is needed.
+// Consecutive TMSIs are unrelated to each other, as TS 33.501 asks for, and
+// the key comes from the seed so restarted AMFs draw different sequences.
+// 0xFFFFFFFF is never returned. Not thread-safe.
+class TmsiAllocator {
+public:
+    explicit TmsiAllocator(uint64_t seed);
+
+    Tmsi allocate();
+    uint64_t getAllocatedCount() const { return allocated_; }
+
+private:
+    static constexpr int ROUNDS = 4;
+
+    uint32_t permute(uint32_t value) const;
+
+    uint16_t keys_[ROUNDS];
+    uint32_t counter_;
+    uint64_t allocated_;
+};
+
+#endif // TMSI_ALLOCATOR_HPP
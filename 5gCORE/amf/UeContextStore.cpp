@@ -0,0 +1,127 @@
+#include "UeContextStore.hpp"
+
+UeContextStore::UeContextStore(size_t expectedUes)
+    : index_(expectedUes), tmsiIndex_(expectedUes), imsiIndex_(expectedUes), counts_() {
+}
+
+UeContextStore::Handle UeContextStore::create(UeId ueId, Imsi imsi) {
+    if (find(ueId) != INVALID_HANDLE || findByImsi(imsi) != INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+
+    Handle handle = pool_.acquire();
+    index_.insert(ueId, handle);
+    imsiIndex_.insert(imsi, handle);
+
+    UeContext& context = pool_.at(handle);
+    context = UeContext();
+    context.ueId = ueId;
+    context.imsi = imsi;
+    context.tmsi = NO_TMSI;
+    setFlag(context, REGISTERED, true);
+    return handle;
+}
+
+UeContextStore::Handle UeContextStore::find(UeId ueId) const {
+    uint32_t handle = index_.find(ueId);
+    return handle == DenseIndex::NOT_FOUND ? INVALID_HANDLE : handle;
+}
+
+UeContextStore::Handle UeContextStore::findByTmsi(Tmsi tmsi) const {
+    uint32_t handle = tmsiIndex_.find(tmsi);
+    return handle == DenseIndex::NOT_FOUND ? INVALID_HANDLE : handle;
+}
+
+UeContextStore::Handle UeContextStore::findByImsi(Imsi imsi) const {
+    uint32_t handle = imsiIndex_.find(imsi);
+    return handle == DenseIndex64::NOT_FOUND ? INVALID_HANDLE : handle;
+}
+
+bool UeContextStore::erase(UeId ueId) {
+    Handle handle = find(ueId);
+    if (handle == INVALID_HANDLE) {
+        return false;
+    }
+
+    UeContext& context = pool_.at(handle);
+    for (size_t bit = 0; bit < FLAG_COUNT; ++bit) {
+        counts_[bit] -= (context.flags >> bit) & 1;
+    }
+    context.flags = 0;
+    index_.erase(ueId);
+    imsiIndex_.erase(context.imsi);
+    if (context.tmsi != NO_TMSI) {
+        tmsiIndex_.erase(context.tmsi);
+    }
+    pool_.release(handle);
+    return true;
+}
+
+bool UeContextStore::assignTmsi(Handle handle, Tmsi tmsi) {
+    if (tmsi == NO_TMSI || !tmsiIndex_.insert(tmsi, handle)) {
+        return false;
+    }
+
+    UeContext& context = pool_.at(handle);
+    if (context.tmsi != NO_TMSI) {
+        tmsiIndex_.erase(context.tmsi);
+    }
+    context.tmsi = tmsi;
+    return true;
+}
+
+bool UeContextStore::changeUeId(Handle handle, UeId ueId) {
+    if (!index_.insert(ueId, handle)) {
+        return false;
+    }
+
+    UeContext& context = pool_.at(handle);
+    index_.erase(context.ueId);
+    context.ueId = ueId;
+    return true;
+}
+
+void UeContextStore::reserve(size_t ues) {
+    pool_.reserve(ues);
+    index_.reserve(ues);
+    tmsiIndex_.reserve(ues);
+    imsiIndex_.reserve(ues);
+}
+
+void UeContextStore::clear() {
+    pool_.clear();
+    index_.clear();
+    tmsiIndex_.clear();
+    imsiIndex_.clear();
+    for (size_t& count : counts_) {
+        count = 0;
+    }
+}
+
+UeContextStore::UeContext* UeContextStore::findContext(UeId ueId) {
+    Handle handle = find(ueId);
+    return handle == INVALID_HANDLE ? nullptr : &pool_.at(handle);
+}
+
+const UeContextStore::UeContext* UeContextStore::findContext(UeId ueId) const {
+    Handle handle = find(ueId);
+    return handle == INVALID_HANDLE ? nullptr : &pool_.at(handle);
+}
+
+void UeContextStore::setFlag(UeContext& context, Flag flag, bool on) {
+    if (context.has(flag) == on) {
+        return;
+    }
+    if (on) {
+        context.flags |= flag;
+        counts_[bitOf(flag)]++;
+    } else {
+        context.flags &= static_cast<uint8_t>(~flag);
+        counts_[bitOf(flag)]--;
+    }
+}
+
+size_t UeContextStore::getMemoryBytes() const {
+    return pool_.getMemoryBytes() + index_.getMemoryBytes() +
+           tmsiIndex_.getMemoryBytes() + imsiIndex_.getMemoryBytes();
+}
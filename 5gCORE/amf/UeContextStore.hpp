@@ -0,0 +1,103 @@
+#ifndef UE_CONTEXT_STORE_HPP
+#define UE_CONTEXT_STORE_HPP
+
+#include "../common/Types.hpp"
+#include "../common/DenseIndex.hpp"
+#include "../common/SlabPool.hpp"
+#include <chrono>
+
+// UE contexts held by the AMF.
+//
+// One fixed-size record per registered UE in a slab pool, found through a
+// DenseIndex keyed by UeId, and through secondary indexes by 5G-TMSI and by
+// IMSI for UEs that identify themselves with a temporary or permanent
+// identity. Connection, authentication, authorization, registration-context
+// and paging state are bits of one flag byte; nothing is allocated per UE.
+// Create, find and erase are O(1). Not thread-safe; the AMF serializes
+// access.
+class UeContextStore {
+public:
+    typedef uint32_t Handle;
+    static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+    static constexpr Tmsi NO_TMSI = 0xFFFFFFFF;
+
+    enum Flag : uint8_t {
+        REGISTERED = 0x01,          // Marks a live record
+        CONNECTED = 0x02,
+        AUTHENTICATED = 0x04,
+        AUTHORIZED = 0x08,
+        REGISTRATION_CONTEXT = 0x10,
+        PAGING = 0x20,
+        UNREACHABLE = 0x40          // Mobile reachable timer expired
+    };
+
+    struct UeContext {
+        Imsi imsi;
+        Imei imei;
+        std::chrono::system_clock::time_point registrationTime;
+        UeId ueId;
+        Tmsi tmsi;                  // NO_TMSI until assigned
+        GnbId connectedGnb;         // 0 = not connected
+        GnbId lastGnb;              // Last known location, kept while idle
+        Tac lastTac;
+        uint16_t taListId;          // Registration area, 0 = last TA alone
+        uint8_t flags;
+
+        bool has(Flag flag) const { return (flags & flag) != 0; }
+    };
+
+    explicit UeContextStore(size_t expectedUes = 1024);
+
+    // INVALID_HANDLE if the UE or the IMSI is already known
+    Handle create(UeId ueId, Imsi imsi);
+    Handle find(UeId ueId) const;
+    Handle findByTmsi(Tmsi tmsi) const;
+    Handle findByImsi(Imsi imsi) const;
+    bool erase(UeId ueId);
+
+    // Re-keying keeps the record; both fail if the new key is taken
+    bool assignTmsi(Handle handle, Tmsi tmsi);
+    bool changeUeId(Handle handle, UeId ueId);
+    void reserve(size_t ues);
+    void clear();
+
+    // Cache hints for batch operations, issued a few UEs ahead
+    void prefetch(UeId ueId) const { index_.prefetch(ueId); }
+    void prefetchContext(Handle handle) const { __builtin_prefetch(&pool_.at(handle), 1); }
+
+    UeContext& at(Handle handle) { return pool_.at(handle); }
+    const UeContext& at(Handle handle) const { return pool_.at(handle); }
+    UeContext* findContext(UeId ueId);
+    const UeContext* findContext(UeId ueId) const;
+
+    // Flag changes go through here so per-flag counts stay O(1)
+    void setFlag(UeContext& context, Flag flag, bool on);
+    size_t count(Flag flag) const { return counts_[bitOf(flag)]; }
+
+    size_t size() const { return index_.size(); }
+    size_t getMemoryBytes() const;
+
+    // Visits live contexts in slot order
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (Handle handle = 0; handle < pool_.getHighWater(); ++handle) {
+            const UeContext& context = pool_.at(handle);
+            if (context.flags & REGISTERED) {
+                visit(context);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t FLAG_COUNT = 8;
+
+    static size_t bitOf(Flag flag) { return static_cast<size_t>(__builtin_ctz(flag)); }
+
+    SlabPool<UeContext> pool_;
+    DenseIndex index_;
+    DenseIndex tmsiIndex_;
+    DenseIndex64 imsiIndex_;
+    size_t counts_[FLAG_COUNT];
+};
+
+#endif // UE_CONTEXT_STORE_HPP
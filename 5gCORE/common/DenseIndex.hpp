@@ -0,0 +1,153 @@
+#ifndef DENSE_INDEX_HPP
+#define DENSE_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash index from an integer key to a 32-bit value
+// (typically a slot handle in a SlabPool).
+//
+// Entries live in one flat power-of-two table, probed linearly, so a lookup
+// is usually a single cache line. Erase uses backward-shift deletion: no
+// tombstones, and probe lengths do not degrade under churn. The table
+// doubles when it passes 7/8 load. The all-ones key is reserved. Not
+// thread-safe.
+template <typename Key>
+class BasicDenseIndex {
+public:
+    static constexpr Key EMPTY_KEY = static_cast<Key>(~static_cast<Key>(0));
+    static constexpr uint32_t NOT_FOUND = 0xFFFFFFFF;
+
+    explicit BasicDenseIndex(size_t expected = 16) : mask_(0), size_(0) {
+        rehash(16);
+        reserve(expected);
+    }
+
+    // false if the key exists
+    bool insert(Key key, uint32_t value) {
+        if ((size_ + 1) * 8 > entries_.size() * 7) {
+            rehash(entries_.size() * 2);
+        }
+
+        size_t position = hash(key) & mask_;
+        while (entries_[position].key != EMPTY_KEY) {
+            if (entries_[position].key == key) {
+                return false;
+            }
+            position = (position + 1) & mask_;
+        }
+
+        entries_[position].key = key;
+        entries_[position].value = value;
+        size_++;
+        return true;
+    }
+
+    // NOT_FOUND if absent
+    uint32_t find(Key key) const {
+        size_t position = hash(key) & mask_;
+        while (entries_[position].key != EMPTY_KEY) {
+            if (entries_[position].key == key) {
+                return entries_[position].value;
+            }
+            position = (position + 1) & mask_;
+        }
+        return NOT_FOUND;
+    }
+
+    // Starts loading the key's home slot; batch callers issue this a few
+    // keys ahead of the find
+    void prefetch(Key key) const { __builtin_prefetch(&entries_[hash(key) & mask_]); }
+
+    bool erase(Key key) {
+        size_t position = hash(key) & mask_;
+        while (entries_[position].key != key) {
+            if (entries_[position].key == EMPTY_KEY) {
+                return false;
+            }
+            position = (position + 1) & mask_;
+        }
+
+        // Shift later members of the cluster back into the hole when their
+        // home slot does not lie cyclically between the hole and their position
+        size_t hole = position;
+        size_t next = (hole + 1) & mask_;
+        while (entries_[next].key != EMPTY_KEY) {
+            size_t home = hash(entries_[next].key) & mask_;
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                entries_[hole] = entries_[next];
+                hole = next;
+            }
+            next = (next + 1) & mask_;
+        }
+
+        entries_[hole].key = EMPTY_KEY;
+        size_--;
+        return true;
+    }
+
+    void reserve(size_t expected) {
+        size_t capacity = entries_.size();
+        while (expected * 8 > capacity * 7) {
+            capacity *= 2;
+        }
+        if (capacity != entries_.size()) {
+            rehash(capacity);
+        }
+    }
+
+    void clear() {
+        for (auto& entry : entries_) {
+            entry.key = EMPTY_KEY;
+        }
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return entries_.size(); }
+    size_t getMemoryBytes() const { return entries_.capacity() * sizeof(Entry); }
+
+private:
+    struct Entry {
+        Key key;
+        uint32_t value;
+    };
+
+    std::vector<Entry> entries_;
+    size_t mask_;
+    size_t size_;
+
+    static size_t hash(Key key) {
+        // Sequential IDs are common: mix so they do not form one long cluster
+        uint64_t h = static_cast<uint64_t>(key);
+        h ^= h >> 32;
+        h *= 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h >> 32);
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Entry> old;
+        old.swap(entries_);
+
+        entries_.assign(capacity, Entry{EMPTY_KEY, 0});
+        mask_ = capacity - 1;
+        size_ = 0;
+
+        for (const auto& entry : old) {
+            if (entry.key != EMPTY_KEY) {
+                size_t position = hash(entry.key) & mask_;
+                while (entries_[position].key != EMPTY_KEY) {
+                    position = (position + 1) & mask_;
+                }
+                entries_[position] = entry;
+                size_++;
+            }
+        }
+    }
+};
+
+typedef BasicDenseIndex<uint32_t> DenseIndex;      // 8-byte entries
+typedef BasicDenseIndex<uint64_t> DenseIndex64;    // 16-byte entries, e.g. IMSI keys
+
+#endif // DENSE_INDEX_HPP
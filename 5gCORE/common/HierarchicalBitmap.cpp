@@ -0,0 +1,91 @@
+#include "HierarchicalBitmap.hpp"
+
+HierarchicalBitmap::HierarchicalBitmap(uint32_t size) : size_(0), used_(0) {
+    reset(size);
+}
+
+void HierarchicalBitmap::reset(uint32_t size) {
+    size_ = size;
+    used_ = 0;
+    levels_.clear();
+
+    // Bits past the end are marked used so the search never returns them
+    uint64_t bits = size;
+    do {
+        uint64_t words = (bits + 63) / 64;
+        std::vector<uint64_t> level(words == 0 ? 1 : words, 0);
+        for (uint64_t bit = bits; bit < level.size() * 64; ++bit) {
+            level[bit >> 6] |= 1ULL << (bit & 63);
+        }
+        if (!levels_.empty()) {
+            // A parent bit is set when its child word is full
+            const std::vector<uint64_t>& child = levels_.back();
+            for (uint64_t word = 0; word < child.size(); ++word) {
+                if (child[word] == ~0ULL) {
+                    level[word >> 6] |= 1ULL << (word & 63);
+                }
+            }
+        }
+        levels_.push_back(level);
+        bits = levels_.back().size();
+    } while (levels_.back().size() > 1);
+}
+
+uint32_t HierarchicalBitmap::findFirstZero() const {
+    uint64_t index = 0;
+    for (size_t level = levels_.size(); level-- > 0;) {
+        uint64_t word = levels_[level][index];
+        if (word == ~0ULL) {
+            return NONE;  // Only possible at the root
+        }
+        index = index * 64 + __builtin_ctzll(~word);
+    }
+    return static_cast<uint32_t>(index);
+}
+
+uint32_t HierarchicalBitmap::acquire() {
+    uint32_t index = findFirstZero();
+    if (index != NONE) {
+        set(index);
+    }
+    return index;
+}
+
+void HierarchicalBitmap::set(uint32_t index) {
+    if (index >= size_ || test(index)) {
+        return;
+    }
+    used_++;
+
+    uint64_t position = index;
+    for (auto& level : levels_) {
+        uint64_t& word = level[position >> 6];
+        word |= 1ULL << (position & 63);
+        if (word != ~0ULL) {
+            break;  // Parent summary unchanged
+        }
+        position >>= 6;
+    }
+}
+
+void HierarchicalBitmap::clear(uint32_t index) {
+    if (index >= size_ || !test(index)) {
+        return;
+    }
+    used_--;
+
+    uint64_t position = index;
+    for (auto& level : levels_) {
+        uint64_t& word = level[position >> 6];
+        bool wasFull = word == ~0ULL;
+        word &= ~(1ULL << (position & 63));
+        if (!wasFull) {
+            break;  // Parent already saw this word as having room
+        }
+        position >>= 6;
+    }
+}
+
+bool HierarchicalBitmap::test(uint32_t index) const {
+    return index < size_ && (levels_[0][index >> 6] >> (index & 63)) & 1;
+}
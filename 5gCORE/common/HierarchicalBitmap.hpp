@@ -0,0 +1,38 @@
+#ifndef HIERARCHICAL_BITMAP_HPP
+#define HIERARCHICAL_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Allocation bitmap with a summary tree on top.
+//
+// Level 0 holds one bit per slot (1 = used). Each bit of level N+1 is set
+// when the corresponding 64-bit word of level N is full, up to a single root
+// word. Finding the first free slot descends one word per level with a
+// count-trailing-zeros, so a 16M-slot bitmap (a /8) is searched in four
+// steps. Set and reset touch one word per level at most. Not thread-safe.
+class HierarchicalBitmap {
+public:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    explicit HierarchicalBitmap(uint32_t size = 0);
+
+    void reset(uint32_t size);
+    uint32_t findFirstZero() const;
+    uint32_t acquire();              // findFirstZero() + set(); NONE when full
+    void set(uint32_t index);
+    void clear(uint32_t index);
+    bool test(uint32_t index) const;
+
+    uint32_t getSize() const { return size_; }
+    uint32_t getUsedCount() const { return used_; }
+    uint32_t getFreeCount() const { return size_ - used_; }
+
+private:
+    std::vector<std::vector<uint64_t>> levels_;  // levels_[0] = leaves
+    uint32_t size_;
+    uint32_t used_;
+};
+
+#endif // HIERARCHICAL_BITMAP_HPP
@@ -6,6 +6,7 @@
 #include <ctime>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
 
 enum class LogLevel {
     DEBUG = 0,
@@ -26,11 +27,17 @@ public:
         currentLevel = level;
     }
 
+    bool isEnabled(LogLevel level) const {
+        return level >= currentLevel;
+    }
+
     void log(LogLevel level, const std::string& component, const std::string& message) {
         if (level < currentLevel) {
             return;
         }
 
+        // NFs may log from their own worker threads
+        std::lock_guard<std::mutex> lock(mutex_);
         auto now = std::time(nullptr);
         auto tm = *std::localtime(&now);
 
@@ -91,6 +98,7 @@ private:
     }
 
     LogLevel currentLevel;
+    std::mutex mutex_;
 };
 
 #endif // LOGGER_HPP
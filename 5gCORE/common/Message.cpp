@@ -1,3 +1,3 @@
 #include "Message.hpp"
 
-uint32_t Message::messageCounter_ = 1000;
+std::atomic<uint32_t> Message::messageCounter_(1000);
@@ -2,15 +2,17 @@
 #define MESSAGE_HPP
 
 #include "Types.hpp"
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <vector>
 
 class Message {
 public:
     Message(MessageType type, uint32_t sourceId, uint32_t destId)
         : type_(type), sourceId_(sourceId), destId_(destId),
           messageId_(++messageCounter_), 
-          timestamp_(std::chrono::system_clock::now()) {}
+          timestamp_(std::chrono::steady_clock::now()) {}
 
     virtual ~Message() = default;
 
@@ -18,7 +20,12 @@ public:
     uint32_t getSourceId() const { return sourceId_; }
     uint32_t getDestId() const { return destId_; }
     uint32_t getMessageId() const { return messageId_; }
-    std::chrono::system_clock::time_point getTimestamp() const { return timestamp_; }
+    // Monotonic: for measuring transit time, not for display
+    std::chrono::steady_clock::time_point getTimestamp() const { return timestamp_; }
+    uint64_t getAgeUs() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - timestamp_).count());
+    }
 
     virtual std::string toString() const = 0;
 
@@ -27,21 +34,22 @@ protected:
     uint32_t sourceId_;
     uint32_t destId_;
     uint32_t messageId_;
-    std::chrono::system_clock::time_point timestamp_;
+    std::chrono::steady_clock::time_point timestamp_;
 
 private:
-    static uint32_t messageCounter_;
+    static std::atomic<uint32_t> messageCounter_;
 };
 
 // Specific Message Types
 class AttachRequestMessage : public Message {
 public:
-    AttachRequestMessage(UeId ueId, uint64_t imsi, uint64_t imei)
+    AttachRequestMessage(UeId ueId, uint64_t imsi, uint64_t imei, GnbId gnbId = 0)
         : Message(MessageType::UE_ATTACH_REQUEST, ueId, 0),
-          imsi_(imsi), imei_(imei) {}
+          imsi_(imsi), imei_(imei), gnbId_(gnbId) {}
 
     uint64_t getImsi() const { return imsi_; }
     uint64_t getImei() const { return imei_; }
+    GnbId getGnbId() const { return gnbId_; }     // Serving gNB, 0 if unknown
 
     std::string toString() const override {
         return "AttachRequest(UE=" + std::to_string(sourceId_) + 
@@ -51,6 +59,7 @@ public:
 private:
     uint64_t imsi_;
     uint64_t imei_;
+    GnbId gnbId_;
 };
 
 class DetachRequestMessage : public Message {
@@ -135,4 +144,131 @@ private:
     uint32_t dataSize_;
 };
 
+class UsageReportMessage : public Message {
+public:
+    explicit UsageReportMessage(std::vector<UsageReport> reports)
+        : Message(MessageType::USAGE_REPORT, 0, 0),
+          reports_(std::move(reports)) {}
+
+    const std::vector<UsageReport>& getReports() const { return reports_; }
+
+    std::string toString() const override {
+        return "UsageReport(Sessions=" + std::to_string(reports_.size()) + ")";
+    }
+
+private:
+    std::vector<UsageReport> reports_;
+};
+
+class DownlinkDataNotificationMessage : public Message {
+public:
+    DownlinkDataNotificationMessage(UeId ueId, SessionId sessionId)
+        : Message(MessageType::DOWNLINK_DATA_NOTIFICATION, ueId, 0),
+          sessionId_(sessionId) {}
+
+    SessionId getSessionId() const { return sessionId_; }
+
+    std::string toString() const override {
+        return "DownlinkDataNotification(UE=" + std::to_string(sourceId_) + 
+               ", Session=" + std::to_string(sessionId_) + ")";
+    }
+
+private:
+    SessionId sessionId_;
+};
+
+// AMF -> gNB: every UE to page in that gNB's cells this paging tick
+class PagingMessage : public Message {
+public:
+    PagingMessage(GnbId gnbId, std::vector<Tmsi> tmsis)
+        : Message(MessageType::PAGING, 0, gnbId),
+          tmsis_(std::move(tmsis)) {}
+
+    const std::vector<Tmsi>& getTmsis() const { return tmsis_; }
+
+    std::string toString() const override {
+        return "Paging(gNB=" + std::to_string(destId_) + 
+               ", UEs=" + std::to_string(tmsis_.size()) + ")";
+    }
+
+private:
+    std::vector<Tmsi> tmsis_;
+};
+
+// Registration procedure: AMF -> UDM -> UDR and back. Each message names
+// the UE it is about, so every NF can keep many registrations in flight.
+class AuthVectorRequestMessage : public Message {
+public:
+    AuthVectorRequestMessage(UeId ueId, Imsi imsi)
+        : Message(MessageType::AUTH_VECTOR_REQUEST, ueId, 0), imsi_(imsi) {}
+
+    Imsi getImsi() const { return imsi_; }
+
+    std::string toString() const override {
+        return "AuthVectorRequest(UE=" + std::to_string(sourceId_) + 
+               ", IMSI=" + std::to_string(imsi_) + ")";
+    }
+
+private:
+    Imsi imsi_;
+};
+
+class AuthVectorResponseMessage : public Message {
+public:
+    AuthVectorResponseMessage(UeId ueId, Imsi imsi, bool authorized, const std::string& challenge)
+        : Message(MessageType::AUTH_VECTOR_RESPONSE, ueId, 0),
+          imsi_(imsi), authorized_(authorized), challenge_(challenge) {}
+
+    Imsi getImsi() const { return imsi_; }
+    bool isAuthorized() const { return authorized_; }
+    const std::string& getChallenge() const { return challenge_; }
+
+    std::string toString() const override {
+        return "AuthVectorResponse(UE=" + std::to_string(sourceId_) + 
+               ", " + (authorized_ ? "OK" : "REJECTED") + ")";
+    }
+
+private:
+    Imsi imsi_;
+    bool authorized_;
+    std::string challenge_;
+};
+
+class SubscriptionDataRequestMessage : public Message {
+public:
+    SubscriptionDataRequestMessage(UeId ueId, Imsi imsi)
+        : Message(MessageType::SUBSCRIPTION_DATA_REQUEST, ueId, 0), imsi_(imsi) {}
+
+    Imsi getImsi() const { return imsi_; }
+
+    std::string toString() const override {
+        return "SubscriptionDataRequest(UE=" + std::to_string(sourceId_) + 
+               ", IMSI=" + std::to_string(imsi_) + ")";
+    }
+
+private:
+    Imsi imsi_;
+};
+
+class SubscriptionDataResponseMessage : public Message {
+public:
+    SubscriptionDataResponseMessage(UeId ueId, Imsi imsi, const SubscriptionData* data)
+        : Message(MessageType::SUBSCRIPTION_DATA_RESPONSE, ueId, 0),
+          imsi_(imsi), found_(data != nullptr), data_(data ? *data : SubscriptionData()) {}
+
+    Imsi getImsi() const { return imsi_; }
+    bool isFound() const { return found_; }
+    const SubscriptionData& getData() const { return data_; }
+
+    std::string toString() const override {
+        return "SubscriptionDataResponse(UE=" + std::to_string(sourceId_) + 
+               ", " + (found_ ? "FOUND" : "NOT_FOUND") + ")";
+    }
+
+private:
+    Imsi imsi_;
+    bool found_;
+    SubscriptionData data_;
+};
+
 #endif // MESSAGE_HPP
@@ -0,0 +1,346 @@
+#include "N4Protocol.hpp"
+
+// Big-endian field writer over a growing buffer
+class N4Writer {
+public:
+    explicit N4Writer(std::vector<uint8_t>& out) : out_(out) {}
+
+    void u8(uint8_t value) { out_.push_back(value); }
+    void u16(uint16_t value) {
+        out_.push_back(static_cast<uint8_t>(value >> 8));
+        out_.push_back(static_cast<uint8_t>(value));
+    }
+    void u32(uint32_t value) {
+        u16(static_cast<uint16_t>(value >> 16));
+        u16(static_cast<uint16_t>(value));
+    }
+    void u64(uint64_t value) {
+        u32(static_cast<uint32_t>(value >> 32));
+        u32(static_cast<uint32_t>(value));
+    }
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Header with the length left open until the body is written
+    size_t beginMessage(N4MessageType type, size_t count, uint32_t sequence) {
+        size_t start = out_.size();
+        u8(N4Codec::VERSION);
+        u8(static_cast<uint8_t>(type));
+        u16(static_cast<uint16_t>(count));
+        u32(0);
+        u32(sequence);
+        return start;
+    }
+
+    void endMessage(size_t start) {
+        uint32_t length = static_cast<uint32_t>(out_.size() - start);
+        for (int i = 0; i < 4; ++i) {
+            out_[start + 4 + i] = static_cast<uint8_t>(length >> (24 - 8 * i));
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+// Bounds-checked reader; any overrun clears ok() and reads return zero
+class N4Reader {
+public:
+    N4Reader(const uint8_t* data, size_t length) : p_(data), end_(data + length), ok_(true) {}
+
+    uint8_t u8() {
+        if (!need(1)) return 0;
+        return *p_++;
+    }
+    uint16_t u16() {
+        if (!need(2)) return 0;
+        uint16_t value = static_cast<uint16_t>(p_[0] << 8 | p_[1]);
+        p_ += 2;
+        return value;
+    }
+    uint32_t u32() {
+        uint32_t high = u16();
+        return high << 16 | u16();
+    }
+    uint64_t u64() {
+        uint64_t high = u32();
+        return high << 32 | u32();
+    }
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok_ = false;  // Longer than any 64-bit value
+        return 0;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    bool need(size_t bytes) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < bytes) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_;
+};
+
+static bool openMessage(const uint8_t* data, size_t length, N4MessageType type,
+                        N4Header& header) {
+    return N4Codec::decodeHeader(data, length, header) && header.type == type;
+}
+
+void N4Codec::encodeSessionRequest(uint32_t sequence, const N4SessionOperation* operations,
+                                   size_t count, std::vector<uint8_t>& out) {
+    N4Writer writer(out);
+    size_t start = writer.beginMessage(N4MessageType::SESSION_REQUEST, count, sequence);
+
+    for (size_t i = 0; i < count; ++i) {
+        const N4SessionOperation& op = operations[i];
+        writer.u8(static_cast<uint8_t>(op.operation));
+        writer.u8(op.fields);
+        writer.u32(op.sessionId);
+        writer.u32(op.ueId);
+
+        if (op.fields & N4_FIELD_QOS) {
+            writer.u32(op.rules.qosRateKbps);
+        }
+        if (op.fields & N4_FIELD_QOS_FLOW) {
+            writer.u8(op.rules.qfi);
+            writer.u8(op.rules.fiveQi);
+            writer.u32(op.rules.priorityLevel);
+        }
+        if (op.fields & N4_FIELD_URR) {
+            writer.u64(op.rules.urrVolumeThreshold);
+            writer.u32(op.rules.urrTimeThresholdMs);
+        }
+        if (op.fields & N4_FIELD_BUFFERING) {
+            writer.u8(op.buffering ? 1 : 0);
+        }
+        if (op.fields & N4_FIELD_PDRS) {
+            writer.u16(static_cast<uint16_t>(op.pdrs.size()));
+            for (const auto& pdr : op.pdrs) {
+                writer.u32(pdr.pdrId);
+                writer.u32(pdr.precedence);
+                writer.u32(pdr.farId);
+                writer.u8(pdr.qfi);
+                writer.u32(pdr.filter.srcIp);
+                writer.u8(pdr.filter.srcPrefixLen);
+                writer.u32(pdr.filter.dstIp);
+                writer.u8(pdr.filter.dstPrefixLen);
+                writer.u16(pdr.filter.srcPortLow);
+                writer.u16(pdr.filter.srcPortHigh);
+                writer.u16(pdr.filter.dstPortLow);
+                writer.u16(pdr.filter.dstPortHigh);
+                writer.u8(pdr.filter.protocol);
+            }
+        }
+    }
+
+    writer.endMessage(start);
+}
+
+void N4Codec::encodeSessionResponse(uint32_t sequence, const N4SessionResult* results,
+                                    size_t count, std::vector<uint8_t>& out) {
+    N4Writer writer(out);
+    size_t start = writer.beginMessage(N4MessageType::SESSION_RESPONSE, count, sequence);
+
+    for (size_t i = 0; i < count; ++i) {
+        writer.u32(results[i].sessionId);
+        writer.u8(static_cast<uint8_t>(results[i].operation));
+        writer.u8(static_cast<uint8_t>(results[i].cause));
+        writer.u32(results[i].teid);
+    }
+
+    writer.endMessage(start);
+}
+
+void N4Codec::encodeUsageReport(uint32_t sequence, const UsageReport* reports,
+                                size_t count, std::vector<uint8_t>& out) {
+    N4Writer writer(out);
+    size_t start = writer.beginMessage(N4MessageType::USAGE_REPORT, count, sequence);
+
+    for (size_t i = 0; i < count; ++i) {
+        writer.u32(reports[i].sessionId);
+        writer.u32(reports[i].ueId);
+        writer.u8(static_cast<uint8_t>(reports[i].trigger));
+        writer.u64(reports[i].ulBytes);
+        writer.u64(reports[i].dlBytes);
+        writer.u32(reports[i].durationMs);
+    }
+
+    writer.endMessage(start);
+}
+
+void N4Codec::encodeCounterDeltas(uint32_t epoch, const CounterDelta* deltas,
+                                  size_t count, std::vector<uint8_t>& out) {
+    N4Writer writer(out);
+    size_t start = writer.beginMessage(N4MessageType::COUNTER_DELTAS, count, epoch);
+
+    for (size_t i = 0; i < count; ++i) {
+        writer.u32(deltas[i].sessionId);
+        writer.varint(deltas[i].ulBytes);
+        writer.varint(deltas[i].dlBytes);
+    }
+
+    writer.endMessage(start);
+}
+
+bool N4Codec::decodeHeader(const uint8_t* data, size_t length, N4Header& header) {
+    N4Reader reader(data, length);
+    header.version = reader.u8();
+    header.type = static_cast<N4MessageType>(reader.u8());
+    header.count = reader.u16();
+    header.length = reader.u32();
+    header.sequence = reader.u32();
+    return reader.ok() && header.version == VERSION &&
+           header.length >= HEADER_SIZE && header.length <= length;
+}
+
+bool N4Codec::decodeSessionRequest(const uint8_t* data, size_t length,
+                                   std::vector<N4SessionOperation>& operations) {
+    N4Header header;
+    if (!openMessage(data, length, N4MessageType::SESSION_REQUEST, header)) {
+        return false;
+    }
+
+    N4Reader reader(data + HEADER_SIZE, header.length - HEADER_SIZE);
+    operations.resize(header.count);
+    for (N4SessionOperation& op : operations) {
+        op.operation = static_cast<N4Operation>(reader.u8());
+        op.fields = reader.u8();
+        op.sessionId = reader.u32();
+        op.ueId = reader.u32();
+        op.rules = N4SessionRules();
+        op.buffering = false;
+        op.pdrs.clear();
+
+        if (op.fields & N4_FIELD_QOS) {
+            op.rules.qosRateKbps = reader.u32();
+        }
+        if (op.fields & N4_FIELD_QOS_FLOW) {
+            op.rules.qfi = reader.u8();
+            op.rules.fiveQi = reader.u8();
+            op.rules.priorityLevel = reader.u32();
+        }
+        if (op.fields & N4_FIELD_URR) {
+            op.rules.urrVolumeThreshold = reader.u64();
+            op.rules.urrTimeThresholdMs = reader.u32();
+        }
+        if (op.fields & N4_FIELD_BUFFERING) {
+            op.buffering = reader.u8() != 0;
+        }
+        if (op.fields & N4_FIELD_PDRS) {
+            op.pdrs.resize(reader.u16());
+            for (auto& pdr : op.pdrs) {
+                pdr.pdrId = reader.u32();
+                pdr.precedence = reader.u32();
+                pdr.farId = reader.u32();
+                pdr.qfi = reader.u8();
+                pdr.filter.srcIp = reader.u32();
+                pdr.filter.srcPrefixLen = reader.u8();
+                pdr.filter.dstIp = reader.u32();
+                pdr.filter.dstPrefixLen = reader.u8();
+                pdr.filter.srcPortLow = reader.u16();
+                pdr.filter.srcPortHigh = reader.u16();
+                pdr.filter.dstPortLow = reader.u16();
+                pdr.filter.dstPortHigh = reader.u16();
+                pdr.filter.protocol = reader.u8();
+            }
+        }
+        if (!reader.ok()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool N4Codec::decodeSessionResponse(const uint8_t* data, size_t length,
+                                    std::vector<N4SessionResult>& results) {
+    N4Header header;
+    if (!openMessage(data, length, N4MessageType::SESSION_RESPONSE, header)) {
+        return false;
+    }
+
+    N4Reader reader(data + HEADER_SIZE, header.length - HEADER_SIZE);
+    results.resize(header.count);
+    for (N4SessionResult& result : results) {
+        result.sessionId = reader.u32();
+        result.operation = static_cast<N4Operation>(reader.u8());
+        result.cause = static_cast<N4Cause>(reader.u8());
+        result.teid = reader.u32();
+    }
+    return reader.ok();
+}
+
+bool N4Codec::decodeUsageReport(const uint8_t* data, size_t length,
+                                std::vector<UsageReport>& reports) {
+    N4Header header;
+    if (!openMessage(data, length, N4MessageType::USAGE_REPORT, header)) {
+        return false;
+    }
+
+    N4Reader reader(data + HEADER_SIZE, header.length - HEADER_SIZE);
+    reports.resize(header.count);
+    for (UsageReport& report : reports) {
+        report.sessionId = reader.u32();
+        report.ueId = reader.u32();
+        report.trigger = static_cast<UsageReportTrigger>(reader.u8());
+        report.ulBytes = reader.u64();
+        report.dlBytes = reader.u64();
+        report.durationMs = reader.u32();
+    }
+    return reader.ok();
+}
+
+bool N4Codec::decodeCounterDeltas(const uint8_t* data, size_t length,
+                                  std::vector<CounterDelta>& deltas) {
+    N4Header header;
+    if (!openMessage(data, length, N4MessageType::COUNTER_DELTAS, header)) {
+        return false;
+    }
+
+    N4Reader reader(data + HEADER_SIZE, header.length - HEADER_SIZE);
+    deltas.resize(header.count);
+    for (CounterDelta& delta : deltas) {
+        delta.sessionId = reader.u32();
+        delta.ulBytes = reader.varint();
+        delta.dlBytes = reader.varint();
+    }
+    return reader.ok();
+}
+
+const char* N4Codec::toString(N4Operation operation) {
+    switch (operation) {
+        case N4Operation::ESTABLISH: return "ESTABLISH";
+        case N4Operation::MODIFY: return "MODIFY";
+        case N4Operation::DELETE: return "DELETE";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* N4Codec::toString(N4Cause cause) {
+    switch (cause) {
+        case N4Cause::ACCEPTED: return "ACCEPTED";
+        case N4Cause::SESSION_NOT_FOUND: return "SESSION_NOT_FOUND";
+        case N4Cause::SESSION_EXISTS: return "SESSION_EXISTS";
+        case N4Cause::INVALID_RULE: return "INVALID_RULE";
+        default: return "UNKNOWN";
+    }
+}
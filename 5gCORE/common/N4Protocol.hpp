@@ -0,0 +1,116 @@
+#ifndef N4_PROTOCOL_HPP
+#define N4_PROTOCOL_HPP
+
+#include "Types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// PFCP-style N4 messages between SMF and UPF.
+//
+// One message carries a bundle of session operations (establish, modify,
+// delete), their results, or a batch of usage reports. Every message has a
+// 12-byte header with a sequence number; the response to a request echoes
+// it, so the SMF can keep several requests in flight and match responses in
+// any order. Fields are encoded in network byte order. Optional parts of an
+// operation are announced by bits in its field mask, so a modification only
+// carries what changed.
+enum class N4MessageType : uint8_t {
+    SESSION_REQUEST = 1,     // SMF -> UPF
+    SESSION_RESPONSE = 2,    // UPF -> SMF
+    USAGE_REPORT = 3,        // UPF -> SMF
+    COUNTER_DELTAS = 4       // UPF -> SMF, sequence = counter epoch
+};
+
+enum class N4Operation : uint8_t {
+    ESTABLISH = 1,
+    MODIFY = 2,
+    DELETE = 3
+};
+
+enum class N4Cause : uint8_t {
+    ACCEPTED = 1,
+    SESSION_NOT_FOUND = 2,
+    SESSION_EXISTS = 3,
+    INVALID_RULE = 4
+};
+
+// Field mask bits of an N4 session operation
+constexpr uint8_t N4_FIELD_QOS = 0x01;         // Session AMBR
+constexpr uint8_t N4_FIELD_QOS_FLOW = 0x02;    // Default QoS flow
+constexpr uint8_t N4_FIELD_URR = 0x04;         // Usage reporting thresholds
+constexpr uint8_t N4_FIELD_BUFFERING = 0x08;   // Downlink buffering on/off
+constexpr uint8_t N4_FIELD_PDRS = 0x10;        // Replaces the session's PDRs
+
+// User-plane rules the SMF provisions with a session
+struct N4SessionRules {
+    uint32_t qosRateKbps;
+    uint8_t qfi;
+    uint8_t fiveQi;
+    uint32_t priorityLevel;
+    uint64_t urrVolumeThreshold;
+    uint32_t urrTimeThresholdMs;
+};
+
+struct N4SessionOperation {
+    N4Operation operation;
+    uint8_t fields;              // N4_FIELD_* present below
+    SessionId sessionId;
+    UeId ueId;
+    N4SessionRules rules;
+    bool buffering;
+    std::vector<PacketDetectionRule> pdrs;
+};
+
+struct N4SessionResult {
+    SessionId sessionId;
+    N4Operation operation;
+    N4Cause cause;
+    uint32_t teid;               // UPF-assigned tunnel ID on establishment
+};
+
+struct N4Header {
+    uint8_t version;
+    N4MessageType type;
+    uint16_t count;              // Entries in the bundle
+    uint32_t length;             // Whole message, header included
+    uint32_t sequence;
+};
+
+// Transport hook: each NF hands encoded messages to its peer through one
+typedef std::function<void(const uint8_t* data, size_t length)> N4Sender;
+
+class N4Codec {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 12;
+    static constexpr size_t MAX_BUNDLE = 0xFFFF;
+
+    // Encoders append one message to out
+    static void encodeSessionRequest(uint32_t sequence, const N4SessionOperation* operations,
+                                     size_t count, std::vector<uint8_t>& out);
+    static void encodeSessionResponse(uint32_t sequence, const N4SessionResult* results,
+                                      size_t count, std::vector<uint8_t>& out);
+    static void encodeUsageReport(uint32_t sequence, const UsageReport* reports,
+                                  size_t count, std::vector<uint8_t>& out);
+    // Byte counts are varints: a typical delta costs 6-12 bytes
+    static void encodeCounterDeltas(uint32_t epoch, const CounterDelta* deltas,
+                                    size_t count, std::vector<uint8_t>& out);
+
+    // Decoders reject truncated or mistyped messages
+    static bool decodeHeader(const uint8_t* data, size_t length, N4Header& header);
+    static bool decodeSessionRequest(const uint8_t* data, size_t length,
+                                     std::vector<N4SessionOperation>& operations);
+    static bool decodeSessionResponse(const uint8_t* data, size_t length,
+                                      std::vector<N4SessionResult>& results);
+    static bool decodeUsageReport(const uint8_t* data, size_t length,
+                                  std::vector<UsageReport>& reports);
+    static bool decodeCounterDeltas(const uint8_t* data, size_t length,
+                                    std::vector<CounterDelta>& deltas);
+
+    static const char* toString(N4Operation operation);
+    static const char* toString(N4Cause cause);
+};
+
+#endif // N4_PROTOCOL_HPP
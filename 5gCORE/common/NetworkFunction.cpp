@@ -1,3 +1,66 @@
 #include "NetworkFunction.hpp"
 
 uint32_t NetworkFunction::idCounter_ = 1;
+
+void NetworkFunction::startWorker() {
+    if (worker_.joinable()) {
+        return;
+    }
+    stopWorker_ = false;
+    worker_ = std::thread([this]() {
+        std::queue<std::shared_ptr<Message>> batch;
+        for (;;) {
+            {
+                // Take everything queued under one lock acquisition
+                std::unique_lock<std::mutex> lock(messageMutex_);
+                cv_.wait(lock, [this] { return !messageQueue_.empty() || stopWorker_; });
+                if (messageQueue_.empty()) {
+                    return;
+                }
+                batch.swap(messageQueue_);
+            }
+            dispatch(batch);
+        }
+    });
+}
+
+void NetworkFunction::stopWorker() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(messageMutex_);
+        stopWorker_ = true;
+    }
+    cv_.notify_one();
+    worker_.join();     // Drains what is already queued first
+}
+
+size_t NetworkFunction::processMessages() {
+    size_t handled = 0;
+    std::queue<std::shared_ptr<Message>> batch;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(messageMutex_);
+            if (messageQueue_.empty()) {
+                return handled;
+            }
+            batch.swap(messageQueue_);
+        }
+        handled += batch.size();
+        dispatch(batch);
+    }
+}
+
+void NetworkFunction::dispatch(std::queue<std::shared_ptr<Message>>& batch) {
+    while (!batch.empty()) {
+        std::shared_ptr<Message> message = std::move(batch.front());
+        batch.pop();
+        uint64_t ageUs = message->getAgeUs();
+        {
+            std::lock_guard<std::mutex> lock(latencyMutex_);
+            messageLatency_[static_cast<size_t>(message->getType())].record(ageUs);
+        }
+        handleMessage(message);
+    }
+}
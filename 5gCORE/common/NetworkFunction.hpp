@@ -10,11 +10,18 @@
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#include <functional>
+
+// Transport hook: an NF hands messages for a peer NF to one of these
+typedef std::function<void(std::shared_ptr<Message>)> MessageSender;
 
 class NetworkFunction {
 public:
+    static constexpr size_t MESSAGE_TYPE_COUNT = static_cast<size_t>(MessageType::ERROR) + 1;
+    static constexpr size_t NF_TYPE_COUNT = static_cast<size_t>(NFType::RAN) + 1;
+
     explicit NetworkFunction(NFType type, const std::string& name)
-        : type_(type), name_(name), isRunning_(false) {
+        : type_(type), name_(name), isRunning_(false), stopWorker_(false), messageLatency_() {
         instanceId_ = std::to_string(idCounter_++);
     }
 
@@ -22,6 +29,7 @@ public:
         if (isRunning_) {
             stop();
         }
+        stopWorker();
     }
 
     NFType getType() const { return type_; }
@@ -35,10 +43,34 @@ public:
     }
 
     virtual void stop() {
+        stopWorker();
         isRunning_ = false;
         Logger::getInstance().info(name_, "Network Function stopped");
     }
 
+    void setMessageSender(NFType peer, MessageSender sender) {
+        senders_[static_cast<size_t>(peer)] = std::move(sender);
+    }
+    bool hasMessageSender(NFType peer) const {
+        return static_cast<bool>(senders_[static_cast<size_t>(peer)]);
+    }
+
+    // Queued messages are handled either by a worker thread of this NF or
+    // by whoever calls processMessages; not both at once. While the worker
+    // runs, only message handlers touch the NF's state. The worker must
+    // be stopped before a derived NF is destroyed; stop() does that.
+    void startWorker();
+    void stopWorker();
+    size_t processMessages();
+    bool isWorkerRunning() const { return worker_.joinable(); }
+
+    // Queueing plus transit time of handled messages, by type; safe to
+    // read while the worker runs
+    LatencyStats getMessageLatency(MessageType type) const {
+        std::lock_guard<std::mutex> lock(latencyMutex_);
+        return messageLatency_[static_cast<size_t>(type)];
+    }
+
     virtual void handleMessage(std::shared_ptr<Message> message) = 0;
 
     void enqueueMessage(std::shared_ptr<Message> message) {
@@ -76,6 +108,22 @@ protected:
     std::queue<std::shared_ptr<Message>> messageQueue_;
     std::mutex messageMutex_;
     std::condition_variable cv_;
+    std::thread worker_;
+    bool stopWorker_;
+    MessageSender senders_[NF_TYPE_COUNT];
+    mutable std::mutex latencyMutex_;
+    LatencyStats messageLatency_[MESSAGE_TYPE_COUNT];
+
+    bool send(NFType peer, std::shared_ptr<Message> message) {
+        const MessageSender& sender = senders_[static_cast<size_t>(peer)];
+        if (!sender) {
+            return false;
+        }
+        sender(std::move(message));
+        return true;
+    }
+
+    void dispatch(std::queue<std::shared_ptr<Message>>& batch);
 
     static uint32_t idCounter_;
 
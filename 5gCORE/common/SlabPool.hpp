@@ -0,0 +1,67 @@
+#ifndef SLAB_POOL_HPP
+#define SLAB_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Fixed-size object pool addressed by 32-bit handles.
+//
+// Objects live in slabs of 2^SLAB_BITS elements that are allocated on demand
+// and never move, so handles and references stay valid while the pool grows.
+// Released handles are kept on a free stack and reused first. The pool does
+// not track liveness; owners mark released objects themselves if they need
+// to iterate. Not thread-safe.
+template <typename T, uint32_t SLAB_BITS = 12>
+class SlabPool {
+public:
+    static constexpr uint32_t INVALID_HANDLE = 0xFFFFFFFF;
+    static constexpr uint32_t SLAB_SIZE = 1u << SLAB_BITS;
+
+    SlabPool() : next_(0) {}
+
+    uint32_t acquire() {
+        if (!free_.empty()) {
+            uint32_t handle = free_.back();
+            free_.pop_back();
+            return handle;
+        }
+        if (next_ == slabs_.size() * SLAB_SIZE) {
+            slabs_.emplace_back(new T[SLAB_SIZE]());
+        }
+        return next_++;
+    }
+
+    void release(uint32_t handle) { free_.push_back(handle); }
+
+    T& at(uint32_t handle) { return slabs_[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)]; }
+    const T& at(uint32_t handle) const { return slabs_[handle >> SLAB_BITS][handle & (SLAB_SIZE - 1)]; }
+
+    void reserve(size_t count) {
+        while (slabs_.size() * SLAB_SIZE < count) {
+            slabs_.emplace_back(new T[SLAB_SIZE]());
+        }
+        free_.reserve(count);
+    }
+
+    void clear() {
+        slabs_.clear();
+        free_.clear();
+        next_ = 0;
+    }
+
+    // Handles ever handed out; live objects are a subset
+    uint32_t getHighWater() const { return next_; }
+    size_t getLiveCount() const { return next_ - free_.size(); }
+    size_t getMemoryBytes() const {
+        return slabs_.size() * SLAB_SIZE * sizeof(T) + free_.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> slabs_;
+    std::vector<uint32_t> free_;
+    uint32_t next_;
+};
+
+#endif // SLAB_POOL_HPP
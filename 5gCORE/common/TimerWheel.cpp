@@ -0,0 +1,120 @@
+#include "TimerWheel.hpp"
+
+TimerWheel::TimerWheel(uint64_t startTick) : current_(startTick), armed_(0) {
+    for (uint32_t& head : heads_) {
+        head = NONE;
+    }
+}
+
+void TimerWheel::schedule(uint32_t id, uint64_t expiryTick) {
+    if (id >= nodes_.size()) {
+        nodes_.resize(static_cast<size_t>(id) + 1, Node{0, NONE, NONE, NO_SLOT});
+    }
+    if (isArmed(id)) {
+        unlink(id);
+    } else {
+        armed_++;
+    }
+
+    nodes_[id].expiry = expiryTick > current_ ? expiryTick : current_ + 1;
+    place(id);
+}
+
+bool TimerWheel::cancel(uint32_t id) {
+    if (!isArmed(id)) {
+        return false;
+    }
+    unlink(id);
+    nodes_[id].slot = NO_SLOT;
+    armed_--;
+    return true;
+}
+
+size_t TimerWheel::advance(uint64_t now, std::vector<uint32_t>& expired) {
+    size_t before = expired.size();
+    while (current_ < now) {
+        if (armed_ == 0) {
+            current_ = now;     // Nothing to move or fire on the way
+            break;
+        }
+        current_++;
+
+        // Coarser slots that come due at this tick move down first, the
+        // coarsest first, so their timers can land in this tick's slot
+        uint32_t due = 0;
+        while (due + 1 < LEVELS && (current_ & ((1ULL << (SLOT_BITS * (due + 1))) - 1)) == 0) {
+            due++;
+        }
+        for (uint32_t level = due; level > 0; --level) {
+            cascade(level);
+        }
+
+        uint16_t slot = static_cast<uint16_t>(current_ & (SLOTS - 1));
+        while (heads_[slot] != NONE) {
+            uint32_t id = heads_[slot];
+            unlink(id);
+            nodes_[id].slot = NO_SLOT;
+            armed_--;
+            expired.push_back(id);
+        }
+    }
+    return expired.size() - before;
+}
+
+void TimerWheel::clear() {
+    nodes_.clear();
+    for (uint32_t& head : heads_) {
+        head = NONE;
+    }
+    armed_ = 0;
+}
+
+void TimerWheel::place(uint32_t id) {
+    uint64_t expiry = nodes_[id].expiry;
+    uint64_t delta = expiry - current_;
+    for (uint32_t level = 0; level < LEVELS; ++level) {
+        if (delta < (1ULL << (SLOT_BITS * (level + 1)))) {
+            link(id, static_cast<uint16_t>(level * SLOTS + ((expiry >> (SLOT_BITS * level)) & (SLOTS - 1))));
+            return;
+        }
+    }
+
+    // Beyond the wheel: park at its far edge and re-place from there
+    uint64_t edge = current_ + (1ULL << (SLOT_BITS * LEVELS)) - 1;
+    uint32_t top = LEVELS - 1;
+    link(id, static_cast<uint16_t>(top * SLOTS + ((edge >> (SLOT_BITS * top)) & (SLOTS - 1))));
+}
+
+void TimerWheel::link(uint32_t id, uint16_t slot) {
+    Node& node = nodes_[id];
+    node.prev = NONE;
+    node.next = heads_[slot];
+    node.slot = slot;
+    if (node.next != NONE) {
+        nodes_[node.next].prev = id;
+    }
+    heads_[slot] = id;
+}
+
+void TimerWheel::unlink(uint32_t id) {
+    Node& node = nodes_[id];
+    if (node.prev != NONE) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+    }
+    if (node.next != NONE) {
+        nodes_[node.next].prev = node.prev;
+    }
+}
+
+void TimerWheel::cascade(uint32_t level) {
+    uint16_t slot = static_cast<uint16_t>(level * SLOTS + ((current_ >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    uint32_t id = heads_[slot];
+    heads_[slot] = NONE;
+    while (id != NONE) {
+        uint32_t next = nodes_[id].next;
+        place(id);
+        id = next;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel for long-lived protocol timers.
+//
+// Timers are identified by a small dense ID chosen by the owner (typically
+// a SlabPool handle), one timer per ID. LEVELS wheels of 64 slots each
+// cover 64, 64^2, ... ticks ahead; a timer sits in the slot of the coarsest
+// level it needs and moves down a level when that slot comes due, so it is
+// touched at most LEVELS times. Slots are intrusive doubly-linked lists
+// threaded through a per-ID node array: schedule, reschedule and cancel are
+// O(1), and advancing costs O(ticks + timers moved or expired), never a
+// walk over every armed timer. Timers further out than the wheel spans are
+// parked in the top level and re-placed when it comes around. Not
+// thread-safe.
+class TimerWheel {
+public:
+    static constexpr uint32_t LEVELS = 4;
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+
+    explicit TimerWheel(uint64_t startTick = 0);
+
+    // (Re)arms the timer of id; an expiry not after the current tick fires
+    // on the next one
+    void schedule(uint32_t id, uint64_t expiryTick);
+    bool cancel(uint32_t id);
+    bool isArmed(uint32_t id) const { return id < nodes_.size() && nodes_[id].slot != NO_SLOT; }
+    uint64_t getExpiry(uint32_t id) const { return nodes_[id].expiry; }
+
+    // Moves time forward to now and appends the IDs that expired, in expiry
+    // order. Expired timers are disarmed before they are reported.
+    size_t advance(uint64_t now, std::vector<uint32_t>& expired);
+
+    uint64_t getCurrentTick() const { return current_; }
+    size_t size() const { return armed_; }
+    size_t getMemoryBytes() const { return nodes_.capacity() * sizeof(Node); }
+    void reserve(size_t ids) { nodes_.reserve(ids); }
+    void clear();
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+    static constexpr uint16_t NO_SLOT = 0xFFFF;
+
+    struct Node {
+        uint64_t expiry;
+        uint32_t prev;
+        uint32_t next;
+        uint16_t slot;          // level * SLOTS + index, NO_SLOT when disarmed
+    };
+
+    std::vector<Node> nodes_;
+    uint32_t heads_[LEVELS * SLOTS];
+    uint64_t current_;
+    size_t armed_;
+
+    void place(uint32_t id);
+    void link(uint32_t id, uint16_t slot);
+    void unlink(uint32_t id);
+    void cascade(uint32_t level);
+};
+
+#endif // TIMER_WHEEL_HPP
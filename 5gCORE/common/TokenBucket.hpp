@@ -0,0 +1,62 @@
+#ifndef TOKEN_BUCKET_HPP
+#define TOKEN_BUCKET_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Token bucket rate limiter on an explicit clock.
+//
+// Tokens accrue at rate per second up to burst. Callers pass the current
+// time, so the same bucket serves wall-clock admission and simulated time in
+// benchmarks. A rate of 0 means unlimited. Not thread-safe.
+class TokenBucket {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    TokenBucket() : rate_(0), burst_(0), tokens_(0) {}
+
+    void configure(double ratePerSecond, double burst, Clock::time_point now) {
+        rate_ = ratePerSecond;
+        burst_ = std::max(burst, 1.0);
+        tokens_ = burst_;
+        last_ = now;
+    }
+
+    bool isUnlimited() const { return rate_ <= 0; }
+    double getRate() const { return rate_; }
+
+    void refill(Clock::time_point now) {
+        if (isUnlimited() || now <= last_) {
+            return;
+        }
+        double elapsed = std::chrono::duration<double>(now - last_).count();
+        tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+        last_ = now;
+    }
+
+    // Call refill() first; split so two buckets can be checked before
+    // either is charged
+    bool hasToken() const { return isUnlimited() || tokens_ >= 1.0; }
+    void take() {
+        if (!isUnlimited()) {
+            tokens_ -= 1.0;
+        }
+    }
+
+    // Time until the next token, 0 when one is available
+    uint32_t getWaitMs() const {
+        if (hasToken()) {
+            return 0;
+        }
+        return static_cast<uint32_t>((1.0 - tokens_) * 1000.0 / rate_) + 1;
+    }
+
+private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    Clock::time_point last_;
+};
+
+#endif // TOKEN_BUCKET_HPP
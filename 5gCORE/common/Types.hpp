@@ -14,6 +14,9 @@ typedef uint32_t SessionId;
 typedef uint64_t Imsi;
 typedef uint64_t Imei;
 typedef uint32_t Snssai;  // Single Network Slice Selection Assistance Info
+typedef uint16_t AppId;   // Application detected by the UPF (0 = unknown)
+typedef uint32_t Tmsi;    // 5G-TMSI, AMF-assigned temporary identity
+typedef uint32_t Tac;     // Tracking Area Code (24 bits)
 
 // State Enumerations
 enum class UeState {
@@ -31,7 +34,7 @@ enum class GnbState {
     UNAVAILABLE
 };
 
-enum class SessionState {
+enum class SessionState : uint8_t {
     IDLE,
     ACTIVATING,
     ACTIVE,
@@ -58,6 +61,13 @@ enum class MessageType {
     PDU_SESSION_RELEASE_REQUEST,
     PDU_SESSION_RELEASE_COMPLETE,
     DATA_TRANSFER,
+    USAGE_REPORT,
+    DOWNLINK_DATA_NOTIFICATION,
+    PAGING,
+    AUTH_VECTOR_REQUEST,           // AMF -> UDM (Nudm_UEAuthentication_Get)
+    AUTH_VECTOR_RESPONSE,
+    SUBSCRIPTION_DATA_REQUEST,     // UDM -> UDR (Nudr_DM_Query)
+    SUBSCRIPTION_DATA_RESPONSE,
     HEARTBEAT,
     ERROR
 };
@@ -93,6 +103,20 @@ struct SubscriptionData {
     std::map<std::string, std::string> additionalData;
 };
 
+// Time messages of one kind spent between creation and handling
+struct LatencyStats {
+    uint64_t count;
+    uint64_t totalUs;
+    uint64_t maxUs;
+
+    void record(uint64_t us) {
+        count++;
+        totalUs += us;
+        maxUs = us > maxUs ? us : maxUs;
+    }
+    double averageUs() const { return count ? static_cast<double>(totalUs) / count : 0.0; }
+};
+
 struct S1apMessage {
     MessageType type;
     UeId ueId;
@@ -108,12 +132,20 @@ struct NgapMessage {
 };
 
 // Common utility structures
+// Planar position in metres from the simulation origin
+struct Position {
+    float x;
+    float y;
+};
+
 struct CellInfo {
     uint32_t cellId;
     uint32_t pci;          // Physical Cell ID
     uint32_t frequency;    // Frequency in MHz
     float rsrp;            // Reference Signal Received Power
     float rsrq;            // Reference Signal Received Quality
+    Tac tac;               // Tracking area the cell belongs to
+    Position position;     // Site of the cell
 };
 
 struct PduSessionContext {
@@ -128,11 +160,106 @@ struct PduSessionContext {
     uint64_t dlTraffic;
 };
 
+// Globally unique AMF identifier (TS 23.003 2.10.1)
+struct Guami {
+    uint16_t mcc;
+    uint16_t mnc;
+    uint8_t amfRegionId;
+    uint16_t amfSetId;       // 10 bits
+    uint8_t amfPointer;      // 6 bits
+};
+
+// 5G-GUTI = GUAMI + 5G-TMSI
+struct Guti {
+    Guami guami;
+    Tmsi tmsi;
+};
+
+struct PduSessionRequest {
+    UeId ueId;
+    std::string dnn;
+    Snssai snssai;
+};
+
+// Packet detection structures
+struct FiveTuple {
+    uint32_t srcIp;
+    uint32_t dstIp;
+    uint16_t srcPort;
+    uint16_t dstPort;
+    uint8_t protocol;  // IANA protocol number (6 = TCP, 17 = UDP)
+};
+
+struct SdfFilter {
+    uint32_t srcIp;
+    uint8_t srcPrefixLen;   // 0 matches any source
+    uint32_t dstIp;
+    uint8_t dstPrefixLen;   // 0 matches any destination
+    uint16_t srcPortLow;
+    uint16_t srcPortHigh;
+    uint16_t dstPortLow;
+    uint16_t dstPortHigh;
+    uint8_t protocol;       // 0 matches any protocol
+};
+
+struct PacketDetectionRule {
+    uint32_t pdrId;
+    uint32_t precedence;    // Lower value wins, as in PFCP
+    SdfFilter filter;
+    uint32_t farId;         // Forwarding Action Rule
+    uint8_t qfi;            // QoS Flow Identifier
+};
+
+// Usage reporting (URR) structures
+enum class UsageReportTrigger {
+    VOLUME_THRESHOLD,  // Session volume crossed its threshold
+    TIME_THRESHOLD,    // Reporting period of the session ended
+    TERMINATION        // Session detached with unreported usage
+};
+
+struct UsageReport {
+    SessionId sessionId;
+    UeId ueId;
+    UsageReportTrigger trigger;
+    uint64_t ulBytes;
+    uint64_t dlBytes;
+    uint32_t durationMs;   // Length of the measurement period
+};
+
+// Per-session counter change since the previous sync epoch
+struct CounterDelta {
+    SessionId sessionId;
+    uint64_t ulBytes;
+    uint64_t dlBytes;
+};
+
+// Application detection structures
+struct ApplicationUsage {
+    SessionId sessionId;
+    UeId ueId;
+    AppId appId;
+    uint64_t bytes;        // Since the last collection
+};
+
 // Helper constants
 constexpr uint16_t DEFAULT_SCTP_PORT = 132;
 constexpr uint16_t DEFAULT_HTTP2_PORT = 8080;
 constexpr uint32_t MAX_UES = 10000;
 constexpr uint32_t MAX_GNBS = 100;
 constexpr uint32_t MAX_SESSIONS = 50000;
+constexpr uint32_t MAX_PDU_SESSIONS_PER_UE = 15;        // PDU Session IDs 1-15 (TS 24.007)
+constexpr uint64_t DEFAULT_URR_VOLUME_THRESHOLD = 10 * 1024 * 1024;  // 10 MB
+constexpr uint32_t DEFAULT_URR_TIME_THRESHOLD_MS = 60000;            // 60 s
+constexpr uint32_t DL_BUFFER_POOL_SIZE = 65536;        // Buffered DL packets per UPF
+constexpr uint32_t MAX_DL_BUFFERED_PER_SESSION = 64;   // Buffered DL packets per session
+constexpr uint32_t FLOW_CACHE_CAPACITY = 65536;        // Cached flows per UPF worker
+constexpr uint32_t FLOW_CACHE_IDLE_TIMEOUT_SEC = 30;
+constexpr uint32_t EGRESS_QUEUE_CAPACITY = 65536;      // Queued DL packets per UPF
+constexpr uint8_t DEFAULT_QFI = 9;                     // Default QoS flow (5QI 9)
+constexpr uint8_t DEFAULT_FIVE_QI = 9;                 // Non-GBR best effort
+constexpr AppId APP_UNKNOWN = 0;
+constexpr const char* DEFAULT_DNN = "internet";
+constexpr Tac DEFAULT_TAC = 1;
+constexpr uint8_t APP_DETECTION_MAX_PACKETS = 4;       // Inspected packets per flow
 
 #endif // TYPES_HPP
@@ -0,0 +1,1942 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <sstream>
+#include <cmath>
+
+// Common headers
+#include "common/Types.hpp"
+#include "common/Logger.hpp"
+
+// Component headers
+#include "upf/PacketClassifier.hpp"
+#include "upf/QosScheduler.hpp"
+#include "upf/AppDetector.hpp"
+#include "upf/UPF.hpp"
+#include "amf/AMF.hpp"
+#include "udm/UDM.hpp"
+#include "udr/UDR.hpp"
+#include "ran/GNodeB.hpp"
+#include "ran/RadioPropagation.hpp"
+#include "ran/SpatialGrid.hpp"
+#include "smf/IpPool.hpp"
+#include "smf/SMF.hpp"
+#include "smf/SessionIdAllocator.hpp"
+
+class FiveGBenchmark {
+public:
+    FiveGBenchmark() : rng_(42) {}
+
+    void runClassifierBenchmark() {
+        printHeader("UPF SDF Classifier (tuple-space search vs linear scan)");
+
+        for (uint32_t ruleCount : {16u, 256u, 1000u, 4000u}) {
+            std::vector<PacketDetectionRule> rules = generateRuleSet(ruleCount);
+            std::vector<FiveTuple> packets = generatePackets(rules, 200000);
+
+            PacketClassifier classifier;
+            auto compileStart = std::chrono::steady_clock::now();
+            classifier.compile(rules);
+            double compileMs = elapsedMs(compileStart);
+
+            // Validate against the reference implementation
+            size_t mismatches = 0;
+            for (size_t i = 0; i < packets.size(); i += 97) {
+                if (classifier.classify(packets[i]) != classifier.classifyLinear(packets[i])) {
+                    mismatches++;
+                }
+            }
+
+            uint64_t checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& packet : packets) {
+                const PacketDetectionRule* rule = classifier.classify(packet);
+                checksum += rule ? rule->pdrId : 0;
+            }
+            double tssMs = elapsedMs(start);
+
+            // Linear scan is slow on big rule sets: measure on a subset
+            size_t linearPackets = std::min<size_t>(packets.size(), 2000000 / ruleCount + 1000);
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < linearPackets; ++i) {
+                const PacketDetectionRule* rule = classifier.classifyLinear(packets[i]);
+                checksum += rule ? rule->pdrId : 0;
+            }
+            double linearMs = elapsedMs(start);
+
+            double tssMpps = packets.size() / (tssMs * 1000.0);
+            double linearMpps = linearPackets / (linearMs * 1000.0);
+
+            std::cout << "Rules=" << std::setw(5) << ruleCount
+                      << " | Tuples=" << std::setw(4) << classifier.getTupleCount()
+                      << " | Entries=" << std::setw(6) << classifier.getEntryCount()
+                      << " | Compile=" << std::fixed << std::setprecision(2) << compileMs << "ms"
+                      << " | TSS=" << std::setprecision(2) << tssMpps << "Mpps"
+                      << " | Linear=" << std::setprecision(3) << linearMpps << "Mpps"
+                      << " | Speedup=" << std::setprecision(1) << (tssMpps / linearMpps) << "x"
+                      << " | Mismatches=" << mismatches
+                      << " (chk " << (checksum & 0xFF) << ")\n";
+        }
+    }
+
+    void runFlowCacheBenchmark() {
+        printHeader("UPF Flow Cache (cached vs uncached classification)");
+
+        const uint32_t sessionCount = 16;
+        const uint32_t rulesPerSession = 1000;
+        const uint32_t flowCount = 20000;
+        const size_t packetCount = 2000000;
+
+        std::vector<PacketDetectionRule> rules = generateRuleSet(rulesPerSession);
+        std::vector<FiveTuple> flows = generatePackets(rules, flowCount);
+
+        // Skewed flow popularity: most packets belong to a few long-lived flows
+        std::vector<uint32_t> trace;
+        trace.reserve(packetCount);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (size_t i = 0; i < packetCount; ++i) {
+            double u = uniform(rng_);
+            trace.push_back(static_cast<uint32_t>(flowCount * u * u * u) % flowCount);
+        }
+
+        double uncachedMpps = 0.0;
+        for (bool cacheEnabled : {false, true}) {
+            UPF upf;
+            upf.setFlowCacheEnabled(cacheEnabled);
+            for (uint32_t s = 0; s < sessionCount; ++s) {
+                upf.attachPduSession(9000 + s, 100 + s);
+                upf.setUsageReportingRule(9000 + s, 0, std::chrono::milliseconds(0));
+                upf.installPacketDetectionRules(9000 + s, rules);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t flow : trace) {
+                upf.forwardUplinkPacket(9000 + (flow % sessionCount), flows[flow], 1200);
+            }
+            double ms = elapsedMs(start);
+            double mpps = packetCount / (ms * 1000.0);
+
+            std::cout << (cacheEnabled ? "Cached  " : "Uncached")
+                      << " | Packets=" << packetCount
+                      << " | Flows=" << flowCount
+                      << " | Rules/Session=" << rulesPerSession
+                      << " | Throughput=" << std::fixed << std::setprecision(2) << mpps << "Mpps"
+                      << " | HitRatio=" << std::setprecision(3) << upf.getFlowCache().getHitRatio()
+                      << " | Evictions=" << upf.getFlowCache().getEvictions()
+                      << " | Unmatched=" << upf.getUnmatchedPackets();
+            if (cacheEnabled) {
+                std::cout << " | Speedup=" << std::setprecision(1) << (mpps / uncachedMpps) << "x";
+            } else {
+                uncachedMpps = mpps;
+            }
+            std::cout << "\n";
+        }
+    }
+
+    void runSchedulerBenchmark() {
+        printHeader("UPF Egress QoS Scheduler (strict priority GBR + DRR non-GBR)");
+
+        // QFI == 5QI for the standardized flows; priority levels from TS 23.501
+        const uint8_t fiveQis[] = {1, 2, 3, 4, 5, 6, 8, 9};
+        const size_t operations = 10000000;
+        const uint32_t backlog = 4096;
+
+        QosScheduler scheduler(EGRESS_QUEUE_CAPACITY);
+        for (uint8_t fiveQi : fiveQis) {
+            scheduler.configureFlow(fiveQi, fiveQi, QosScheduler::defaultPriorityLevel(fiveQi));
+        }
+
+        // Pre-generated arrivals: light GBR load, non-GBR queues always backlogged
+        std::vector<uint8_t> arrivals(1 << 16);
+        std::vector<uint32_t> sizes(arrivals.size());
+        for (size_t i = 0; i < arrivals.size(); ++i) {
+            bool gbr = (rng_() % 10) == 0;
+            arrivals[i] = gbr ? fiveQis[rng_() % 4] : fiveQis[4 + rng_() % 4];
+            sizes[i] = 64 + rng_() % 1437;
+        }
+
+        for (uint32_t i = 0; i < backlog; ++i) {
+            scheduler.enqueue(arrivals[i], 1, sizes[i]);
+        }
+
+        uint64_t bytesByQfi[QosScheduler::MAX_QFI] = {};
+        QosScheduler::ScheduledPacket packet;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < operations; ++i) {
+            size_t slot = (i + backlog) & (arrivals.size() - 1);
+            scheduler.enqueue(arrivals[slot], 1, sizes[slot]);
+            if (scheduler.dequeue(packet)) {
+                bytesByQfi[packet.qfi] += packet.size;
+            }
+        }
+        double ms = elapsedMs(start);
+
+        std::cout << "Operations=" << operations << " enqueue+dequeue"
+                  << " | Backlog=" << scheduler.getQueuedCount()
+                  << " | Throughput=" << std::fixed << std::setprecision(2)
+                  << (operations / (ms * 1000.0)) << "Mpps"
+                  << " | Per-op=" << std::setprecision(1) << (ms * 1e6 / operations) << "ns"
+                  << " | Drops=" << scheduler.getDroppedCount() << "\n";
+
+        // Saturate the non-GBR queues equally and drain half: the bytes each
+        // queue gets out reflect its DRR weight
+        scheduler.clear();
+        for (uint32_t i = 0; i < 8000; ++i) {
+            scheduler.enqueue(fiveQis[4 + i % 4], 1, sizes[i]);
+        }
+        uint64_t drrBytes[QosScheduler::MAX_QFI] = {};
+        uint64_t drainedBytes = 0;
+        for (uint32_t i = 0; i < 4000 && scheduler.dequeue(packet); ++i) {
+            drrBytes[packet.qfi] += packet.size;
+            drainedBytes += packet.size;
+        }
+
+        for (uint8_t fiveQi : fiveQis) {
+            bool gbr = QosScheduler::isGbrFiveQi(fiveQi);
+            std::cout << "  QFI " << std::setw(2) << static_cast<int>(fiveQi)
+                      << (gbr ? " GBR    " : " Non-GBR")
+                      << " | Priority=" << std::setw(2) << QosScheduler::defaultPriorityLevel(fiveQi)
+                      << " | Sent=" << std::setw(11) << bytesByQfi[fiveQi] << "B";
+            if (!gbr) {
+                std::cout << " | Saturated DRR share=" << std::setprecision(1)
+                          << (100.0 * drrBytes[fiveQi] / drainedBytes) << "%";
+            }
+            std::cout << "\n";
+        }
+
+        // End to end through the UPF downlink path
+        UPF upf;
+        const uint32_t sessionCount = 64;
+        for (uint32_t s = 0; s < sessionCount; ++s) {
+            uint8_t fiveQi = fiveQis[s % 8];
+            upf.attachPduSession(9000 + s, 100 + s);
+            upf.setUsageReportingRule(9000 + s, 0, std::chrono::milliseconds(0));
+            upf.configureQosFlow(9000 + s, fiveQi, fiveQi, QosScheduler::defaultPriorityLevel(fiveQi));
+        }
+
+        const size_t upfPackets = 4000000;
+        uint64_t sent = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < upfPackets; ++i) {
+            upf.forwardDownlinkPacket(9000 + (i % sessionCount), sizes[i & (sizes.size() - 1)]);
+            if ((i & 63) == 63) {
+                sent += upf.runEgressScheduler(64);
+            }
+        }
+        ms = elapsedMs(start);
+
+        std::cout << "UPF DL forward+schedule | Packets=" << upfPackets
+                  << " | Sent=" << sent
+                  << " | Throughput=" << std::setprecision(2) << (upfPackets / (ms * 1000.0)) << "Mpps"
+                  << " | Drops=" << upf.getDroppedDownlinkPackets() << "\n";
+    }
+
+    // Sessions are sharded across workers, one UPF instance per worker, the
+    // way a run-to-completion data plane pins sessions to cores.
+    void runUpfThroughputBenchmark(const std::string& outputPath) {
+        printHeader("UPF Forwarding Throughput (UL/DL, 1-8 workers)");
+
+        const uint32_t sessionCount = 4096;
+        const size_t packetCount = 4000000;
+
+        std::vector<PacketDetectionRule> rules = generateRuleSet(32);
+        std::vector<FiveTuple> flows = generatePackets(rules, 8192);
+
+        std::ofstream csv(outputPath);
+        csv << std::fixed;
+        csv << "mode,workers,sessions,packets,mpps,gbps,p50_ns,p99_ns,scaling_efficiency\n";
+
+        double baseMpps = 0.0;
+        for (uint32_t workers : {0u, 1u, 2u, 4u, 8u}) {
+            UpfRunResult result = runUpfWorkers(workers, sessionCount, packetCount, rules, flows);
+
+            uint32_t effectiveWorkers = std::max(workers, 1u);
+            if (workers == 1) {
+                baseMpps = result.mpps;
+            }
+            double efficiency = (workers == 0 || baseMpps == 0.0)
+                                    ? 1.0 : result.mpps / (baseMpps * effectiveWorkers);
+            std::string mode = workers == 0 ? "single" : "workers";
+
+            std::cout << std::setw(8) << mode
+                      << " | Workers=" << effectiveWorkers
+                      << " | Sessions=" << sessionCount
+                      << " | Packets=" << packetCount
+                      << " | " << std::fixed << std::setprecision(2) << result.mpps << "Mpps"
+                      << " | " << std::setprecision(2) << result.gbps << "Gbps"
+                      << " | p50=" << result.p50Ns << "ns"
+                      << " | p99=" << result.p99Ns << "ns"
+                      << " | Scaling=" << std::setprecision(0) << (efficiency * 100.0) << "%\n";
+
+            csv << mode << "," << effectiveWorkers << "," << sessionCount << "," << packetCount
+                << "," << std::setprecision(3) << result.mpps << "," << result.gbps
+                << "," << result.p50Ns << "," << result.p99Ns << "," << efficiency << "\n";
+        }
+
+        std::cout << "Hardware threads: " << std::thread::hardware_concurrency()
+                  << " | Results written to " << outputPath << "\n";
+    }
+
+    void runAppDetectionBenchmark() {
+        printHeader("UPF Application Detection (SNI/Host, Aho-Corasick)");
+
+        const uint32_t patternCount = 5000;
+        const size_t flowCount = 200000;
+
+        std::vector<ApplicationPattern> patterns;
+        patterns.reserve(patternCount);
+        for (uint32_t i = 0; i < patternCount; ++i) {
+            patterns.push_back({randomLabel(6 + rng_() % 8) + "." + randomLabel(3 + rng_() % 6) +
+                                    (i % 3 == 0 ? ".net" : ".com"),
+                                static_cast<AppId>(1 + i % 500)});
+        }
+
+        // Payloads: half TLS ClientHello, half HTTP; 70% of names hit a pattern
+        std::vector<std::vector<uint8_t>> payloads;
+        std::vector<std::string> hosts;
+        payloads.reserve(flowCount);
+        hosts.reserve(flowCount);
+        for (size_t i = 0; i < flowCount; ++i) {
+            std::string host = (rng_() % 10 < 7)
+                                   ? randomLabel(3 + rng_() % 5) + "." + patterns[rng_() % patternCount].pattern
+                                   : randomLabel(8) + "." + randomLabel(6) + ".org";
+            hosts.push_back(host);
+            payloads.push_back(i % 2 == 0 ? buildClientHello(host) : buildHttpRequest(host));
+        }
+
+        AppDetector detector;
+        auto start = std::chrono::steady_clock::now();
+        detector.compile(patterns);
+        double compileMs = elapsedMs(start);
+
+        size_t detected = 0;
+        start = std::chrono::steady_clock::now();
+        for (const auto& payload : payloads) {
+            detected += detector.inspect(payload.data(), payload.size()) != APP_UNKNOWN;
+        }
+        double acMs = elapsedMs(start);
+
+        // Baseline: domain-suffix comparison against every pattern, on a subset
+        size_t naiveFlows = 2000;
+        size_t naiveDetected = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < naiveFlows; ++i) {
+            const std::string& host = hosts[i];
+            size_t bestLength = 0;
+            for (const auto& pattern : patterns) {
+                size_t length = pattern.pattern.size();
+                if (length > bestLength && length <= host.size() &&
+                    host.compare(host.size() - length, length, pattern.pattern) == 0 &&
+                    (length == host.size() || host[host.size() - length - 1] == '.')) {
+                    bestLength = length;
+                }
+            }
+            naiveDetected += bestLength > 0;
+        }
+        double naiveMs = elapsedMs(start);
+
+        double acNsPerFlow = acMs * 1e6 / flowCount;
+        double naiveNsPerFlow = naiveMs * 1e6 / naiveFlows;
+        std::cout << "Patterns=" << patternCount
+                  << " | States=" << detector.getStateCount()
+                  << " | Compile=" << std::fixed << std::setprecision(2) << compileMs << "ms"
+                  << " | Flows=" << flowCount
+                  << " | Detected=" << std::setprecision(1) << (100.0 * detected / flowCount) << "%"
+                  << " | Aho-Corasick=" << std::setprecision(0) << acNsPerFlow << "ns/flow"
+                  << " | Naive=" << naiveNsPerFlow << "ns/flow"
+                  << " | Speedup=" << std::setprecision(1) << (naiveNsPerFlow / acNsPerFlow) << "x"
+                  << " (naive detected " << naiveDetected << "/" << naiveFlows << ")\n";
+
+        // End to end: flows of 20 packets, the first one carrying the name
+        std::vector<PacketDetectionRule> rules = generateRuleSet(16);
+        std::vector<FiveTuple> flows = generatePackets(rules, 20000);
+        for (bool dpiEnabled : {false, true}) {
+            UPF upf;
+            if (dpiEnabled) {
+                upf.installApplicationPatterns(patterns);
+            }
+            for (uint32_t s = 0; s < 16; ++s) {
+                upf.attachPduSession(9000 + s, 100 + s);
+                upf.setUsageReportingRule(9000 + s, 0, std::chrono::milliseconds(0));
+                upf.installPacketDetectionRules(9000 + s, rules);
+            }
+
+            const size_t packets = flows.size() * 20;
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < packets; ++i) {
+                size_t flow = i % flows.size();
+                bool first = i < flows.size();
+                const std::vector<uint8_t>& payload = payloads[flow];
+                upf.forwardUplinkPacket(9000 + (flow % 16), flows[flow], 1200,
+                                        first ? payload.data() : nullptr, first ? payload.size() : 0);
+            }
+            double ms = elapsedMs(start);
+
+            size_t appFlows = 0;
+            for (const auto& usage : upf.collectApplicationUsage()) {
+                appFlows += usage.bytes / 1200;
+            }
+            std::cout << (dpiEnabled ? "UPF with DPI   " : "UPF without DPI")
+                      << " | Packets=" << packets
+                      << " | Throughput=" << std::setprecision(2) << (packets / (ms * 1000.0)) << "Mpps"
+                      << " | App packets=" << appFlows << "\n";
+        }
+    }
+
+    void runIpPoolBenchmark() {
+        printHeader("SMF UE IP Pool (hierarchical bitmap, /8 pool)");
+
+        IpPool pool;
+        pool.addIpv4Pool("internet", "10.0.0.0/8");
+        pool.addIpv6Pool("internet", "fd00::/40");
+        const uint32_t capacity = pool.getIpv4Available("internet");
+
+        // Allocation storm: fill the whole /8
+        std::vector<uint32_t> addresses;
+        addresses.reserve(capacity);
+        uint32_t address = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (pool.allocateIpv4("internet", address)) {
+            addresses.push_back(address);
+        }
+        double fillMs = elapsedMs(start);
+        printPoolPhase("Fill /8", addresses.size(), fillMs, pool);
+
+        // Fragment: release a random half of the pool
+        std::shuffle(addresses.begin(), addresses.end(), rng_);
+        size_t half = addresses.size() / 2;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < half; ++i) {
+            pool.releaseIpv4(addresses[i]);
+        }
+        double releaseMs = elapsedMs(start);
+        printPoolPhase("Release 50% random", half, releaseMs, pool);
+
+        // Refill the holes; lowest free address first
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < half && pool.allocateIpv4("internet", address); ++i) {
+            addresses[i] = address;
+        }
+        double refillMs = elapsedMs(start);
+        printPoolPhase("Refill fragmented", half, refillMs, pool);
+
+        // Churn at 99% occupancy: attach/detach storm on an almost full pool
+        size_t freeTarget = capacity / 100;
+        for (size_t i = 0; i < freeTarget; ++i) {
+            pool.releaseIpv4(addresses[i]);
+        }
+        const size_t churnOps = 4000000;
+        std::uniform_int_distribution<size_t> pick(freeTarget, addresses.size() - 1);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < churnOps; ++i) {
+            size_t victim = pick(rng_);
+            pool.releaseIpv4(addresses[victim]);
+            pool.allocateIpv4("internet", addresses[victim]);
+        }
+        double churnMs = elapsedMs(start);
+        printPoolPhase("Churn at 99% (release+alloc)", churnOps, churnMs, pool);
+
+        // Baseline: first-fit linear scan over a flat bitmap, same occupancy
+        std::vector<bool> flat(capacity, true);
+        for (size_t i = 0; i < freeTarget; ++i) {
+            flat[(i * 2654435761u) % capacity] = false;
+        }
+        const size_t linearOps = 2000;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < linearOps; ++i) {
+            size_t slot = 0;
+            while (slot < capacity && flat[slot]) {
+                slot++;
+            }
+            if (slot < capacity) {
+                flat[slot] = true;
+                flat[(slot * 7 + i) % capacity] = false;
+            }
+        }
+        double linearMs = elapsedMs(start);
+        printPoolPhase("Baseline linear scan at 99%", linearOps, linearMs, pool);
+
+        // IPv6 /64 prefixes from a /40
+        uint64_t prefix = 0;
+        size_t prefixes = 0;
+        start = std::chrono::steady_clock::now();
+        while (prefixes < 4000000 && pool.allocateIpv6Prefix("internet", prefix)) {
+            prefixes++;
+        }
+        double v6Ms = elapsedMs(start);
+        std::cout << std::setw(30) << std::left << "IPv6 /64 prefixes" << std::right
+                  << " | Ops=" << std::setw(8) << prefixes
+                  << " | " << std::fixed << std::setprecision(1) << (v6Ms * 1e6 / prefixes) << "ns/op"
+                  << " | Last=" << IpPool::formatIpv6Prefix(prefix) << "\n";
+
+        // Contended storm: 4 threads allocating and releasing through the lock
+        IpPool shared;
+        shared.addIpv4Pool("internet", "10.0.0.0/8");
+        const uint32_t threads = 4;
+        const size_t perThread = 1000000;
+        std::vector<std::thread> workers;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&shared, perThread]() {
+                std::vector<uint32_t> held;
+                held.reserve(perThread);
+                uint32_t ip = 0;
+                for (size_t i = 0; i < perThread; ++i) {
+                    if (shared.allocateIpv4("internet", ip)) {
+                        held.push_back(ip);
+                    }
+                }
+                for (uint32_t owned : held) {
+                    shared.releaseIpv4(owned);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double sharedMs = elapsedMs(start);
+        std::cout << std::setw(30) << std::left << "4-thread alloc+release storm" << std::right
+                  << " | Ops=" << std::setw(8) << (threads * perThread * 2)
+                  << " | " << std::setprecision(1) << (sharedMs * 1e6 / (threads * perThread * 2)) << "ns/op"
+                  << " | Leaked=" << shared.getIpv4Allocated("internet") << "\n";
+    }
+
+    void runSessionStoreBenchmark(uint32_t sessionCount) {
+        printHeader("SMF Session Store (slab + open-addressing index)");
+
+        SMF smf;
+        smf.configureDnnPool("internet", "10.0.0.0/8", "fd00::/40");
+        size_t rssBefore = residentBytes();
+
+        std::vector<SessionId> ids;
+        ids.reserve(sessionCount);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < sessionCount; ++i) {
+            ids.push_back(smf.createPduSession(1 + i / 4, "internet", 1));
+        }
+        double createMs = elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (SessionId id : ids) {
+            smf.activatePduSession(id);
+        }
+        double activateMs = elapsedMs(start);
+        size_t rssLoaded = residentBytes();
+
+        PduSessionContext context;
+        smf.getPduSessionContext(ids[sessionCount / 2], context);
+
+        // Per-UE queries hit one 64-byte session set per UE
+        const uint32_t ueCount = (sessionCount + 3) / 4;
+        size_t activeFound = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t ue = 1; ue <= ueCount; ++ue) {
+            activeFound += smf.getActiveSessions(ue).size();
+        }
+        double queryMs = elapsedMs(start);
+
+        // Half the sessions go one by one in random order, the rest by UE
+        std::shuffle(ids.begin(), ids.end(), rng_);
+        size_t half = ids.size() / 2;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < half; ++i) {
+            smf.terminatePduSession(ids[i]);
+        }
+        double terminateMs = elapsedMs(start);
+
+        size_t bulkTerminated = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t ue = 1; ue <= ueCount; ++ue) {
+            bulkTerminated += smf.terminateUeSessions(ue);
+        }
+        double ueTeardownMs = elapsedMs(start);
+
+        std::cout << "Sessions=" << sessionCount
+                  << " | Create=" << std::fixed << std::setprecision(0) << (createMs * 1e6 / sessionCount) << "ns"
+                  << " | Activate=" << (activateMs * 1e6 / sessionCount) << "ns"
+                  << " | Terminate(random)=" << (terminateMs * 1e6 / half) << "ns"
+                  << " | Remaining=" << smf.getSessionCount() << "\n";
+        std::cout << "UEs=" << ueCount
+                  << " | GetActiveSessions=" << (queryMs * 1e6 / ueCount) << "ns/UE"
+                  << " (" << activeFound << " found)"
+                  << " | UE teardown=" << (ueTeardownMs * 1e6 / ueCount) << "ns/UE"
+                  << " (" << bulkTerminated << " sessions)\n";
+        std::cout << "RSS growth=" << ((rssLoaded - rssBefore) >> 20) << "MB"
+                  << " (" << ((rssLoaded - rssBefore) / sessionCount) << " B/session incl. per-UE lists)"
+                  << " | Sample: " << context.ipv4Address << " " << context.ipv6Address
+                  << " DNN=" << context.dnn << "\n";
+    }
+
+    void runAmfRegistrationBenchmark(uint32_t ueCount) {
+        printHeader("AMF UE Contexts (register, authenticate, attach)");
+
+        AMF amf;
+        size_t rssBefore = residentBytes();
+
+        // Full registration path per UE, in random UE ID order
+        std::vector<UeId> ues(ueCount);
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            ues[i] = 1 + i;
+        }
+        std::shuffle(ues.begin(), ues.end(), rng_);
+
+        auto start = std::chrono::steady_clock::now();
+        for (UeId ue : ues) {
+            amf.registerUe(ue, 1000000000ULL + ue, 350000000000ULL + ue);
+            amf.authenticateUe(ue, 1000000000ULL + ue);
+            amf.authorizeUe(ue);
+            amf.handleUeAttach(ue, 1 + ue % 64);
+        }
+        double registerMs = elapsedMs(start);
+        size_t rssLoaded = residentBytes();
+        size_t storeBytes = amf.getUeContextMemoryBytes();
+
+        std::shuffle(ues.begin(), ues.end(), rng_);
+        size_t found = 0;
+        start = std::chrono::steady_clock::now();
+        for (UeId ue : ues) {
+            found += amf.isUeRegistered(ue) ? 1 : 0;
+        }
+        double lookupMs = elapsedMs(start);
+
+        // Identity lookups as service requests and re-registrations do them
+        std::vector<Guti> gutis(ueCount);
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            amf.getGuti(ues[i], gutis[i]);
+        }
+        UeId resolved = 0;
+        size_t tmsiFound = 0;
+        start = std::chrono::steady_clock::now();
+        for (const Guti& guti : gutis) {
+            tmsiFound += amf.findUeByTmsi(guti.tmsi, resolved) ? 1 : 0;
+        }
+        double tmsiMs = elapsedMs(start);
+
+        size_t imsiFound = 0;
+        start = std::chrono::steady_clock::now();
+        for (UeId ue : ues) {
+            imsiFound += amf.findUeByImsi(1000000000ULL + ue, resolved) ? 1 : 0;
+        }
+        double imsiMs = elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            amf.reregisterUe(ues[i], gutis[i]);
+        }
+        double reregisterMs = elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (UeId ue : ues) {
+            amf.deregisterUe(ue);
+        }
+        double deregisterMs = elapsedMs(start);
+
+        std::cout << "UEs=" << ueCount << " | Found=" << found
+                  << std::fixed << std::setprecision(2)
+                  << " | Register " << (ueCount / (registerMs / 1000.0) / 1e6) << " M/s"
+                  << " | Lookup " << (ueCount / (lookupMs / 1000.0) / 1e6) << " M/s"
+                  << " | Deregister " << (ueCount / (deregisterMs / 1000.0) / 1e6) << " M/s\n"
+                  << "By 5G-TMSI " << (ueCount / (tmsiMs / 1000.0) / 1e6) << " M/s (" << tmsiFound << " found)"
+                  << " | By IMSI " << (ueCount / (imsiMs / 1000.0) / 1e6) << " M/s (" << imsiFound << " found)"
+                  << " | Re-register by GUTI " << (ueCount / (reregisterMs / 1000.0) / 1e6) << " M/s\n"
+                  << "RSS growth=" << ((rssLoaded - rssBefore) >> 20) << "MB"
+                  << " (" << ((rssLoaded - rssBefore) / ueCount) << " B/UE)"
+                  << " | Context store=" << (storeBytes / ueCount) << " B/UE"
+                  << " | Remaining=" << amf.getRegisteredUeCount() << "\n";
+    }
+
+    void runHandoverBenchmark(uint32_t ueCount) {
+        printHeader("AMF Handover (per UE vs batched group mobility)");
+
+        // Trains of 1000 UEs registered at random times, so their contexts
+        // are scattered, each crossing a chain of cells together
+        const uint32_t trainSize = 1000;
+        const uint32_t gnbCount = 1000;
+        const uint32_t hops = 10;
+        AMF amf;
+        for (uint32_t g = 0; g < gnbCount; ++g) {
+            amf.addGnb(1 + g, {static_cast<Tac>(1 + g / 10)});
+        }
+
+        std::vector<UeId> ues(ueCount);
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            ues[i] = 1 + i;
+            amf.registerUe(ues[i], 1000000000ULL + ues[i], 350000000000ULL + ues[i]);
+        }
+        std::shuffle(ues.begin(), ues.end(), rng_);
+        uint32_t trains = (ueCount + trainSize - 1) / trainSize;
+        auto gnbOf = [&](uint32_t train, uint32_t hop) -> GnbId { return 1 + (train * 7 + hop) % gnbCount; };
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            amf.handleUeAttach(ues[i], gnbOf(i / trainSize, 0));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t hop = 1; hop <= hops; ++hop) {
+            for (uint32_t i = 0; i < ueCount; ++i) {
+                uint32_t train = i / trainSize;
+                amf.handleHandover(ues[i], gnbOf(train, hop - 1), gnbOf(train, hop));
+            }
+        }
+        double singleMs = elapsedMs(start);
+
+        // Every train should now be on its last cell
+        size_t singleArrived = 0;
+        for (uint32_t train = 0; train < trains; ++train) {
+            singleArrived += amf.getGnbUeCount(gnbOf(train, hops));
+        }
+
+        std::vector<HandoverRequest> batch;
+        size_t batchApplied = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t hop = hops + 1; hop <= 2 * hops; ++hop) {
+            for (uint32_t train = 0; train < trains; ++train) {
+                batch.clear();
+                for (uint32_t i = train * trainSize; i < std::min(ueCount, (train + 1) * trainSize); ++i) {
+                    batch.push_back(HandoverRequest{ues[i], gnbOf(train, hop - 1), gnbOf(train, hop)});
+                }
+                batchApplied += amf.handleHandovers(batch.data(), batch.size());
+            }
+        }
+        double batchMs = elapsedMs(start);
+
+        uint64_t counted = 0;
+        for (uint32_t g = 0; g < gnbCount; ++g) {
+            counted += amf.getGnbUeCount(1 + g);
+        }
+
+        double handovers = static_cast<double>(ueCount) * hops;
+        std::cout << "UEs=" << ueCount << " | Train=" << trainSize << " UEs | Hops=" << hops
+                  << " | Arrived: single=" << singleArrived << " | Applied: batch=" << batchApplied << "\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Single: " << (handovers / (singleMs / 1000.0) / 1e6) << " M handovers/s"
+                  << " | Batch: " << (handovers / (batchMs / 1000.0) / 1e6) << " M handovers/s"
+                  << " | Speedup x" << (singleMs / batchMs)
+                  << " | UEs counted on gNBs=" << counted << "\n";
+    }
+
+    void runReachabilityTimerBenchmark(uint32_t ueCount) {
+        printHeader("AMF Reachability Timers (timing wheel, simulated time)");
+
+        // Every UE registers at t=0; 90% come back for periodic registration
+        // a little before each T3512, 10% go silent and must be implicitly
+        // deregistered. The AMF's timers run once per simulated second.
+        const uint32_t horizonSec = 2 * 3600;
+        AMF amf;
+        const uint32_t t3512 = static_cast<uint32_t>(amf.getPeriodicRegistrationTimer().count());
+        auto base = TokenBucket::Clock::now();
+
+        std::vector<Guti> gutis(ueCount);
+        std::vector<std::vector<uint32_t>> updates(horizonSec + 1);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            amf.registerUe(1 + i, 1000000000ULL + i, 350000000000ULL + i);
+        }
+        double registerMs = elapsedMs(start);
+        size_t armed = amf.getArmedTimerCount();
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            amf.getGuti(1 + i, gutis[i]);
+            if (rng_() % 10 != 0) {
+                updates[t3512 - 1 - rng_() % 120].push_back(i);
+            }
+        }
+
+        // One naive sweep over every context, for comparison with a tick
+        size_t stale = 0;
+        auto sweepNow = std::chrono::system_clock::now();
+        start = std::chrono::steady_clock::now();
+        amf.getUeContextStore().forEach([&](const UeContextStore::UeContext& context) {
+            stale += sweepNow - context.registrationTime > std::chrono::seconds(t3512) ? 1 : 0;
+        });
+        double sweepMs = elapsedMs(start);
+
+        double timerMs = 0;
+        double maxTickMs = 0;
+        size_t maxDetachesPerTick = 0;
+        size_t reregistered = 0;
+        for (uint32_t second = 1; second <= horizonSec; ++second) {
+            start = std::chrono::steady_clock::now();
+            size_t detached = amf.runTimers(base + std::chrono::seconds(second));
+            double ms = elapsedMs(start);
+            timerMs += ms;
+            maxTickMs = std::max(maxTickMs, ms);
+            maxDetachesPerTick = std::max(maxDetachesPerTick, detached);
+
+            for (uint32_t i : updates[second]) {
+                if (amf.reregisterUe(1 + i, gutis[i])) {
+                    amf.getGuti(1 + i, gutis[i]);
+                    reregistered++;
+                    uint32_t next = second + t3512 - 1 - rng_() % 120;
+                    if (next <= horizonSec) {
+                        updates[next].push_back(i);
+                    }
+                }
+            }
+            updates[second].clear();
+            updates[second].shrink_to_fit();
+        }
+
+        std::cout << "UEs=" << ueCount << " | T3512=" << t3512 << "s | Horizon=" << horizonSec << "s"
+                  << " | Armed after registration=" << armed << "\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Register+arm " << (ueCount / (registerMs / 1000.0) / 1e6) << " M/s"
+                  << " | Periodic re-registrations=" << reregistered
+                  << " | Implicitly deregistered=" << amf.getImplicitDeregistrationCount()
+                  << " (max " << maxDetachesPerTick << "/tick)"
+                  << " | Still registered=" << amf.getRegisteredUeCount() << "\n"
+                  << "Timer ticks: " << std::setprecision(3) << (timerMs * 1000.0 / horizonSec) << " us avg, "
+                  << maxTickMs << " ms max"
+                  << " | Full context sweep: " << sweepMs << " ms per pass"
+                  << " (" << stale << " stale)\n";
+    }
+
+    void runPipelinedRegistrationBenchmark(uint32_t ueCount) {
+        printHeader("UE Registration Pipeline (AMF -> UDM -> UDR, one thread per NF)");
+
+        // Attach requests are fed to the AMF with at most `window` UEs in
+        // flight; window 1 is the old one-UE-at-a-time procedure
+        for (uint32_t window : {1u, 16u, 256u, 4096u}) {
+            uint32_t count = window == 1 ? std::min(ueCount, 10000u) : ueCount;
+            AMF amf;
+            UDM udm;
+            UDR udr;
+            amf.setMessageSender(NFType::UDM, [&udm](std::shared_ptr<Message> m) { udm.enqueueMessage(m); });
+            udm.setMessageSender(NFType::UDR, [&udr](std::shared_ptr<Message> m) { udr.enqueueMessage(m); });
+            udr.setMessageSender(NFType::UDM, [&udm](std::shared_ptr<Message> m) { udm.enqueueMessage(m); });
+            udm.setMessageSender(NFType::AMF, [&amf](std::shared_ptr<Message> m) { amf.enqueueMessage(m); });
+            for (uint32_t i = 0; i < count; ++i) {
+                SubscriptionData subData;
+                subData.imsi = 1000000000ULL + i;
+                subData.msisdn = "1555" + std::to_string(i);
+                subData.accessRestrictionData = false;
+                udr.storeSubscriptionData(subData.imsi, subData);
+            }
+
+            udr.startWorker();
+            udm.startWorker();
+            amf.startWorker();
+            std::vector<RegistrationResult> results;
+            results.reserve(count);
+            uint32_t submitted = 0;
+            auto start = std::chrono::steady_clock::now();
+            while (results.size() < count) {
+                while (submitted < count && submitted - results.size() < window) {
+                    amf.enqueueMessage(std::make_shared<AttachRequestMessage>(
+                        1 + submitted, 1000000000ULL + submitted, 350000000000ULL + submitted,
+                        1 + submitted % 64));
+                    submitted++;
+                }
+                if (amf.collectRegistrationResults(results) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            double ms = elapsedMs(start);
+            amf.stopWorker();
+            udm.stopWorker();
+            udr.stopWorker();
+
+            size_t accepted = 0;
+            for (const RegistrationResult& result : results) {
+                accepted += result.accepted ? 1 : 0;
+            }
+            auto stage = [](const LatencyStats& stats) {
+                std::ostringstream oss;
+                oss << std::fixed << std::setprecision(1) << stats.averageUs();
+                return oss.str();
+            };
+            const LatencyStats& total = amf.getRegistrationLatency();
+            std::cout << "Window=" << std::setw(4) << window << " | UEs=" << count
+                      << " | Accepted=" << accepted
+                      << std::fixed << std::setprecision(0)
+                      << " | " << (count / (ms / 1000.0)) << " reg/s"
+                      << " | End-to-end " << std::setprecision(1) << total.averageUs() << " us avg, "
+                      << total.maxUs << " us max\n"
+                      << "    Stage avg (us): UE->AMF " << stage(amf.getMessageLatency(MessageType::UE_ATTACH_REQUEST))
+                      << " | AMF->UDM " << stage(udm.getMessageLatency(MessageType::AUTH_VECTOR_REQUEST))
+                      << " | UDM->UDR " << stage(udr.getMessageLatency(MessageType::SUBSCRIPTION_DATA_REQUEST))
+                      << " | UDR->UDM " << stage(udm.getMessageLatency(MessageType::SUBSCRIPTION_DATA_RESPONSE))
+                      << " | UDM->AMF " << stage(amf.getMessageLatency(MessageType::AUTH_VECTOR_RESPONSE)) << "\n";
+        }
+    }
+
+    void runCellSelectionBenchmark(uint32_t ueCount) {
+        printHeader("gNodeB Cell Selection and Per-Cell UE Index");
+
+        // A macro site with dozens of cells: UEs connect with their own RSRP
+        // measurements, a quarter of them churn, and per-cell counts are
+        // read after every connect
+        const uint32_t cellCount = 48;
+        GNodeB gnb(1, "benchmark");
+        gnb.setCapacity(GnbCapacity{cellCount, ueCount * 2, 0});
+        for (uint32_t c = 0; c < cellCount; ++c) {
+            gnb.addCell(100 + c, c, 3500 + (c % 3) * 100);
+        }
+
+        std::normal_distribution<float> shadowing(0.0f, 6.0f);
+        std::vector<std::vector<float>> measurements(1024, std::vector<float>(cellCount));
+        for (auto& rsrp : measurements) {
+            for (uint32_t c = 0; c < cellCount; ++c) {
+                rsrp[c] = gnb.getAllCells()[c].rsrp + shadowing(rng_);
+            }
+        }
+
+        uint64_t countSum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            gnb.connectUe(1 + i, measurements[i % measurements.size()]);
+            countSum += gnb.getConnectedUeCount(gnb.getUeCell(1 + i));
+        }
+        double connectMs = elapsedMs(start);
+
+        uint32_t churn = ueCount / 4;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < churn; ++i) {
+            UeId ueId = 1 + static_cast<UeId>(rng_() % ueCount);
+            gnb.disconnectUe(ueId);
+            gnb.connectUe(ueId, measurements[ueId % measurements.size()]);
+        }
+        double churnMs = elapsedMs(start);
+
+        size_t minLoad = ueCount;
+        size_t maxLoad = 0;
+        size_t listed = 0;
+        for (const CellInfo& cell : gnb.getAllCells()) {
+            size_t load = gnb.getConnectedUeCount(cell.cellId);
+            minLoad = std::min(minLoad, load);
+            maxLoad = std::max(maxLoad, load);
+            listed += gnb.getCellUes(cell.cellId).size();
+        }
+
+        std::cout << "Cells=" << cellCount << " | UEs=" << gnb.getConnectedUeCount()
+                  << " (listed " << listed << ")"
+                  << " | UEs per cell: min " << minLoad << ", max " << maxLoad
+                  << " (limit " << (2 * ueCount + cellCount - 1) / cellCount << ")\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Connect+select+count " << (ueCount / (connectMs / 1000.0) / 1e6) << " M/s"
+                  << " | Disconnect+reconnect " << (churn / (churnMs / 1000.0) / 1e6) << " M/s"
+                  << " | checksum " << countSum << "\n";
+    }
+
+    void runRadioMeasurementBenchmark(uint32_t ueCount) {
+        printHeader("Radio Measurements (path loss + shadowing, UEs x 8 neighbor cells)");
+
+        // Cells on a square grid at a 400 m inter-site distance; each UE
+        // measures the 8 nearest of the 3x3 sites around it
+        const uint32_t side = 64;
+        const float spacing = 400.0f;
+        RadioPropagation radio;
+        std::vector<uint32_t> grid(side * side);
+        for (uint32_t row = 0; row < side; ++row) {
+            for (uint32_t col = 0; col < side; ++col) {
+                grid[row * side + col] = radio.addCell(row * side + col, col * spacing, row * spacing, 25.0f, 18.0f);
+            }
+        }
+
+        std::uniform_real_distribution<float> position(0.0f, (side - 1) * spacing);
+        radio.reserve(ueCount);
+        std::vector<std::pair<float, uint32_t>> candidates;
+        uint32_t neighbors[RadioPropagation::NEIGHBORS];
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            float x = position(rng_);
+            float y = position(rng_);
+            uint32_t ue = radio.addUe(x, y);
+            int32_t col = static_cast<int32_t>(x / spacing + 0.5f);
+            int32_t row = static_cast<int32_t>(y / spacing + 0.5f);
+            candidates.clear();
+            for (int32_t r = std::max(row - 1, 0); r <= std::min(row + 1, static_cast<int32_t>(side) - 1); ++r) {
+                for (int32_t c = std::max(col - 1, 0); c <= std::min(col + 1, static_cast<int32_t>(side) - 1); ++c) {
+                    float dx = x - c * spacing;
+                    float dy = y - r * spacing;
+                    candidates.emplace_back(dx * dx + dy * dy, grid[r * side + c]);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+            uint32_t count = static_cast<uint32_t>(std::min<size_t>(candidates.size(), RadioPropagation::NEIGHBORS));
+            for (uint32_t k = 0; k < count; ++k) {
+                neighbors[k] = candidates[k].second;
+            }
+            radio.setNeighbors(ue, neighbors, count);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        radio.measureScalar();
+        double scalarMs = elapsedMs(start);
+        std::vector<float> scalarRsrp(radio.getRsrpRow(0), radio.getRsrpRow(0) + ueCount);
+        std::vector<float> scalarRsrq(radio.getRsrqRow(0), radio.getRsrqRow(0) + ueCount);
+
+        const int periods = 10;
+        start = std::chrono::steady_clock::now();
+        for (int p = 0; p < periods; ++p) {
+            radio.measure();
+        }
+        double simdMs = elapsedMs(start) / periods;
+
+        float maxRsrpDiff = 0;
+        float maxRsrqDiff = 0;
+        double bestRsrp = 0;
+        for (uint32_t ue = 0; ue < ueCount; ++ue) {
+            maxRsrpDiff = std::max(maxRsrpDiff, std::fabs(radio.getRsrp(ue, 0) - scalarRsrp[ue]));
+            maxRsrqDiff = std::max(maxRsrqDiff, std::fabs(radio.getRsrq(ue, 0) - scalarRsrq[ue]));
+            uint32_t best = radio.getBestCell(ue);
+            for (uint32_t k = 0; k < RadioPropagation::NEIGHBORS; ++k) {
+                if (radio.getNeighbor(ue, k) == best) {
+                    bestRsrp += radio.getRsrp(ue, k);
+                }
+            }
+        }
+
+        double links = static_cast<double>(ueCount) * RadioPropagation::NEIGHBORS;
+        std::cout << "UEs=" << ueCount << " | Cells=" << radio.getCellCount()
+                  << " | Links/period=" << static_cast<uint64_t>(links)
+                  << " | AVX2 " << (RadioPropagation::hasAvx2() ? "available" : "not available") << "\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Scalar " << scalarMs << " ms/period (" << (links / (scalarMs / 1000.0) / 1e6) << " M links/s)"
+                  << " | Dispatched " << simdMs << " ms/period (" << (links / (simdMs / 1000.0) / 1e6) << " M links/s)"
+                  << " | Speedup " << (scalarMs / simdMs) << "x"
+                  << " | 100 ms budget: " << (simdMs <= 100.0 ? "met" : "missed") << "\n"
+                  << "Mean best-cell RSRP " << (bestRsrp / ueCount) << " dBm"
+                  << std::setprecision(5) << " | Max diff vs scalar: RSRP " << maxRsrpDiff
+                  << " dB, RSRQ " << maxRsrqDiff << " dB\n";
+    }
+
+    void runNeighborCellBenchmark(uint32_t cellCount) {
+        printHeader("Neighbor Cell Lookup (uniform grid vs full scan)");
+
+        // Three-sector sites on a jittered 500 m grid; UEs anywhere in the
+        // covered area look up their 8 nearest cells
+        const uint32_t siteCount = (cellCount + 2) / 3;
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(siteCount))));
+        const float spacing = 500.0f;
+        std::uniform_real_distribution<float> jitter(-150.0f, 150.0f);
+        std::vector<Position> cells;
+        SpatialGrid grid(spacing);
+        for (uint32_t site = 0; site < siteCount; ++site) {
+            Position position = {(site % side) * spacing + jitter(rng_), (site / side) * spacing + jitter(rng_)};
+            for (uint32_t sector = 0; sector < 3 && cells.size() < cellCount; ++sector) {
+                grid.add(static_cast<uint32_t>(cells.size()), position);
+                cells.push_back(position);
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        grid.build();
+        double buildMs = elapsedMs(start);
+
+        const uint32_t queryCount = 1000000;
+        std::uniform_real_distribution<float> area(0.0f, side * spacing);
+        std::vector<Position> queries(queryCount);
+        for (Position& query : queries) {
+            query = Position{area(rng_), area(rng_)};
+        }
+
+        const uint32_t k = RadioPropagation::NEIGHBORS;
+        std::vector<uint32_t> nearest(static_cast<size_t>(queryCount) * k);
+        start = std::chrono::steady_clock::now();
+        for (uint32_t q = 0; q < queryCount; ++q) {
+            grid.queryNearest(queries[q], k, &nearest[static_cast<size_t>(q) * k]);
+        }
+        double gridMs = elapsedMs(start);
+
+        // Full scans on a sample, which also checks the grid's answers
+        const uint32_t scanCount = std::min<uint32_t>(queryCount, 2000);
+        std::vector<std::pair<float, uint32_t>> scan(cells.size());
+        size_t mismatches = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t q = 0; q < scanCount; ++q) {
+            for (uint32_t c = 0; c < cells.size(); ++c) {
+                float dx = cells[c].x - queries[q].x;
+                float dy = cells[c].y - queries[q].y;
+                scan[c] = std::make_pair(dx * dx + dy * dy, c);
+            }
+            std::partial_sort(scan.begin(), scan.begin() + k, scan.end());
+            for (uint32_t j = 0; j < k; ++j) {
+                // Co-sited cells tie; compare distances, not IDs
+                const Position& found = cells[nearest[static_cast<size_t>(q) * k + j]];
+                float dx = found.x - queries[q].x;
+                float dy = found.y - queries[q].y;
+                mismatches += (dx * dx + dy * dy) != scan[j].first ? 1 : 0;
+            }
+        }
+        double scanMs = elapsedMs(start);
+
+        std::vector<uint32_t> inRange;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t q = 0; q < queryCount; ++q) {
+            inRange.clear();
+            grid.queryRadius(queries[q], 1000.0f, inRange);
+        }
+        double radiusMs = elapsedMs(start);
+
+        std::cout << "Cells=" << cells.size() << " | Bucket=" << grid.getBucketSize() << " m"
+                  << " | Build " << std::fixed << std::setprecision(2) << buildMs << " ms"
+                  << " | Mismatches vs scan=" << mismatches << "\n";
+        std::cout << "Nearest-" << k << ": grid " << (gridMs * 1000.0 / queryCount) << " us/query"
+                  << " | scan " << (scanMs * 1000.0 / scanCount) << " us/query"
+                  << " | Speedup " << std::setprecision(0) << ((scanMs / scanCount) / (gridMs / queryCount)) << "x"
+                  << std::setprecision(2) << " | Within 1 km: " << (radiusMs * 1000.0 / queryCount) << " us/query\n";
+    }
+
+    void runRegistrationStormBenchmark() {
+        printHeader("AMF Registration Storm after gNB Outage (simulated time)");
+
+        // The AMF serves registrations FIFO at a fixed capacity. A UE whose
+        // registration is not answered within T3510 gives up and retries; a
+        // rejected UE retries after the T3346 it was given.
+        const double capacity = 2000;
+        const uint32_t gnbCount = 64;
+        AdmissionConfig admission = {capacity * 0.9, capacity * 0.9 / 4,
+                                     capacity * 0.9 / gnbCount * 4, 8, 1000, 60000};
+
+        std::cout << "AMF capacity=" << capacity << " reg/s | gNBs=" << gnbCount
+                  << " | Admission: " << admission.globalRate << "/s global, "
+                  << admission.perGnbRate << "/s per gNB | T3510=15s | Horizon=300s\n";
+        for (uint32_t ueCount : {4000u, 16000u, 64000u}) {
+            for (int controlled = 0; controlled < 2; ++controlled) {
+                StormResult result = simulateStorm(ueCount, gnbCount, capacity,
+                                                   controlled ? &admission : nullptr);
+                std::cout << "UEs=" << std::setw(5) << ueCount
+                          << (controlled ? " | AC on  " : " | AC off ")
+                          << "| Registered=" << result.registered
+                          << std::fixed << std::setprecision(1)
+                          << " by " << (result.lastMs / 1000.0) << "s"
+                          << " | Latency p50=" << (percentile(result.latencyUs, 0.50) / 1e6) << "s"
+                          << " p99=" << (percentile(result.latencyUs, 0.99) / 1e6) << "s"
+                          << " | AMF response max=" << std::setprecision(0) << result.maxResponseMs << "ms"
+                          << " | Timeouts=" << result.timeouts
+                          << " | Rejects=" << result.rejects << "\n";
+            }
+        }
+    }
+
+    void runPagingBenchmark(uint32_t ueCount) {
+        printHeader("AMF Paging (per-gNB batching, last gNB -> TA -> TA list)");
+
+        // 1000 gNBs, 10 per tracking area, registration areas of 5 TAs.
+        // Each idle UE is really under its last gNB (80%), elsewhere in its
+        // TA (15%), elsewhere in its TA list (4%) or out of coverage (1%),
+        // and answers the first page that reaches that gNB.
+        const uint32_t gnbCount = 1000;
+        const uint32_t gnbsPerTa = 10;
+        const uint32_t tasPerList = 5;
+        const uint32_t pagesPerTick = 10000;
+
+        PagingEngine paging;
+        for (uint32_t g = 0; g < gnbCount; ++g) {
+            paging.addGnb(1 + g, {static_cast<Tac>(1 + g / gnbsPerTa)});
+        }
+        for (uint32_t ta = 0; ta < gnbCount / gnbsPerTa; ta += tasPerList) {
+            std::vector<Tac> tacs;
+            for (uint32_t t = 0; t < tasPerList; ++t) {
+                tacs.push_back(1 + ta + t);
+            }
+            paging.addTaList(tacs);
+        }
+
+        std::vector<PagingTarget> targets(ueCount);
+        std::vector<GnbId> actualGnb(ueCount);
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            uint32_t g = rng_() % gnbCount;
+            uint32_t ta = g / gnbsPerTa;
+            targets[i] = PagingTarget{1 + i, 1 + i, 1 + g, 1 + ta, static_cast<uint16_t>(1 + ta / tasPerList)};
+
+            uint32_t roll = rng_() % 100;
+            if (roll < 80) {
+                actualGnb[i] = 1 + g;
+            } else if (roll < 95) {
+                actualGnb[i] = 1 + ta * gnbsPerTa + (g % gnbsPerTa + 1 + rng_() % (gnbsPerTa - 1)) % gnbsPerTa;
+            } else if (roll < 99) {
+                uint32_t listStart = ta - ta % tasPerList;
+                uint32_t otherTa = listStart + (ta - listStart + 1 + rng_() % (tasPerList - 1)) % tasPerList;
+                actualGnb[i] = 1 + otherTa * gnbsPerTa + rng_() % gnbsPerTa;
+            } else {
+                actualGnb[i] = 0;
+            }
+        }
+
+        std::vector<PagingBatch> batches;
+        std::vector<UeId> failed;
+        std::vector<UeId> answers;
+        uint64_t maxMessagesPerTick = 0;
+        uint32_t next = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        while (next < ueCount || paging.getPendingCount() > 0) {
+            for (uint32_t end = std::min(next + pagesPerTick, ueCount); next < end; ++next) {
+                paging.request(targets[next]);
+            }
+
+            batches.clear();
+            failed.clear();
+            paging.tick(batches, failed);
+            maxMessagesPerTick = std::max<uint64_t>(maxMessagesPerTick, batches.size());
+
+            // Service requests come back before the next tick
+            answers.clear();
+            for (const PagingBatch& batch : batches) {
+                for (Tmsi tmsi : batch.tmsis) {
+                    if (actualGnb[tmsi - 1] == batch.gnbId) {
+                        answers.push_back(tmsi);
+                    }
+                }
+            }
+            for (UeId ueId : answers) {
+                paging.answer(ueId);
+            }
+        }
+        double ms = elapsedMs(start);
+
+        const PagingStats& stats = paging.getStats();
+        std::cout << "Idle UEs=" << ueCount << " | gNBs=" << gnbCount
+                  << " | TAs=" << gnbCount / gnbsPerTa << " | Pages/tick=" << pagesPerTick << "\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Throughput: " << (ueCount / (ms / 1000.0) / 1e6) << " M pages/s"
+                  << " | Ticks=" << paging.getTickCount() << "\n"
+                  << "Messages=" << stats.messages << " (max " << maxMessagesPerTick << "/tick)"
+                  << " | UE records=" << stats.records
+                  << " | Records/message=" << (static_cast<double>(stats.records) / stats.messages) << "\n"
+                  << "Answered: last gNB=" << stats.answered[static_cast<size_t>(PagingScope::LAST_GNB)]
+                  << " | TA=" << stats.answered[static_cast<size_t>(PagingScope::TRACKING_AREA)]
+                  << " | TA list=" << stats.answered[static_cast<size_t>(PagingScope::TA_LIST)]
+                  << " | Failed=" << stats.failed << "\n";
+    }
+
+    void runSessionBulkBenchmark(uint32_t sessionCount) {
+        printHeader("SMF Session Establishment (single vs bulk)");
+
+        const uint32_t batchSize = 1024;
+        std::vector<PduSessionRequest> requests(sessionCount);
+        for (uint32_t i = 0; i < sessionCount; ++i) {
+            requests[i].ueId = 1 + i / 4;
+            requests[i].dnn = (i % 8 == 7) ? "ims" : "internet";
+            requests[i].snssai = 1;
+        }
+
+        // Single path: create + activate + terminate per session
+        SessionRates single = {};
+        {
+            SMF smf;
+            smf.configureDnnPool("internet", "10.0.0.0/8", "fd00::/40");
+            smf.configureDnnPool("ims", "11.0.0.0/8", "fd01::/40");
+            std::vector<SessionId> ids;
+            ids.reserve(sessionCount);
+
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& request : requests) {
+                SessionId id = smf.createPduSession(request.ueId, request.dnn, request.snssai);
+                smf.activatePduSession(id);
+                ids.push_back(id);
+            }
+            single.establishPerSec = sessionCount / (elapsedMs(start) / 1000.0);
+
+            start = std::chrono::steady_clock::now();
+            for (SessionId id : ids) {
+                smf.terminatePduSession(id);
+            }
+            single.releasePerSec = sessionCount / (elapsedMs(start) / 1000.0);
+        }
+
+        // Bulk path: the same requests in batches
+        SessionRates bulk = {};
+        {
+            SMF smf;
+            smf.configureDnnPool("internet", "10.0.0.0/8", "fd00::/40");
+            smf.configureDnnPool("ims", "11.0.0.0/8", "fd01::/40");
+            std::vector<std::vector<SessionId>> batches;
+            std::vector<PduSessionRequest> batch;
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < sessionCount; i += batchSize) {
+                batch.assign(requests.begin() + i, requests.begin() + std::min(i + batchSize, sessionCount));
+                batches.push_back(smf.createPduSessions(batch));
+            }
+            bulk.establishPerSec = sessionCount / (elapsedMs(start) / 1000.0);
+
+            start = std::chrono::steady_clock::now();
+            for (const auto& ids : batches) {
+                smf.releasePduSessions(ids);
+            }
+            bulk.releasePerSec = sessionCount / (elapsedMs(start) / 1000.0);
+        }
+
+        std::cout << "Sessions=" << sessionCount << " | Batch=" << batchSize << "\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Single: establish " << (single.establishPerSec / 1e6) << " M/s"
+                  << " | release " << (single.releasePerSec / 1e6) << " M/s\n"
+                  << "Bulk:   establish " << (bulk.establishPerSec / 1e6) << " M/s"
+                  << " | release " << (bulk.releasePerSec / 1e6) << " M/s\n"
+                  << "Speedup: establish x" << (bulk.establishPerSec / single.establishPerSec)
+                  << " | release x" << (bulk.releasePerSec / single.releasePerSec) << "\n";
+    }
+
+    void runSessionIdBenchmark(uint32_t idsPerThread) {
+        printHeader("SMF Session ID Allocation (shared vs per-thread batch)");
+
+        const uint32_t releaseChunk = 1024;
+        for (uint32_t threads : {1u, 2u, 4u}) {
+            double rates[2] = {0, 0};
+            for (int batched = 0; batched < 2; ++batched) {
+                SessionIdAllocator allocator;
+                std::vector<std::thread> workers;
+
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t t = 0; t < threads; ++t) {
+                    workers.emplace_back([&allocator, batched, idsPerThread, releaseChunk]() {
+                        SessionIdAllocator::Batch batch(allocator);
+                        std::vector<SessionId> held;
+                        held.reserve(releaseChunk);
+                        for (uint32_t i = 0; i < idsPerThread; ++i) {
+                            held.push_back(batched ? batch.allocate() : allocator.allocate());
+                            if (held.size() == releaseChunk) {
+                                allocator.release(held.data(), releaseChunk);
+                                held.clear();
+                            }
+                        }
+                        allocator.release(held.data(), static_cast<uint32_t>(held.size()));
+                    });
+                }
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+                rates[batched] = threads * static_cast<double>(idsPerThread) / (elapsedMs(start) / 1000.0);
+            }
+
+            std::cout << std::fixed << std::setprecision(2)
+                      << "Threads=" << threads
+                      << " | Shared " << (rates[0] / 1e6) << " M IDs/s"
+                      << " | Batched " << (rates[1] / 1e6) << " M IDs/s"
+                      << " | x" << (rates[1] / rates[0]) << "\n";
+        }
+
+        // Independent SMF instances establishing sessions side by side
+        const uint32_t instances = 4;
+        const uint32_t perInstance = std::min<uint32_t>(idsPerThread / 10, 100000);
+        std::vector<std::vector<SessionId>> issued(instances);
+        std::vector<std::thread> workers;
+        for (uint32_t n = 0; n < instances; ++n) {
+            workers.emplace_back([&issued, n, perInstance]() {
+                SMF smf;
+                smf.configureDnnPool("internet", "10.0.0.0/8", "fd00::/40");
+                for (uint32_t i = 0; i < perInstance; ++i) {
+                    issued[n].push_back(smf.createPduSession(1 + i / 4, "internet", 1));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        std::vector<SessionId> all;
+        for (const auto& ids : issued) {
+            all.insert(all.end(), ids.begin(), ids.end());
+        }
+        std::sort(all.begin(), all.end());
+        size_t collisions = all.size() - (std::unique(all.begin(), all.end()) - all.begin());
+        std::cout << "SMF instances=" << instances << " x " << perInstance
+                  << " sessions | Duplicate IDs=" << collisions << "\n";
+    }
+
+    void runN4Benchmark(uint32_t sessionCount) {
+        printHeader("N4 Session Provisioning (SMF -> UPF)");
+
+        std::vector<PduSessionRequest> requests(sessionCount);
+        for (uint32_t i = 0; i < sessionCount; ++i) {
+            requests[i].ueId = 1 + i / 4;
+            requests[i].dnn = "internet";
+            requests[i].snssai = 1;
+        }
+
+        // One operation per message, answered before the next is sent
+        {
+            N4Link link(false);
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& request : requests) {
+                SessionId id = link.smf.createPduSession(request.ueId, request.dnn, request.snssai);
+                link.smf.activatePduSession(id);
+                link.smf.flushN4Requests();
+            }
+            printN4Result("Unbundled", sessionCount, elapsedMs(start), link);
+        }
+
+        // Bundles of up to 1024 operations, answered synchronously
+        {
+            N4Link link(false);
+            auto start = std::chrono::steady_clock::now();
+            establishInBatches(link, requests);
+            printN4Result("Bundled", sessionCount, elapsedMs(start), link);
+        }
+
+        // Bundles over a queued transport: requests pile up in flight and
+        // responses arrive later, out of the sender's call stack
+        {
+            N4Link link(true);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<SessionId> ids = establishInBatches(link, requests);
+            link.pump();
+            printN4Result("Pipelined", sessionCount, elapsedMs(start), link);
+
+            link.messages = 0;
+            link.bytes = 0;
+            start = std::chrono::steady_clock::now();
+            link.smf.releasePduSessions(ids);
+            link.pump();
+            printN4Result("Release", sessionCount, elapsedMs(start), link);
+        }
+    }
+
+    void runCounterSyncBenchmark(uint32_t sessionCount) {
+        printHeader("UPF -> SMF Counter Sync (per-epoch deltas)");
+
+        N4Link link(false);
+        std::vector<PduSessionRequest> requests(sessionCount, PduSessionRequest{0, "internet", 1});
+        for (uint32_t i = 0; i < sessionCount; ++i) {
+            requests[i].ueId = 1 + i / 4;
+        }
+        std::vector<SessionId> ids = establishInBatches(link, requests);
+
+        // Each epoch a different slice of sessions carries traffic
+        for (double activeShare : {0.01, 0.10, 1.0}) {
+            uint32_t active = std::max<uint32_t>(1, static_cast<uint32_t>(sessionCount * activeShare));
+            std::uniform_int_distribution<uint32_t> pick(0, sessionCount - 1);
+            for (uint32_t i = 0; i < active; ++i) {
+                link.upf.forwardUplinkPacket(ids[pick(rng_)], 1200);
+            }
+
+            link.messages = 0;
+            link.bytes = 0;
+            auto start = std::chrono::steady_clock::now();
+            size_t published = link.upf.publishCounterDeltas();
+            double ms = elapsedMs(start);
+
+            std::cout << "Active=" << std::setw(5) << std::fixed << std::setprecision(1) << (activeShare * 100) << "%"
+                      << " | Deltas=" << published
+                      << " | Sync=" << std::setprecision(2) << ms << "ms"
+                      << " (" << std::setprecision(0) << (published ? ms * 1e6 / published : 0) << "ns/session)"
+                      << " | Wire=" << link.bytes << "B in " << link.messages << " msg"
+                      << " | Epoch=" << link.smf.getCounterEpoch() << "\n";
+        }
+    }
+
+private:
+    // SMF and UPF joined over N4, directly or through message queues
+    struct N4Link {
+        SMF smf;
+        UPF upf;
+        std::deque<std::vector<uint8_t>> toUpf;
+        std::deque<std::vector<uint8_t>> toSmf;
+        uint64_t messages;
+        uint64_t bytes;
+        size_t peakInFlight;
+
+        explicit N4Link(bool queued) : messages(0), bytes(0), peakInFlight(0) {
+            smf.configureDnnPool("internet", "10.0.0.0/8", "fd00::/40");
+            smf.setN4Sender([this, queued](const uint8_t* data, size_t length) {
+                count(length);
+                if (queued) {
+                    toUpf.emplace_back(data, data + length);
+                    peakInFlight = std::max(peakInFlight, smf.getN4InFlightCount());
+                } else {
+                    upf.handleN4Message(data, length);
+                }
+            });
+            upf.setN4Sender([this, queued](const uint8_t* data, size_t length) {
+                count(length);
+                if (queued) {
+                    toSmf.emplace_back(data, data + length);
+                } else {
+                    smf.handleN4Message(data, length);
+                }
+            });
+        }
+
+        void count(size_t length) {
+            messages++;
+            bytes += length;
+        }
+
+        void pump() {
+            while (!toUpf.empty() || !toSmf.empty()) {
+                while (!toUpf.empty()) {
+                    std::vector<uint8_t> message = std::move(toUpf.front());
+                    toUpf.pop_front();
+                    upf.handleN4Message(message.data(), message.size());
+                }
+                while (!toSmf.empty()) {
+                    std::vector<uint8_t> message = std::move(toSmf.front());
+                    toSmf.pop_front();
+                    smf.handleN4Message(message.data(), message.size());
+                }
+            }
+        }
+    };
+
+    std::vector<SessionId> establishInBatches(N4Link& link, const std::vector<PduSessionRequest>& requests) {
+        const size_t batchSize = 1024;
+        std::vector<SessionId> ids;
+        std::vector<PduSessionRequest> batch;
+        for (size_t i = 0; i < requests.size(); i += batchSize) {
+            batch.assign(requests.begin() + i, requests.begin() + std::min(i + batchSize, requests.size()));
+            std::vector<SessionId> created = link.smf.createPduSessions(batch);
+            ids.insert(ids.end(), created.begin(), created.end());
+        }
+        return ids;
+    }
+
+    void printN4Result(const std::string& label, uint32_t sessions, double ms, const N4Link& link) {
+        std::cout << std::left << std::setw(10) << label << std::right
+                  << " | " << std::fixed << std::setprecision(0) << (sessions / (ms / 1000.0)) << " sessions/s"
+                  << " | Messages=" << link.messages
+                  << " | " << std::setprecision(1) << (static_cast<double>(link.bytes) / link.messages) << " B/msg"
+                  << " | Peak in flight=" << link.peakInFlight
+                  << " | SMF active=" << link.smf.getActiveSessionCount()
+                  << " | UPF sessions=" << link.upf.getAttachedSessionCount() << "\n";
+    }
+
+    struct StormResult {
+        std::vector<uint64_t> latencyUs;   // First attempt to accept, per UE
+        uint32_t registered;
+        double lastMs;
+        double maxResponseMs;              // Longest AMF answer to a request
+        uint64_t timeouts;
+        uint64_t rejects;
+    };
+
+    StormResult simulateStorm(uint32_t ueCount, uint32_t gnbCount, double capacity,
+                              const AdmissionConfig* admission) {
+        const double serviceMs = 1000.0 / capacity;
+        const double t3510Ms = 15000;
+        const double horizonMs = 300000;
+
+        AMF amf;
+        if (admission) {
+            amf.configureAdmission(*admission);
+        }
+
+        // The RAN comes back and every UE reconnects at once
+        std::vector<std::unique_ptr<GNodeB>> gnbs;
+        for (uint32_t g = 0; g < gnbCount; ++g) {
+            gnbs.emplace_back(new GNodeB(2000 + g, "storm"));
+        }
+        std::vector<double> firstAttempt(ueCount);
+        typedef std::pair<double, uint32_t> Attempt;
+        std::priority_queue<Attempt, std::vector<Attempt>, std::greater<Attempt>> attempts;
+        std::uniform_real_distribution<double> arrival(0, 1000);
+        for (uint32_t i = 0; i < ueCount; ++i) {
+            gnbs[i % gnbCount]->connectUe(1 + i);
+            firstAttempt[i] = arrival(rng_);
+            attempts.push(Attempt(firstAttempt[i], i));
+        }
+
+        StormResult result = {};
+        result.latencyUs.reserve(ueCount);
+        TokenBucket::Clock::time_point base = TokenBucket::Clock::now();
+        double serverFreeMs = 0;
+
+        while (!attempts.empty() && attempts.top().first < horizonMs) {
+            double now = attempts.top().first;
+            uint32_t i = attempts.top().second;
+            attempts.pop();
+
+            GnbId gnbId = gnbs[i % gnbCount]->getGnbId();
+            AdmissionDecision decision = amf.admitRegistration(
+                gnbId, base + std::chrono::microseconds(static_cast<int64_t>(now * 1000)));
+            if (!decision.admitted) {
+                result.rejects++;
+                attempts.push(Attempt(now + decision.backoffMs, i));
+                continue;
+            }
+
+            double doneMs = std::max(now, serverFreeMs) + serviceMs;
+            serverFreeMs = doneMs;
+            result.maxResponseMs = std::max(result.maxResponseMs, doneMs - now);
+            if (doneMs - now > t3510Ms) {
+                result.timeouts++;   // The AMF still does the work, for nobody
+                attempts.push(Attempt(now + t3510Ms, i));
+                continue;
+            }
+
+            amf.registerUe(1 + i, 1000000000ULL + i, 350000000000ULL + i);
+            result.latencyUs.push_back(static_cast<uint64_t>((doneMs - firstAttempt[i]) * 1000));
+            result.lastMs = std::max(result.lastMs, doneMs);
+        }
+
+        result.registered = amf.getRegisteredUeCount();
+        if (result.latencyUs.empty()) {
+            result.latencyUs.push_back(0);
+        }
+        return result;
+    }
+
+    struct SessionRates {
+        double establishPerSec;
+        double releasePerSec;
+    };
+
+    struct UpfRunResult {
+        double mpps;
+        double gbps;
+        uint64_t p50Ns;
+        uint64_t p99Ns;
+    };
+
+    std::mt19937 rng_;
+
+    void printHeader(const std::string& title) {
+        std::cout << "\n================== " << title << " ==================\n";
+    }
+
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+
+    // Workers == 0 runs the shard inline on the calling thread
+    UpfRunResult runUpfWorkers(uint32_t workers, uint32_t sessionCount, size_t packetCount,
+                               const std::vector<PacketDetectionRule>& rules,
+                               const std::vector<FiveTuple>& flows) {
+        const uint32_t shards = std::max(workers, 1u);
+        const size_t packetsPerShard = packetCount / shards;
+        const uint32_t sessionsPerShard = sessionCount / shards;
+        const uint32_t sampleMask = 63;  // Time one packet in 64
+
+        std::vector<std::vector<uint64_t>> samples(shards);
+        std::vector<uint64_t> bytes(shards, 0);
+        std::atomic<uint32_t> ready(0);
+        std::atomic<bool> go(false);
+
+        auto shardMain = [&](uint32_t shard) {
+            // Per-worker state is built before the clock starts
+            UPF upf;
+            for (uint32_t s = 0; s < sessionsPerShard; ++s) {
+                SessionId sessionId = 100000 + shard * sessionsPerShard + s;
+                upf.attachPduSession(sessionId, sessionId);
+                upf.setUsageReportingRule(sessionId, DEFAULT_URR_VOLUME_THRESHOLD,
+                                          std::chrono::milliseconds(0));
+                upf.installPacketDetectionRules(sessionId, rules);
+            }
+
+            std::mt19937 rng(1000 + shard);
+            std::vector<uint32_t> trace(packetsPerShard);
+            for (auto& entry : trace) {
+                entry = rng();
+            }
+            samples[shard].reserve(packetsPerShard / (sampleMask + 1) + 1);
+
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            uint64_t shardBytes = 0;
+            for (size_t i = 0; i < packetsPerShard; ++i) {
+                uint32_t r = trace[i];
+                SessionId sessionId = 100000 + shard * sessionsPerShard + (r % sessionsPerShard);
+                const FiveTuple& tuple = flows[(r >> 12) % flows.size()];
+                uint32_t size = 64 + (r >> 20) % 1437;
+                bool uplink = (r & 0x80000000u) != 0;
+
+                if ((i & sampleMask) == 0) {
+                    auto start = std::chrono::steady_clock::now();
+                    forwardSyntheticPacket(upf, sessionId, tuple, size, uplink);
+                    samples[shard].push_back(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count()));
+                } else {
+                    forwardSyntheticPacket(upf, sessionId, tuple, size, uplink);
+                }
+                shardBytes += size;
+            }
+            bytes[shard] = shardBytes;
+        };
+
+        std::chrono::steady_clock::time_point start;
+        if (workers == 0) {
+            go.store(true);
+            start = std::chrono::steady_clock::now();
+            shardMain(0);
+        } else {
+            std::vector<std::thread> threads;
+            for (uint32_t w = 0; w < workers; ++w) {
+                threads.emplace_back(shardMain, w);
+            }
+            while (ready.load() < workers) {
+                std::this_thread::yield();
+            }
+            start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+        double ms = elapsedMs(start);
+
+        std::vector<uint64_t> latencies;
+        uint64_t totalBytes = 0;
+        for (uint32_t shard = 0; shard < shards; ++shard) {
+            latencies.insert(latencies.end(), samples[shard].begin(), samples[shard].end());
+            totalBytes += bytes[shard];
+        }
+
+        UpfRunResult result;
+        result.mpps = (packetsPerShard * shards) / (ms * 1000.0);
+        result.gbps = totalBytes * 8.0 / (ms * 1e6);
+        result.p50Ns = percentile(latencies, 0.50);
+        result.p99Ns = percentile(latencies, 0.99);
+        return result;
+    }
+
+    static void forwardSyntheticPacket(UPF& upf, SessionId sessionId, const FiveTuple& tuple,
+                                       uint32_t size, bool uplink) {
+        if (uplink) {
+            upf.forwardUplinkPacket(sessionId, tuple, size);
+        } else {
+            upf.forwardDownlinkPacket(sessionId, tuple, size);
+        }
+    }
+
+    static uint64_t percentile(std::vector<uint64_t>& values, double fraction) {
+        if (values.empty()) {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(fraction * (values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+
+    static size_t residentBytes() {
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0;
+        size_t resident = 0;
+        statm >> pages >> resident;
+        return resident * 4096;
+    }
+
+    void printPoolPhase(const std::string& phase, size_t ops, double ms, const IpPool& pool) {
+        std::cout << std::setw(30) << std::left << phase << std::right
+                  << " | Ops=" << std::setw(8) << ops
+                  << " | " << std::fixed << std::setprecision(1) << (ms * 1e6 / ops) << "ns/op"
+                  << " | " << std::setprecision(2) << (ops / (ms * 1000.0)) << "Mops/s"
+                  << " | Allocated=" << pool.getIpv4Allocated("internet") << "\n";
+    }
+
+    std::string randomLabel(size_t length) {
+        static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+        std::string label(length, 'a');
+        for (auto& c : label) {
+            c = alphabet[rng_() % (sizeof(alphabet) - 1)];
+        }
+        return label;
+    }
+
+    std::vector<uint8_t> buildHttpRequest(const std::string& host) {
+        std::string request = "GET /index.html HTTP/1.1\r\nUser-Agent: bench/1.0\r\n"
+                              "Accept: */*\r\nHost: " + host + ":80\r\nConnection: keep-alive\r\n\r\n";
+        return std::vector<uint8_t>(request.begin(), request.end());
+    }
+
+    // Minimal TLS 1.2 ClientHello with an SNI extension between two others
+    std::vector<uint8_t> buildClientHello(const std::string& host) {
+        std::vector<uint8_t> body = {0x03, 0x03};
+        for (int i = 0; i < 32; ++i) body.push_back(static_cast<uint8_t>(rng_()));  // random
+        body.push_back(32);
+        for (int i = 0; i < 32; ++i) body.push_back(static_cast<uint8_t>(rng_()));  // session id
+        body.push_back(0x00);
+        body.push_back(32);
+        for (int i = 0; i < 32; ++i) body.push_back(static_cast<uint8_t>(0x13 + i % 3));  // suites
+        body.push_back(0x01);
+        body.push_back(0x00);  // null compression
+
+        std::vector<uint8_t> extensions = {0x00, 0x0b, 0x00, 0x02, 0x01, 0x00};  // ec_point_formats
+        size_t n = host.size();
+        uint8_t sni[] = {0x00, 0x00, static_cast<uint8_t>((n + 5) >> 8), static_cast<uint8_t>(n + 5),
+                         static_cast<uint8_t>((n + 3) >> 8), static_cast<uint8_t>(n + 3), 0x00,
+                         static_cast<uint8_t>(n >> 8), static_cast<uint8_t>(n)};
+        extensions.insert(extensions.end(), sni, sni + sizeof(sni));
+        extensions.insert(extensions.end(), host.begin(), host.end());
+        uint8_t versions[] = {0x00, 0x2b, 0x00, 0x03, 0x02, 0x03, 0x04};  // supported_versions
+        extensions.insert(extensions.end(), versions, versions + sizeof(versions));
+
+        body.push_back(static_cast<uint8_t>(extensions.size() >> 8));
+        body.push_back(static_cast<uint8_t>(extensions.size()));
+        body.insert(body.end(), extensions.begin(), extensions.end());
+
+        size_t handshakeLength = body.size();
+        size_t recordLength = handshakeLength + 4;
+        std::vector<uint8_t> record = {0x16, 0x03, 0x01,
+                                       static_cast<uint8_t>(recordLength >> 8),
+                                       static_cast<uint8_t>(recordLength),
+                                       0x01,
+                                       static_cast<uint8_t>(handshakeLength >> 16),
+                                       static_cast<uint8_t>(handshakeLength >> 8),
+                                       static_cast<uint8_t>(handshakeLength)};
+        record.insert(record.end(), body.begin(), body.end());
+        return record;
+    }
+
+    uint32_t randomPrefix(uint8_t prefixLen) {
+        uint32_t value = rng_();
+        return prefixLen == 0 ? 0 : value & (0xFFFFFFFFu << (32 - prefixLen));
+    }
+
+    // Rule mix modelled on operator SDF templates: a handful of destination
+    // prefix lengths, well-known service ports, ephemeral port ranges and a
+    // catch-all default rule with the worst precedence.
+    std::vector<PacketDetectionRule> generateRuleSet(uint32_t count) {
+        static const uint8_t dstPrefixLens[] = {8, 16, 20, 24, 24, 24, 28, 32, 32};
+        static const uint16_t servicePorts[] = {53, 80, 123, 443, 443, 1935, 3478, 5060, 8080, 8443};
+        static const uint8_t protocols[] = {6, 6, 17, 0};
+
+        std::vector<PacketDetectionRule> rules;
+        rules.reserve(count);
+        uint32_t ueIp = 0x0A000001;  // 10.0.0.1
+
+        for (uint32_t i = 0; i + 1 < count; ++i) {
+            PacketDetectionRule rule;
+            rule.pdrId = i + 1;
+            rule.precedence = 10 + i;
+            rule.farId = 1 + (i % 4);
+            rule.qfi = static_cast<uint8_t>(1 + (i % 9));
+
+            SdfFilter& filter = rule.filter;
+            bool uePinned = (rng_() % 4) == 0;
+            filter.srcIp = uePinned ? ueIp : 0;
+            filter.srcPrefixLen = uePinned ? 32 : 0;
+            filter.dstPrefixLen = dstPrefixLens[rng_() % sizeof(dstPrefixLens)];
+            filter.dstIp = randomPrefix(filter.dstPrefixLen);
+            filter.protocol = protocols[rng_() % sizeof(protocols)];
+
+            uint32_t portKind = rng_() % 10;
+            if (portKind < 6) {
+                uint16_t port = servicePorts[rng_() % (sizeof(servicePorts) / sizeof(servicePorts[0]))];
+                filter.dstPortLow = port;
+                filter.dstPortHigh = port;
+            } else if (portKind < 8) {
+                filter.dstPortLow = 1024;
+                filter.dstPortHigh = 65535;
+            } else {
+                uint16_t low = static_cast<uint16_t>(rng_() % 60000);
+                filter.dstPortLow = low;
+                filter.dstPortHigh = static_cast<uint16_t>(low + rng_() % 2000);
+            }
+            filter.srcPortLow = 0;
+            filter.srcPortHigh = 65535;
+
+            rules.push_back(rule);
+        }
+
+        PacketDetectionRule defaultRule;
+        defaultRule.pdrId = count;
+        defaultRule.precedence = 0xFFFF;
+        defaultRule.filter = SdfFilter{0, 0, 0, 0, 0, 65535, 0, 65535, 0};
+        defaultRule.farId = 1;
+        defaultRule.qfi = 9;
+        rules.push_back(defaultRule);
+
+        return rules;
+    }
+
+    // Half of the packets are aimed at a random rule, the rest are random
+    std::vector<FiveTuple> generatePackets(const std::vector<PacketDetectionRule>& rules, size_t count) {
+        std::vector<FiveTuple> packets;
+        packets.reserve(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            FiveTuple tuple;
+            tuple.srcIp = 0x0A000001;
+            tuple.srcPort = static_cast<uint16_t>(1024 + rng_() % 60000);
+
+            if (i % 2 == 0) {
+                const SdfFilter& filter = rules[rng_() % rules.size()].filter;
+                uint32_t hostBits = filter.dstPrefixLen >= 32 ? 0 : (rng_() >> filter.dstPrefixLen);
+                tuple.dstIp = filter.dstIp | hostBits;
+                uint32_t span = static_cast<uint32_t>(filter.dstPortHigh - filter.dstPortLow) + 1;
+                tuple.dstPort = static_cast<uint16_t>(filter.dstPortLow + rng_() % span);
+                tuple.protocol = filter.protocol != 0 ? filter.protocol : 6;
+            } else {
+                tuple.dstIp = rng_();
+                tuple.dstPort = static_cast<uint16_t>(rng_());
+                tuple.protocol = (rng_() % 2) ? 6 : 17;
+            }
+            packets.push_back(tuple);
+        }
+
+        return packets;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+
+    std::string scenario = argc > 1 ? argv[1] : "all";
+    FiveGBenchmark benchmark;
+
+    if (scenario == "all" || scenario == "classifier") {
+        benchmark.runClassifierBenchmark();
+    }
+    if (scenario == "all" || scenario == "flowcache") {
+        benchmark.runFlowCacheBenchmark();
+    }
+    if (scenario == "all" || scenario == "scheduler") {
+        benchmark.runSchedulerBenchmark();
+    }
+    if (scenario == "all" || scenario == "dpi") {
+        benchmark.runAppDetectionBenchmark();
+    }
+    if (scenario == "all" || scenario == "ippool") {
+        benchmark.runIpPoolBenchmark();
+    }
+    if (scenario == "all" || scenario == "amf") {
+        benchmark.runAmfRegistrationBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "handover") {
+        benchmark.runHandoverBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "timers") {
+        benchmark.runReachabilityTimerBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "registration") {
+        benchmark.runPipelinedRegistrationBenchmark(argc > 2 ? std::stoul(argv[2]) : 100000);
+    }
+    if (scenario == "all" || scenario == "cells") {
+        benchmark.runCellSelectionBenchmark(argc > 2 ? std::stoul(argv[2]) : 50000);
+    }
+    if (scenario == "all" || scenario == "radio") {
+        benchmark.runRadioMeasurementBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "neighbors") {
+        benchmark.runNeighborCellBenchmark(argc > 2 ? std::stoul(argv[2]) : 30000);
+    }
+    if (scenario == "all" || scenario == "storm") {
+        benchmark.runRegistrationStormBenchmark();
+    }
+    if (scenario == "all" || scenario == "paging") {
+        benchmark.runPagingBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "smf") {
+        benchmark.runSessionStoreBenchmark(argc > 2 ? std::stoul(argv[2]) : 10000000);
+    }
+    if (scenario == "all" || scenario == "sessions") {
+        benchmark.runSessionBulkBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "ids") {
+        benchmark.runSessionIdBenchmark(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    }
+    if (scenario == "all" || scenario == "n4") {
+        benchmark.runN4Benchmark(argc > 2 ? std::stoul(argv[2]) : 100000);
+    }
+    if (scenario == "all" || scenario == "counters") {
+        benchmark.runCounterSyncBenchmark(argc > 2 ? std::stoul(argv[2]) : 100000);
+    }
+    if (scenario == "all" || scenario == "upf") {
+        benchmark.runUpfThroughputBenchmark(argc > 2 ? argv[2] : "upf_benchmark.csv");
+    }
+
+    return 0;
+}
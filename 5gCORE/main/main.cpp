@@ -3,6 +3,8 @@
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 
 // Common headers
 #include "common/Types.hpp"
@@ -12,6 +14,8 @@
 // Component headers
 #include "ue/UserEquipment.hpp"
 #include "ran/GNodeB.hpp"
+#include "ran/RadioPropagation.hpp"
+#include "ran/SpatialGrid.hpp"
 #include "nrf/NRF.hpp"
 #include "amf/AMF.hpp"
 #include "smf/SMF.hpp"
@@ -36,6 +40,36 @@ public:
         udr_ = std::make_shared<UDR>();
         udm_ = std::make_shared<UDM>();
 
+        // SMF provisions the UPF over N4; responses and usage reports come back the same way
+        smf_->setN4Sender([this](const uint8_t* data, size_t length) {
+            upf_->handleN4Message(data, length);
+        });
+        upf_->setN4Sender([this](const uint8_t* data, size_t length) {
+            smf_->handleN4Message(data, length);
+        });
+
+        // Registration signalling: AMF <-> UDM <-> UDR, through each NF's queue
+        amf_->setMessageSender(NFType::UDM, [this](std::shared_ptr<Message> message) {
+            udm_->enqueueMessage(message);
+        });
+        udm_->setMessageSender(NFType::UDR, [this](std::shared_ptr<Message> message) {
+            udr_->enqueueMessage(message);
+        });
+        udr_->setMessageSender(NFType::UDM, [this](std::shared_ptr<Message> message) {
+            udm_->enqueueMessage(message);
+        });
+        udm_->setMessageSender(NFType::AMF, [this](std::shared_ptr<Message> message) {
+            amf_->enqueueMessage(message);
+        });
+
+        // Application signatures for app-based charging (app IDs are operator-defined)
+        upf_->installApplicationPatterns({
+            {"youtube.com", 1}, {"googlevideo.com", 1}, {"ytimg.com", 1},
+            {"netflix.com", 2}, {"nflxvideo.net", 2},
+            {"whatsapp.net", 3}, {"whatsapp.com", 3},
+            {"facebook.com", 4}, {"fbcdn.net", 4}
+        });
+
         // Register NF instances in NRF
         registerNFServices();
 
@@ -134,50 +168,142 @@ public:
 
     void createGNodeBs(uint32_t count) {
         std::vector<std::string> locations = {"New York", "Los Angeles", "Chicago", "Houston", "Phoenix"};
+        std::vector<Tac> tacs;
+        radioCellGnb_.assign(1, 0);     // Radio cell 0 is the silent placeholder
 
         for (uint32_t i = 0; i < count; ++i) {
             GnbId gnbId = 2000 + i;
             std::string location = locations[i % locations.size()] + "_gNB_" + std::to_string(i);
 
-            auto gnb = std::make_unique<GNodeB>(gnbId, location);
+            // Neighbouring gNodeBs share a tracking area
+            Tac tac = DEFAULT_TAC + i / 2;
+            auto gnb = std::make_unique<GNodeB>(gnbId, location, tac);
+
+            // Each city is 100 km from the last; its sites sit on a 500 m grid
+            uint32_t site = i / static_cast<uint32_t>(locations.size());
+            gnb->setPosition(Position{(i % locations.size()) * 100000.0f + (site % 8) * 500.0f,
+                                      (site / 8) * 500.0f});
 
             // Add cells to each gNodeB
             for (uint32_t j = 0; j < 3; ++j) {
                 gnb->addCell(gnbId * 100 + j, 100 + j, 3500 + j * 50);
             }
+            for (const CellInfo& cell : gnb->getAllCells()) {
+                uint32_t radioCell = radio_.addCell(cell.cellId, cell.position.x, cell.position.y, 25.0f, 18.0f);
+                cellGrid_.add(radioCell, cell.position);
+                radioCellGnb_.push_back(static_cast<uint32_t>(gnbs_.size()));
+            }
 
+            // NG Setup: the AMF learns the gNodeB's tracking areas
+            amf_->addGnb(gnbId, gnb->getTrackingAreas());
+            tacs.push_back(tac);
             gnbs_.push_back(std::move(gnb));
 
             logger_.info("SIMULATOR", "Created gNodeB: ID=" + std::to_string(gnbId) + 
                                      ", Location=" + location);
         }
+
+        cellGrid_.build();
+
+        // One registration area over all of them
+        tacs.erase(std::unique(tacs.begin(), tacs.end()), tacs.end());
+        amf_->setRegistrationArea(tacs);
     }
 
     void simulateUEAttachment() {
         logger_.info("SIMULATOR", "=== Simulating UE Attachment ===");
 
-        for (size_t i = 0; i < ues_.size() && i < gnbs_.size(); ++i) {
-            // Attach UE to gNodeB
-            ues_[i]->attachToGnb(gnbs_[i % gnbs_.size()]->getGnbId());
-            gnbs_[i % gnbs_.size()]->connectUe(ues_[i]->getUeId());
-
-            // Register UE at AMF
-            amf_->registerUe(ues_[i]->getUeId(), ues_[i]->getImsi(), ues_[i]->getImei());
-            amf_->authenticateUe(ues_[i]->getUeId(), ues_[i]->getImsi());
-            amf_->handleUeAttach(ues_[i]->getUeId(), gnbs_[i % gnbs_.size()]->getGnbId());
+        size_t count = std::min(ues_.size(), gnbs_.size());
 
-            // Store subscription data
+        // Subscriptions are provisioned before any UE shows up
+        for (size_t i = 0; i < count; ++i) {
             SubscriptionData subData;
             subData.imsi = ues_[i]->getImsi();
             subData.msisdn = ues_[i]->getPhoneNumber();
             subData.accessRestrictionData = false;
             udr_->storeSubscriptionData(ues_[i]->getImsi(), subData);
+        }
 
-            // Set UE to registered state
-            ues_[i]->registerAtCore();
+        // All attach requests go out at once; AMF, UDM and UDR work through
+        // them concurrently on their own threads
+        udr_->startWorker();
+        udm_->startWorker();
+        amf_->startWorker();
+        std::vector<size_t> serving = measureCells(count);
+        for (size_t i = 0; i < count; ++i) {
+            GNodeB& gnb = *gnbs_[serving[i]];
+            ues_[i]->attachToGnb(gnb.getGnbId());
+            gnb.connectUe(ues_[i]->getUeId(), cellRsrp(i, gnb));
+            amf_->enqueueMessage(std::make_shared<AttachRequestMessage>(
+                ues_[i]->getUeId(), ues_[i]->getImsi(), ues_[i]->getImei(), gnb.getGnbId()));
+        }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::vector<RegistrationResult> results;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (results.size() < count && std::chrono::steady_clock::now() < deadline) {
+            if (amf_->collectRegistrationResults(results) == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        amf_->stopWorker();
+        udm_->stopWorker();
+        udr_->stopWorker();
+
+        for (const RegistrationResult& result : results) {
+            for (size_t i = 0; i < count; ++i) {
+                if (ues_[i]->getUeId() == result.ueId && result.accepted) {
+                    ues_[i]->setGuti(result.guti);
+                    ues_[i]->registerAtCore();
+                }
+            }
         }
+        logger_.info("SIMULATOR", "Registrations completed: " + std::to_string(results.size()) + "/" + 
+                                 std::to_string(count) + " | avg latency " + 
+                                 std::to_string(static_cast<uint64_t>(amf_->getRegistrationLatency().averageUs())) + 
+                                 " us");
+    }
+
+    // Drops the first count UEs near gNB i % gNBs, measures the cells
+    // nearest to each, and returns the index of each UE's strongest gNB
+    std::vector<size_t> measureCells(size_t count) {
+        std::vector<size_t> serving(count);
+        uint32_t neighbors[RadioPropagation::NEIGHBORS];
+        size_t first = radio_.getUeCount();
+        for (size_t i = 0; i < count; ++i) {
+            serving[i] = i % gnbs_.size();
+            Position site = gnbs_[serving[i]]->getPosition();
+            Position position = {site.x + 150.0f * std::cos(i * 2.4f), site.y + 150.0f * std::sin(i * 2.4f)};
+            uint32_t ue = radio_.addUe(position.x, position.y);
+            size_t found = cellGrid_.queryNearest(position, RadioPropagation::NEIGHBORS, neighbors);
+            radio_.setNeighbors(ue, neighbors, static_cast<uint32_t>(found));
+        }
+        radio_.measure();
+
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t best = radio_.getBestCell(static_cast<uint32_t>(first + i));
+            if (best != RadioPropagation::NO_CELL) {
+                serving[i] = radioCellGnb_[best];
+            }
+        }
+        ueRadioBase_ = first;
+        return serving;
+    }
+
+    // The UE's latest RSRP for each of the gNB's cells, in cell order
+    std::vector<float> cellRsrp(size_t i, GNodeB& gnb) const {
+        uint32_t ue = static_cast<uint32_t>(ueRadioBase_ + i);
+        std::vector<float> rsrp;
+        for (const CellInfo& cell : gnb.getAllCells()) {
+            float value = RadioPropagation::MIN_RSRP_DBM;
+            for (uint32_t k = 0; k < RadioPropagation::NEIGHBORS; ++k) {
+                uint32_t radioCell = radio_.getNeighbor(ue, k);
+                if (radioCell != RadioPropagation::NO_CELL && radio_.getCellId(radioCell) == cell.cellId) {
+                    value = radio_.getRsrp(ue, k);
+                }
+            }
+            rsrp.push_back(value);
+        }
+        return rsrp;
     }
 
     void simulatePDUSessionEstablishment() {
@@ -185,14 +311,25 @@ public:
 
         for (size_t i = 0; i < ues_.size() && i <= 2; ++i) {  // Create sessions for first 3 UEs
             SessionId sessionId = smf_->createPduSession(ues_[i]->getUeId(), "internet", 0);
-            smf_->activatePduSession(sessionId);
 
             // Create policy in PCF
             std::string policyId = pcf_->createPolicy(ues_[i]->getUeId(), sessionId, 10000, 9);
 
-            // Attach session to UPF
-            upf_->attachPduSession(sessionId, ues_[i]->getUeId());
-            upf_->setQoS(sessionId, 10000);  // 10 Mbps
+            // User-plane rules travel to the UPF over N4: 10 Mbps, downlink
+            // egress scheduled with the 5QI and priority PCF assigned, 200 ms URR period
+            N4SessionRules rules;
+            rules.qosRateKbps = 10000;
+            rules.qfi = DEFAULT_QFI;
+            rules.fiveQi = DEFAULT_FIVE_QI;
+            rules.priorityLevel = QosScheduler::defaultPriorityLevel(DEFAULT_FIVE_QI);
+            rules.urrVolumeThreshold = DEFAULT_URR_VOLUME_THRESHOLD;
+            rules.urrTimeThresholdMs = 200;
+            PCF::PolicyRule* policy = pcf_->getPolicy(policyId);
+            if (policy) {
+                rules.fiveQi = policy->fiveQi;
+                rules.priorityLevel = policy->priorityLevel;
+            }
+            smf_->activatePduSession(sessionId, rules);
 
             ues_[i]->createSession(sessionId);
             ues_[i]->activateSession(sessionId);
@@ -202,24 +339,110 @@ public:
 
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+
+        // All establishments reach the UPF in one N4 bundle
+        smf_->flushN4Requests();
     }
 
     void simulateDataTransfer() {
         logger_.info("SIMULATOR", "=== Simulating Data Transfer ===");
 
         for (size_t i = 0; i < ues_.size() && i <= 2; ++i) {
+            SessionId sessionId = ues_[i]->getCurrentSessionId();
+
             // Simulate uplink data transfer
             uint32_t dataSize = 1024 * (rand() % 100);  // 0-100 KB
-            ues_[i]->sendData(i + 5000, dataSize);
-
-            // Record in UPF
-            upf_->forwardUplinkPacket(i + 5000, dataSize);
+            ues_[i]->sendData(sessionId, dataSize);
 
-            // Record charging event in PCF
-            pcf_->recordChargingEvent(ues_[i]->getUeId(), i + 5000, dataSize);
+            // Record in UPF; usage is accounted against the session's URR.
+            // The transfer opens with an HTTP request the UPF inspects
+            static const char* hosts[] = {"www.youtube.com", "api.netflix.com", "web.whatsapp.com"};
+            std::string request = std::string("GET / HTTP/1.1\r\nHost: ") + hosts[i % 3] + "\r\n\r\n";
+            FiveTuple tuple{0x0A000001u + static_cast<uint32_t>(i), 0x08080808u,
+                            static_cast<uint16_t>(40000 + i), 80, 6};
+            upf_->forwardUplinkPacket(sessionId, tuple, dataSize,
+                                      reinterpret_cast<const uint8_t*>(request.data()), request.size());
 
             std::this_thread::sleep_for(std::chrono::milliseconds(50));
         }
+
+        // Reporting periods end after the transfer; one batched usage report
+        // then covers every session with unreported usage
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        auto usageReport = upf_->collectUsageReports();
+        if (usageReport) {
+            upf_->sendUsageReports(usageReport->getReports());
+            pcf_->handleMessage(usageReport);
+        }
+
+        // Traffic of detected applications is charged per app
+        for (const auto& usage : upf_->collectApplicationUsage()) {
+            pcf_->recordChargingEvent(usage.ueId, usage.sessionId, usage.bytes, usage.appId);
+        }
+    }
+
+    void simulateIdleModeDownlink() {
+        logger_.info("SIMULATOR", "=== Simulating Downlink Data for Idle UE ===");
+
+        if (ues_.empty() || ues_[0]->getCurrentSessionId() == 0) return;
+
+        auto& ue = ues_[0];
+        SessionId sessionId = ue->getCurrentSessionId();
+
+        // UE goes idle: the AMF keeps its last location, and the UPF
+        // buffers downlink data instead of forwarding it
+        GnbId lastGnb = ue->getConnectedGnb();
+        ue->setState(UeState::IDLE);
+        amf_->handleUeDetach(ue->getUeId());
+        smf_->setDownlinkBuffering(sessionId, true);
+        smf_->flushN4Requests();
+
+        for (int i = 0; i < 5; ++i) {
+            upf_->forwardDownlinkPacket(sessionId, 1500);
+        }
+
+        // Notification travels UPF -> SMF -> AMF, which pages the UE
+        for (const auto& notification : upf_->collectDownlinkDataNotifications()) {
+            smf_->handleMessage(notification);
+            amf_->handleMessage(notification);
+        }
+
+        // Next paging tick: one paging message per gNodeB. The UE hears its
+        // 5G-TMSI and answers with a service request; buffered data is
+        // delivered
+        bool paged = false;
+        for (const auto& message : amf_->runPagingTick()) {
+            auto paging = std::dynamic_pointer_cast<PagingMessage>(message);
+            for (auto& gnb : gnbs_) {
+                if (paging && gnb->getGnbId() == paging->getDestId()) {
+                    gnb->receivePaging(*paging);
+                    const auto& tmsis = paging->getTmsis();
+                    paged |= gnb->getGnbId() == lastGnb &&
+                             std::find(tmsis.begin(), tmsis.end(), ue->getGuti().tmsi) != tmsis.end();
+                }
+            }
+        }
+        if (!paged) {
+            logger_.warning("SIMULATOR", "Idle UE was not paged");
+            return;
+        }
+        amf_->handleServiceRequestByTmsi(ue->getGuti().tmsi);
+        amf_->handleUeAttach(ue->getUeId(), lastGnb);
+        ue->setState(UeState::CONNECTED);
+        uint32_t buffered = upf_->getBufferedPacketCount(sessionId);
+        smf_->setDownlinkBuffering(sessionId, false);
+        smf_->flushN4Requests();
+        upf_->runEgressScheduler(buffered);
+        ue->receiveData(sessionId, buffered * 1500);
+    }
+
+    void syncTrafficCounters() {
+        // One counter epoch: only sessions with new traffic are sent to the SMF
+        size_t sessions = upf_->publishCounterDeltas();
+        logger_.info("SIMULATOR", "Traffic counters synced | Epoch=" + 
+                                 std::to_string(upf_->getCounterEpoch()) + 
+                                 " | Sessions=" + std::to_string(sessions));
     }
 
     void printSimulatorStatus() {
@@ -334,6 +557,10 @@ private:
 
     std::vector<std::unique_ptr<UserEquipment>> ues_;
     std::vector<std::unique_ptr<GNodeB>> gnbs_;
+    SpatialGrid cellGrid_;                  // Radio cell index by site position
+    RadioPropagation radio_;
+    std::vector<uint32_t> radioCellGnb_;    // Radio cell index -> gnbs_ index
+    size_t ueRadioBase_ = 0;
 
     Logger& logger_ = Logger::getInstance();
 };
@@ -358,6 +585,11 @@ int main() {
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
     simulator.simulateDataTransfer();
+    simulator.syncTrafficCounters();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    simulator.simulateIdleModeDownlink();
+    simulator.syncTrafficCounters();
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
     // Display status
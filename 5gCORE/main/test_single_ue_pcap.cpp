@@ -351,6 +351,56 @@ public:
         }
     }
 
+    // The UPF inspects only a flow's opening uplink packet, so the rest of
+    // the flow, and its downlink, must be charged to the app found there
+    bool verifyApplicationCharging() {
+        logger_.info("TEST", "=== Verifying Application Charging ===");
+
+        UPF upf;
+        upf.installApplicationPatterns({{"youtube.com", 1}});
+        upf.attachPduSession(7001, 1);
+
+        std::string request = "GET / HTTP/1.1\r\nHost: www.youtube.com\r\n\r\n";
+        FiveTuple uplink{0x0A000001u, 0x08080808u, 40000, 80, 6};
+        FiveTuple downlink{uplink.dstIp, uplink.srcIp, uplink.dstPort, uplink.srcPort, uplink.protocol};
+        upf.forwardUplinkPacket(7001, uplink, 1000,
+                                reinterpret_cast<const uint8_t*>(request.data()), request.size());
+        for (int i = 0; i < 2; ++i) {
+            upf.forwardUplinkPacket(7001, uplink, 500, nullptr, 0);
+        }
+        for (int i = 0; i < 3; ++i) {
+            upf.forwardDownlinkPacket(7001, downlink, 1400, nullptr, 0);
+        }
+
+        // Names that only contain the pattern must not be charged to the app
+        uint16_t port = 40001;
+        for (const char* host : {"notyoutube.com", "youtube.com.evil.net"}) {
+            std::string lookalike = std::string("GET / HTTP/1.1\r\nHost: ") + host + "\r\n\r\n";
+            FiveTuple flow{uplink.srcIp, uplink.dstIp, port++, 80, 6};
+            upf.forwardUplinkPacket(7001, flow, 900,
+                                    reinterpret_cast<const uint8_t*>(lookalike.data()), lookalike.size());
+        }
+
+        PCF pcf;
+        uint64_t charged = 0;
+        for (const auto& usage : upf.collectApplicationUsage()) {
+            if (usage.sessionId == 7001 && usage.appId == 1) {
+                charged += usage.bytes;
+                pcf.recordChargingEvent(1, usage.sessionId, usage.bytes, usage.appId);
+            }
+        }
+        // Per-packet usage adds up to well under a MB: a single unit
+        for (int i = 0; i < 10; ++i) {
+            pcf.recordChargingEvent(1, 7001, 1400, 1);
+        }
+
+        const uint64_t expected = 1000 + 2 * 500 + 3 * 1400;
+        logger_.info("TEST", "Application bytes charged: " + std::to_string(charged) +
+                             " | Expected: " + std::to_string(expected) +
+                             " | Units: " + std::to_string(pcf.getApplicationCharge(1, 1)));
+        return charged == expected && pcf.getApplicationCharge(1, 1) == 1;
+    }
+
     void logToPcap(const std::string& source, const std::string& dest, 
                    const std::string& msgType, const std::string& details) {
         uint32_t src_id = hashString(source);
@@ -482,6 +532,13 @@ int main() {
     test_simulator.simulateDataTransfer();
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
+    std::cout << "\n[*] Verifying Application Charging...\n";
+    if (!test_simulator.verifyApplicationCharging()) {
+        std::cout << "\n[✗] Application bytes were not charged to the detected app\n";
+        test_simulator.shutdown();
+        return 1;
+    }
+
     // Display results
     test_simulator.printTestSummary();
 
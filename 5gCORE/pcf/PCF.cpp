@@ -10,7 +10,8 @@ PCF::PCF() : NetworkFunction(NFType::PCF, "PCF") {
     logger_.info(name_, "PCF initialized");
 }
 
-std::string PCF::createPolicy(UeId ueId, SessionId sessionId, uint32_t bitrate, uint32_t priority) {
+std::string PCF::createPolicy(UeId ueId, SessionId sessionId, uint32_t bitrate, uint32_t priority,
+                              uint8_t fiveQi) {
     std::string policyId = generatePolicyId();
 
     PolicyRule policy;
@@ -19,6 +20,7 @@ std::string PCF::createPolicy(UeId ueId, SessionId sessionId, uint32_t bitrate,
     policy.sessionId = sessionId;
     policy.maxBitrate = bitrate;
     policy.priorityLevel = priority;
+    policy.fiveQi = fiveQi;
     policy.isActive = true;
 
     policies_[policyId] = policy;
@@ -77,6 +79,46 @@ void PCF::recordChargingEvent(UeId ueId, SessionId sessionId, uint64_t bytes) {
                         " | Charge=" + std::to_string(charge));
 }
 
+void PCF::recordChargingEvent(UeId ueId, SessionId sessionId, uint64_t bytes, AppId appId) {
+    if (appId == APP_UNKNOWN) {
+        recordChargingEvent(ueId, sessionId, bytes);
+        return;
+    }
+
+    // Detected applications are rated on their own record; session volume
+    // charging from usage reports is unaffected. Like usage reports, an
+    // app's volume is rated as one running total, a unit per started MB
+    auto key = std::make_pair(ueId, appId);
+    uint64_t& reported = appReportedBytes_[key];
+    uint64_t before = (reported + 999999) / 1000000;
+    reported += bytes;
+    uint64_t charge = (reported + 999999) / 1000000 - before;
+    appChargeRecords_[key] += charge;
+
+    logger_.debug(name_, "Application Charging Event | UE=" + std::to_string(ueId) + 
+                        " | Session=" + std::to_string(sessionId) + 
+                        " | App=" + std::to_string(appId) + 
+                        " | Bytes=" + std::to_string(bytes) + 
+                        " | Charge=" + std::to_string(charge));
+}
+
+void PCF::recordUsageReports(const std::vector<UsageReport>& reports) {
+    // A UE's reported volume is rated as one running total, a unit per
+    // started MB, so splitting usage over many reports costs nothing extra
+    uint64_t totalBytes = 0;
+    for (const auto& report : reports) {
+        uint64_t bytes = report.ulBytes + report.dlBytes;
+        uint64_t& reported = reportedBytes_[report.ueId];
+        uint64_t before = (reported + 999999) / 1000000;
+        reported += bytes;
+        chargeRecords_[report.ueId] += (reported + 999999) / 1000000 - before;
+        totalBytes += bytes;
+    }
+
+    logger_.debug(name_, "Usage reports charged | Sessions=" + std::to_string(reports.size()) + 
+                        " | Bytes=" + std::to_string(totalBytes));
+}
+
 uint64_t PCF::getTotalCharge(UeId ueId) const {
     auto it = chargeRecords_.find(ueId);
     if (it != chargeRecords_.end()) {
@@ -85,6 +127,14 @@ uint64_t PCF::getTotalCharge(UeId ueId) const {
     return 0;
 }
 
+uint64_t PCF::getApplicationCharge(UeId ueId, AppId appId) const {
+    auto it = appChargeRecords_.find(std::make_pair(ueId, appId));
+    if (it != appChargeRecords_.end()) {
+        return it->second;
+    }
+    return 0;
+}
+
 void PCF::handleMessage(std::shared_ptr<Message> message) {
     if (!message) return;
 
@@ -98,6 +148,13 @@ void PCF::handleMessage(std::shared_ptr<Message> message) {
             }
             break;
         }
+        case MessageType::USAGE_REPORT: {
+            auto reportMsg = std::dynamic_pointer_cast<UsageReportMessage>(message);
+            if (reportMsg) {
+                recordUsageReports(reportMsg->getReports());
+            }
+            break;
+        }
         default:
             logger_.warning(name_, "Unknown message type");
             break;
@@ -131,7 +188,8 @@ std::string PCF::getPCFStatus() const {
     std::ostringstream oss;
     oss << "PCF Status:\n"
         << "  Active Policies: " << activePolicies_.size() << "\n"
-        << "  Charge Records: " << chargeRecords_.size() << "\n";
+        << "  Charge Records: " << chargeRecords_.size() << "\n"
+        << "  Application Charge Records: " << appChargeRecords_.size() << "\n";
     return oss.str();
 }
 
@@ -157,6 +215,9 @@ void PCF::stop() {
     NetworkFunction::stop();
     policies_.clear();
     chargeRecords_.clear();
+    reportedBytes_.clear();
+    appChargeRecords_.clear();
+    appReportedBytes_.clear();
     activePolicies_.clear();
     logger_.info(name_, "PCF stopped");
 }
@@ -17,18 +17,23 @@ public:
         SessionId sessionId;
         uint32_t maxBitrate;
         uint32_t priorityLevel;
+        uint8_t fiveQi;             // QoS characteristics of the session's flow
         bool isActive;
     };
 
     // Policy Management
-    std::string createPolicy(UeId ueId, SessionId sessionId, uint32_t bitrate, uint32_t priority);
+    std::string createPolicy(UeId ueId, SessionId sessionId, uint32_t bitrate, uint32_t priority,
+                             uint8_t fiveQi = DEFAULT_FIVE_QI);
     bool updatePolicy(const std::string& policyId, uint32_t newBitrate);
     bool removePolicy(const std::string& policyId);
     PolicyRule* getPolicy(const std::string& policyId);
 
     // Charging Management
     void recordChargingEvent(UeId ueId, SessionId sessionId, uint64_t bytes);
+    void recordChargingEvent(UeId ueId, SessionId sessionId, uint64_t bytes, AppId appId);
+    void recordUsageReports(const std::vector<UsageReport>& reports);
     uint64_t getTotalCharge(UeId ueId) const;
+    uint64_t getApplicationCharge(UeId ueId, AppId appId) const;
 
     // Message Handling
     void handleMessage(std::shared_ptr<Message> message) override;
@@ -44,6 +49,9 @@ public:
 private:
     std::map<std::string, PolicyRule> policies_;
     std::map<UeId, uint64_t> chargeRecords_;
+    std::map<UeId, uint64_t> reportedBytes_;     // Usage-report volume, rated as one total
+    std::map<std::pair<UeId, AppId>, uint64_t> appChargeRecords_;
+    std::map<std::pair<UeId, AppId>, uint64_t> appReportedBytes_;   // Rated as one total per app
     std::set<std::string> activePolicies_;
 
     std::string generatePolicyId();
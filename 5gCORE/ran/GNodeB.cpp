@@ -3,20 +3,38 @@
 #include <sstream>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
 
-GNodeB::GNodeB(GnbId gnbId, const std::string& location)
-    : gnbId_(gnbId), location_(location), state_(GnbState::ACTIVE),
-      totalUlTraffic_(0), totalDlTraffic_(0) {
+GNodeB::GNodeB(GnbId gnbId, const std::string& location, Tac tac)
+    : gnbId_(gnbId), location_(location), state_(GnbState::ACTIVE), tac_(tac), position_{0, 0},
+      capacity_{3, 1000, 0},
+      totalUlTraffic_(0), totalDlTraffic_(0), pagingMessages_(0), pagingRecords_(0) {
     logger_.info("RAN", "Creating gNodeB: ID=" + std::to_string(gnbId) + 
                         ", Location=" + location);
 }
 
+void GNodeB::setCapacity(const GnbCapacity& capacity) {
+    capacity_ = capacity;
+    capacity_.maxCells = std::min(capacity_.maxCells, MAX_CELLS);
+    capacity_.maxUes = std::min(capacity_.maxUes, POSITION_MASK);
+    ueIndex_.reserve(capacity_.maxUes);
+}
+
 void GNodeB::addCell(uint32_t cellId, uint32_t pci, uint32_t frequency) {
-    if (cells_.size() >= 3) {  // Max 3 cells per gNodeB in this simulation
+    addCell(cellId, pci, frequency, tac_);
+}
+
+void GNodeB::addCell(uint32_t cellId, uint32_t pci, uint32_t frequency, Tac tac) {
+    if (cells_.size() >= capacity_.maxCells) {
         logger_.warning("RAN", "gNodeB " + std::to_string(gnbId_) + 
                                " already has maximum cells");
         return;
     }
+    if (cellIndex_.find(cellId) != DenseIndex::NOT_FOUND) {
+        logger_.warning("RAN", "gNodeB " + std::to_string(gnbId_) + 
+                               " already has cell " + std::to_string(cellId));
+        return;
+    }
 
     CellInfo cell;
     cell.cellId = cellId;
@@ -24,67 +42,184 @@ void GNodeB::addCell(uint32_t cellId, uint32_t pci, uint32_t frequency) {
     cell.frequency = frequency;
     cell.rsrp = -70.0f + (rand() % 30);
     cell.rsrq = -5.0f + (rand() % 15);
+    cell.tac = tac;
+    cell.position = position_;      // Sectors share the site
 
+    cellIndex_.insert(cellId, static_cast<uint32_t>(cells_.size()));
     cells_.push_back(cell);
+    cellUes_.emplace_back();
 
-    logger_.info("RAN", "gNodeB " + std::to_string(gnbId_) + 
-                        " added cell: ID=" + std::to_string(cellId) +
-                        ", PCI=" + std::to_string(pci) +
-                        ", Freq=" + std::to_string(frequency) + "MHz");
+    // UEs that connected while there was no cell move into one; those
+    // that find no room stay where they are, compacted
+    size_t kept = 0;
+    for (size_t i = 0; i < uncelledUes_.size(); ++i) {
+        UeId ueId = uncelledUes_[i];
+        uint32_t slot = selectCell(nullptr);
+        uint32_t entry;
+        if (slot == DenseIndex::NOT_FOUND) {
+            entry = NO_CELL << POSITION_BITS | static_cast<uint32_t>(kept);
+            uncelledUes_[kept++] = ueId;
+        } else {
+            entry = slot << POSITION_BITS | static_cast<uint32_t>(cellUes_[slot].size());
+            cellUes_[slot].push_back(ueId);
+        }
+        ueIndex_.erase(ueId);
+        ueIndex_.insert(ueId, entry);
+    }
+    uncelledUes_.resize(kept);
+
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info("RAN", "gNodeB " + std::to_string(gnbId_) + 
+                            " added cell: ID=" + std::to_string(cellId) +
+                            ", PCI=" + std::to_string(pci) +
+                            ", Freq=" + std::to_string(frequency) + "MHz" +
+                            ", TAC=" + std::to_string(tac));
+    }
 }
 
-CellInfo* GNodeB::getCell(uint32_t cellId) {
-    for (auto& cell : cells_) {
-        if (cell.cellId == cellId) {
-            return &cell;
+void GNodeB::setPosition(Position position) {
+    position_ = position;
+    for (CellInfo& cell : cells_) {
+        cell.position = position;
+    }
+}
+
+std::vector<Tac> GNodeB::getTrackingAreas() const {
+    std::vector<Tac> tacs;
+    for (const auto& cell : cells_) {
+        if (std::find(tacs.begin(), tacs.end(), cell.tac) == tacs.end()) {
+            tacs.push_back(cell.tac);
         }
     }
-    return nullptr;
+    if (tacs.empty()) {
+        tacs.push_back(tac_);
+    }
+    return tacs;
+}
+
+void GNodeB::receivePaging(const PagingMessage& paging) {
+    pagingMessages_++;
+    pagingRecords_ += paging.getTmsis().size();
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info("RAN", "gNodeB " + std::to_string(gnbId_) + " paging " + 
+                            std::to_string(paging.getTmsis().size()) + " UE(s) in " + 
+                            std::to_string(cells_.size()) + " cell(s)");
+    }
 }
 
-void GNodeB::connectUe(UeId ueId) {
+CellInfo* GNodeB::getCell(uint32_t cellId) {
+    uint32_t slot = cellIndex_.find(cellId);
+    return slot == DenseIndex::NOT_FOUND ? nullptr : &cells_[slot];
+}
+
+bool GNodeB::connectUe(UeId ueId) {
+    return connectUe(ueId, std::vector<float>());
+}
+
+bool GNodeB::connectUe(UeId ueId, const std::vector<float>& rsrp) {
     if (isUeConnected(ueId)) {
         logger_.warning("RAN", "UE " + std::to_string(ueId) + 
                                " already connected to gNodeB " + std::to_string(gnbId_));
-        return;
+        return false;
     }
 
-    if (connectedUes_.size() >= 1000) {  // Max 1000 UEs per gNodeB
+    if (ueIndex_.size() >= capacity_.maxUes) {
         logger_.warning("RAN", "gNodeB " + std::to_string(gnbId_) + 
                                " at maximum capacity");
-        return;
+        return false;
+    }
+
+    uint32_t slot = cells_.empty() ? NO_CELL :
+                    selectCell(rsrp.size() >= cells_.size() ? rsrp.data() : nullptr);
+    if (slot == DenseIndex::NOT_FOUND) {
+        logger_.warning("RAN", "gNodeB " + std::to_string(gnbId_) + 
+                               " has no cell with room for UE " + std::to_string(ueId));
+        return false;
     }
 
-    // Connect to first available cell
-    uint32_t cellId = cells_.empty() ? 0 : cells_[0].cellId;
-    connectedUes_[ueId] = cellId;
+    std::vector<UeId>& members = membersOf(slot);
+    ueIndex_.insert(ueId, slot << POSITION_BITS | static_cast<uint32_t>(members.size()));
+    members.push_back(ueId);
 
-    logger_.info("RAN", "UE " + std::to_string(ueId) + " connected to gNodeB " + 
-                        std::to_string(gnbId_) + " (Cell=" + std::to_string(cellId) + 
-                        ", Total UEs=" + std::to_string(connectedUes_.size()) + ")");
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info("RAN", "UE " + std::to_string(ueId) + " connected to gNodeB " + 
+                            std::to_string(gnbId_) + " (Cell=" + 
+                            std::to_string(slot == NO_CELL ? 0 : cells_[slot].cellId) + 
+                            ", Total UEs=" + std::to_string(ueIndex_.size()) + ")");
+    }
+    return true;
 }
 
 void GNodeB::disconnectUe(UeId ueId) {
-    auto it = connectedUes_.find(ueId);
-    if (it != connectedUes_.end()) {
-        connectedUes_.erase(it);
+    uint32_t entry = ueIndex_.find(ueId);
+    if (entry == DenseIndex::NOT_FOUND) {
+        return;
+    }
+
+    // The cell's last member takes the leaving UE's place
+    std::vector<UeId>& members = membersOf(entry >> POSITION_BITS);
+    uint32_t position = entry & POSITION_MASK;
+    UeId moved = members.back();
+    members[position] = moved;
+    members.pop_back();
+    ueIndex_.erase(ueId);
+    if (moved != ueId) {
+        ueIndex_.erase(moved);
+        ueIndex_.insert(moved, entry);
+    }
+
+    if (logger_.isEnabled(LogLevel::INFO)) {
         logger_.info("RAN", "UE " + std::to_string(ueId) + 
                            " disconnected from gNodeB " + std::to_string(gnbId_));
     }
 }
 
 bool GNodeB::isUeConnected(UeId ueId) const {
-    return connectedUes_.find(ueId) != connectedUes_.end();
+    return ueIndex_.find(ueId) != DenseIndex::NOT_FOUND;
 }
 
 uint32_t GNodeB::getConnectedUeCount(uint32_t cellId) const {
-    uint32_t count = 0;
-    for (const auto& pair : connectedUes_) {
-        if (pair.second == cellId) {
-            count++;
+    uint32_t slot = cellIndex_.find(cellId);
+    return slot == DenseIndex::NOT_FOUND ? 0 : static_cast<uint32_t>(cellUes_[slot].size());
+}
+
+uint32_t GNodeB::getUeCell(UeId ueId) const {
+    uint32_t entry = ueIndex_.find(ueId);
+    if (entry == DenseIndex::NOT_FOUND || (entry >> POSITION_BITS) == NO_CELL) {
+        return 0;
+    }
+    return cells_[entry >> POSITION_BITS].cellId;
+}
+
+const std::vector<UeId>& GNodeB::getCellUes(uint32_t cellId) const {
+    static const std::vector<UeId> none;
+    uint32_t slot = cellIndex_.find(cellId);
+    return slot == DenseIndex::NOT_FOUND ? none : cellUes_[slot];
+}
+
+uint32_t GNodeB::selectCell(const float* rsrp) const {
+    // Cells share the gNB's UE limit evenly unless given their own
+    uint32_t cellLimit = capacity_.maxUesPerCell;
+    if (cellLimit == 0) {
+        cellLimit = (capacity_.maxUes + static_cast<uint32_t>(cells_.size()) - 1) /
+                    static_cast<uint32_t>(cells_.size());
+    }
+
+    uint32_t best = DenseIndex::NOT_FOUND;
+    float bestScore = 0.0f;
+    for (uint32_t slot = 0; slot < cells_.size(); ++slot) {
+        uint32_t load = static_cast<uint32_t>(cellUes_[slot].size());
+        if (load >= cellLimit) {
+            continue;
+        }
+        float score = (rsrp ? rsrp[slot] : cells_[slot].rsrp) -
+                      CELL_LOAD_WEIGHT_DB * static_cast<float>(load) / static_cast<float>(cellLimit);
+        if (best == DenseIndex::NOT_FOUND || score > bestScore) {
+            best = slot;
+            bestScore = score;
         }
     }
-    return count;
+    return best;
 }
 
 void GNodeB::setState(GnbState newState) {
@@ -105,21 +240,13 @@ void GNodeB::updateTraffic(uint32_t ulBytes, uint32_t dlBytes) {
 }
 
 float GNodeB::getMeanRsrp(uint32_t cellId) const {
-    for (const auto& cell : cells_) {
-        if (cell.cellId == cellId) {
-            return cell.rsrp;
-        }
-    }
-    return 0.0f;
+    uint32_t slot = cellIndex_.find(cellId);
+    return slot == DenseIndex::NOT_FOUND ? 0.0f : cells_[slot].rsrp;
 }
 
 float GNodeB::getMeanRsrq(uint32_t cellId) const {
-    for (const auto& cell : cells_) {
-        if (cell.cellId == cellId) {
-            return cell.rsrq;
-        }
-    }
-    return 0.0f;
+    uint32_t slot = cellIndex_.find(cellId);
+    return slot == DenseIndex::NOT_FOUND ? 0.0f : cells_[slot].rsrq;
 }
 
 void GNodeB::printInfo() const {
@@ -128,18 +255,20 @@ void GNodeB::printInfo() const {
     std::cout << "Location:           " << location_ << "\n";
     std::cout << "State:              " << stateToString(state_) << "\n";
     std::cout << "Number of Cells:    " << cells_.size() << "\n";
-    std::cout << "Connected UEs:      " << connectedUes_.size() << "\n";
+    std::cout << "Connected UEs:      " << ueIndex_.size() << "\n";
     std::cout << "Total UL Traffic:   " << totalUlTraffic_ << " bytes\n";
     std::cout << "Total DL Traffic:   " << totalDlTraffic_ << " bytes\n";
 
     if (!cells_.empty()) {
         std::cout << "\nCell Information:\n";
-        for (const auto& cell : cells_) {
+        for (size_t slot = 0; slot < cells_.size(); ++slot) {
+            const CellInfo& cell = cells_[slot];
             std::cout << "  Cell ID=" << cell.cellId
                       << " | PCI=" << cell.pci
                       << " | Freq=" << cell.frequency << "MHz"
                       << " | RSRP=" << std::fixed << std::setprecision(1) << cell.rsrp << "dBm"
-                      << " | RSRQ=" << cell.rsrq << "dB\n";
+                      << " | RSRQ=" << cell.rsrq << "dB"
+                      << " | UEs=" << cellUes_[slot].size() << "\n";
         }
     }
     std::cout << "=======================================================\n\n";
@@ -149,7 +278,7 @@ std::string GNodeB::getDetailedStatus() const {
     std::ostringstream oss;
     oss << "gNB(" << gnbId_ << ") - " << stateToString(state_)
         << " | Location=" << location_
-        << " | UEs=" << connectedUes_.size()
+        << " | UEs=" << ueIndex_.size()
         << " | Cells=" << cells_.size();
     return oss.str();
 }
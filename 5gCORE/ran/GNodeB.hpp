@@ -4,33 +4,64 @@
 #include "../common/Types.hpp"
 #include "../common/Logger.hpp"
 #include "../common/Message.hpp"
+#include "../common/DenseIndex.hpp"
 #include <string>
 #include <memory>
-#include <map>
 #include <vector>
 
+struct GnbCapacity {
+    uint32_t maxCells;          // Up to GNodeB::MAX_CELLS
+    uint32_t maxUes;            // Connected UEs across all cells
+    uint32_t maxUesPerCell;     // 0 = an even share of maxUes
+};
+
 class GNodeB {
 public:
-    GNodeB(GnbId gnbId, const std::string& location);
+    static constexpr uint32_t MAX_CELLS = 255;
+    static constexpr float CELL_LOAD_WEIGHT_DB = 10.0f;   // RSRP given up to avoid a full cell
+
+    GNodeB(GnbId gnbId, const std::string& location, Tac tac = DEFAULT_TAC);
     ~GNodeB() = default;
 
     // Getters
     GnbId getGnbId() const { return gnbId_; }
     std::string getLocation() const { return location_; }
     GnbState getState() const { return state_; }
-    uint32_t getConnectedUeCount() const { return connectedUes_.size(); }
+    uint32_t getConnectedUeCount() const { return static_cast<uint32_t>(ueIndex_.size()); }
     uint32_t getCellCount() const { return cells_.size(); }
+    Tac getTac() const { return tac_; }
+    Position getPosition() const { return position_; }
+    void setPosition(Position position);         // Moves the site and its cells
+    std::vector<Tac> getTrackingAreas() const;   // Distinct TACs of the cells
 
-    // Cell management
+    // Limits on cells and connected UEs, 3 cells and 1000 UEs by default.
+    // Lowering them does not drop cells or UEs already there.
+    void setCapacity(const GnbCapacity& capacity);
+    const GnbCapacity& getCapacity() const { return capacity_; }
+
+    // Cell management; cells join the gNB's TAC unless given another
     void addCell(uint32_t cellId, uint32_t pci, uint32_t frequency);
+    void addCell(uint32_t cellId, uint32_t pci, uint32_t frequency, Tac tac);
     CellInfo* getCell(uint32_t cellId);
     std::vector<CellInfo>& getAllCells() { return cells_; }
 
-    // UE connection management
-    void connectUe(UeId ueId);
+    // UE connection management. A connecting UE is placed in the cell
+    // with the best RSRP after a penalty of up to CELL_LOAD_WEIGHT_DB for
+    // load; full cells are skipped. Without measurements the cells' mean
+    // RSRP is used; measurements follow the order of getAllCells(). Per-cell
+    // member lists are kept in place, so counts and membership are O(1).
+    bool connectUe(UeId ueId);
+    bool connectUe(UeId ueId, const std::vector<float>& rsrp);
     void disconnectUe(UeId ueId);
     bool isUeConnected(UeId ueId) const;
     uint32_t getConnectedUeCount(uint32_t cellId) const;
+    uint32_t getUeCell(UeId ueId) const;                     // 0 if not connected
+    const std::vector<UeId>& getCellUes(uint32_t cellId) const;
+
+    // Paging: one message per AMF paging tick, broadcast in every cell
+    void receivePaging(const PagingMessage& paging);
+    uint64_t getPagingMessageCount() const { return pagingMessages_; }
+    uint64_t getPagingRecordCount() const { return pagingRecords_; }
 
     // State management
     void setState(GnbState newState);
@@ -53,16 +84,35 @@ private:
     GnbId gnbId_;
     std::string location_;
     GnbState state_;
+    Tac tac_;
+    Position position_;
+
+    // A connected UE's index entry packs its cell slot and its position in
+    // that cell's member list; UEs that arrived before any cell existed are
+    // kept under NO_CELL
+    static constexpr uint32_t POSITION_BITS = 24;
+    static constexpr uint32_t POSITION_MASK = (1u << POSITION_BITS) - 1;
+    static constexpr uint32_t NO_CELL = MAX_CELLS;
 
+    GnbCapacity capacity_;
     std::vector<CellInfo> cells_;
-    std::map<UeId, uint32_t> connectedUes_;  // UE ID -> Cell ID mapping
+    std::vector<std::vector<UeId>> cellUes_;    // Per cell slot
+    std::vector<UeId> uncelledUes_;
+    DenseIndex cellIndex_;                      // Cell ID -> slot
+    DenseIndex ueIndex_;                        // UE ID -> cell slot << 24 | position
 
     uint64_t totalUlTraffic_;
     uint64_t totalDlTraffic_;
+    uint64_t pagingMessages_;
+    uint64_t pagingRecords_;
 
     Logger& logger_ = Logger::getInstance();
 
     std::string stateToString(GnbState state) const;
+    uint32_t selectCell(const float* rsrp) const;
+    std::vector<UeId>& membersOf(uint32_t slot) {
+        return slot == NO_CELL ? uncelledUes_ : cellUes_[slot];
+    }
 };
 
 #endif // GNODE_B_HPP
@@ -0,0 +1,267 @@
+#include "RadioPropagation.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RADIO_PROPAGATION_X86 1
+#endif
+
+namespace {
+
+constexpr float MIN_DISTANCE2 = 100.0f;         // 10 m, the near edge of the UMa model
+constexpr float IRWIN_HALL_MEAN = 510.0f;       // Sum of four uniform bytes
+constexpr float IRWIN_HALL_SIGMA = 147.8017f;
+constexpr float RB_RES_DB = 10.7918125f;        // 10 log10(12 REs per RB)
+
+// Per-link hash; both paths must produce the same bits
+inline uint32_t linkHash(uint32_t ue, uint32_t cell) {
+    uint32_t h = ue * 0x9E3779B1u ^ cell * 0x85EBCA77u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+inline float clampf(float value, float low, float high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+}  // namespace
+
+RadioPropagation::RadioPropagation(const PropagationConfig& config) : config_(config) {
+    pathLossConstant_ = 28.0f + 20.0f * std::log10(config_.frequencyGhz);
+    noiseMw_ = std::pow(10.0f, config_.noiseDbmPerRe / 10.0f);
+
+    // Cell 0 is silent and far away; unused neighbor slots point at it
+    cellIds_.push_back(0);
+    cellX_.push_back(0.0f);
+    cellY_.push_back(0.0f);
+    cellDh2_.push_back(1e12f);
+    cellPower_.push_back(-300.0f);
+}
+
+uint32_t RadioPropagation::addCell(uint32_t cellId, float x, float y, float heightM, float rsPowerDbm) {
+    float dh = heightM - config_.ueHeightM;
+    cellIds_.push_back(cellId);
+    cellX_.push_back(x);
+    cellY_.push_back(y);
+    cellDh2_.push_back(dh * dh);
+    cellPower_.push_back(rsPowerDbm);
+    return static_cast<uint32_t>(cellIds_.size() - 1);
+}
+
+uint32_t RadioPropagation::addUe(float x, float y) {
+    ueX_.push_back(x);
+    ueY_.push_back(y);
+    for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+        neighbors_[slot].push_back(NO_CELL);
+        rsrp_[slot].push_back(MIN_RSRP_DBM);
+        rsrq_[slot].push_back(MIN_RSRQ_DB);
+    }
+    return static_cast<uint32_t>(ueX_.size() - 1);
+}
+
+void RadioPropagation::setNeighbors(uint32_t ue, const uint32_t* cells, uint32_t count) {
+    for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+        uint32_t cell = slot < count ? cells[slot] : NO_CELL;
+        neighbors_[slot][ue] = cell < cellIds_.size() ? cell : NO_CELL;
+    }
+}
+
+void RadioPropagation::reserve(size_t ues) {
+    ueX_.reserve(ues);
+    ueY_.reserve(ues);
+    for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+        neighbors_[slot].reserve(ues);
+        rsrp_[slot].reserve(ues);
+        rsrq_[slot].reserve(ues);
+    }
+}
+
+uint32_t RadioPropagation::getBestCell(uint32_t ue) const {
+    uint32_t best = NO_CELL;
+    float bestRsrp = MIN_RSRP_DBM;
+    for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+        uint32_t cell = neighbors_[slot][ue];
+        if (cell != NO_CELL && (best == NO_CELL || rsrp_[slot][ue] > bestRsrp)) {
+            best = cell;
+            bestRsrp = rsrp_[slot][ue];
+        }
+    }
+    return best;
+}
+
+void RadioPropagation::measure() {
+    size_t count = ueX_.size();
+    size_t vectorEnd = 0;
+#ifdef RADIO_PROPAGATION_X86
+    if (hasAvx2()) {
+        vectorEnd = count & ~static_cast<size_t>(7);
+        measureAvx2(0, vectorEnd);
+    }
+#endif
+    measureRange(vectorEnd, count);
+}
+
+void RadioPropagation::measureScalar() {
+    measureRange(0, ueX_.size());
+}
+
+bool RadioPropagation::hasAvx2() {
+#ifdef RADIO_PROPAGATION_X86
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void RadioPropagation::measureRange(size_t begin, size_t end) {
+    const float shadowScale = config_.shadowingSigmaDb / IRWIN_HALL_SIGMA;
+    float rsrp[NEIGHBORS];
+    for (size_t ue = begin; ue < end; ++ue) {
+        float interferenceMw = noiseMw_;
+        for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+            uint32_t cell = neighbors_[slot][ue];
+            float dx = ueX_[ue] - cellX_[cell];
+            float dy = ueY_[ue] - cellY_[cell];
+            float d2 = std::max(dx * dx + dy * dy + cellDh2_[cell], MIN_DISTANCE2);
+            float pathLoss = pathLossConstant_ + 11.0f * std::log10(d2);   // 22 log10(d)
+
+            uint32_t h = linkHash(static_cast<uint32_t>(ue), cell);
+            int32_t bytes = static_cast<int32_t>((h & 0xFF) + ((h >> 8) & 0xFF) + ((h >> 16) & 0xFF) + (h >> 24));
+            float shadowing = static_cast<float>(bytes - 510) * shadowScale;
+
+            rsrp[slot] = cellPower_[cell] - pathLoss + shadowing;
+            interferenceMw += std::pow(10.0f, rsrp[slot] / 10.0f);
+        }
+
+        float rssiDb = 10.0f * std::log10(interferenceMw) + RB_RES_DB;
+        for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+            rsrp_[slot][ue] = clampf(rsrp[slot], MIN_RSRP_DBM, MAX_RSRP_DBM);
+            rsrq_[slot][ue] = clampf(rsrp[slot] - rssiDb, MIN_RSRQ_DB, MAX_RSRQ_DB);
+        }
+    }
+}
+
+#ifdef RADIO_PROPAGATION_X86
+
+namespace {
+
+// log10 of eight positive, normal floats (Cephes logf polynomial, ~1e-7
+// relative error)
+__attribute__((target("avx2,fma")))
+inline __m256 log10Avx2(__m256 x) {
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                   _mm256_set1_epi32(0x3F800000)));
+
+    // Mantissa into [sqrt(1/2), sqrt(2))
+    __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+    e = _mm256_add_ps(e, _mm256_and_ps(big, _mm256_set1_ps(1.0f)));
+
+    __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    __m256 z = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(7.0376836292e-2f);
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(-1.1514610310e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(1.1676998740e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(-1.2420140846e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(1.4249322787e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(-1.6668057665e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(2.0000714765e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(-2.4999993993e-1f));
+    p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(3.3333331174e-1f));
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, t), z);
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    __m256 ln = _mm256_add_ps(t, y);
+    ln = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), ln);
+    return _mm256_mul_ps(ln, _mm256_set1_ps(0.434294481903f));
+}
+
+// 10^(x/10), dB to linear (Cephes exp2f polynomial); underflows to 2^-126
+__attribute__((target("avx2,fma")))
+inline __m256 dbToLinearAvx2(__m256 db) {
+    __m256 t = _mm256_mul_ps(db, _mm256_set1_ps(0.332192809489f));      // log2(10) / 10
+    t = _mm256_max_ps(_mm256_min_ps(t, _mm256_set1_ps(127.0f)), _mm256_set1_ps(-126.0f));
+    __m256 n = _mm256_round_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 f = _mm256_sub_ps(t, n);
+
+    __m256 p = _mm256_set1_ps(1.535336188319500e-4f);
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.339887440266574e-3f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(9.618437357674640e-3f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(5.550332471162809e-2f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(2.402264791363012e-1f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(6.931472028550421e-1f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+
+    __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+}
+
+}  // namespace
+
+__attribute__((target("avx2,fma")))
+void RadioPropagation::measureAvx2(size_t begin, size_t end) {
+    const __m256 shadowScale = _mm256_set1_ps(config_.shadowingSigmaDb / IRWIN_HALL_SIGMA);
+    const __m256 pathLossConstant = _mm256_set1_ps(pathLossConstant_);
+    const __m256 minDistance2 = _mm256_set1_ps(MIN_DISTANCE2);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const float* cellX = cellX_.data();
+    const float* cellY = cellY_.data();
+    const float* cellDh2 = cellDh2_.data();
+    const float* cellPower = cellPower_.data();
+    __m256 rsrp[NEIGHBORS];
+
+    for (size_t ue = begin; ue < end; ue += 8) {
+        __m256 x = _mm256_loadu_ps(&ueX_[ue]);
+        __m256 y = _mm256_loadu_ps(&ueY_[ue]);
+        __m256i ues = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(ue)),
+                                       _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256 interferenceMw = _mm256_set1_ps(noiseMw_);
+
+        for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+            __m256i cells = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&neighbors_[slot][ue]));
+            __m256 dx = _mm256_sub_ps(x, _mm256_i32gather_ps(cellX, cells, 4));
+            __m256 dy = _mm256_sub_ps(y, _mm256_i32gather_ps(cellY, cells, 4));
+            __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_i32gather_ps(cellDh2, cells, 4)));
+            d2 = _mm256_max_ps(d2, minDistance2);
+            __m256 pathLoss = _mm256_fmadd_ps(_mm256_set1_ps(11.0f), log10Avx2(d2), pathLossConstant);
+
+            __m256i h = _mm256_xor_si256(_mm256_mullo_epi32(ues, _mm256_set1_epi32(static_cast<int32_t>(0x9E3779B1u))),
+                                         _mm256_mullo_epi32(cells, _mm256_set1_epi32(static_cast<int32_t>(0x85EBCA77u))));
+            h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+            h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x2C1B3C6D));
+            h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+            __m256i bytes = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_and_si256(h, byteMask), _mm256_and_si256(_mm256_srli_epi32(h, 8), byteMask)),
+                _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(h, 16), byteMask), _mm256_srli_epi32(h, 24)));
+            __m256 shadowing = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(bytes, _mm256_set1_epi32(510))),
+                                             shadowScale);
+
+            rsrp[slot] = _mm256_add_ps(_mm256_sub_ps(_mm256_i32gather_ps(cellPower, cells, 4), pathLoss), shadowing);
+            interferenceMw = _mm256_add_ps(interferenceMw, dbToLinearAvx2(rsrp[slot]));
+        }
+
+        __m256 rssiDb = _mm256_fmadd_ps(_mm256_set1_ps(10.0f), log10Avx2(interferenceMw), _mm256_set1_ps(RB_RES_DB));
+        for (uint32_t slot = 0; slot < NEIGHBORS; ++slot) {
+            __m256 value = _mm256_max_ps(_mm256_min_ps(rsrp[slot], _mm256_set1_ps(MAX_RSRP_DBM)),
+                                         _mm256_set1_ps(MIN_RSRP_DBM));
+            _mm256_storeu_ps(&rsrp_[slot][ue], value);
+            value = _mm256_sub_ps(rsrp[slot], rssiDb);
+            value = _mm256_max_ps(_mm256_min_ps(value, _mm256_set1_ps(MAX_RSRQ_DB)), _mm256_set1_ps(MIN_RSRQ_DB));
+            _mm256_storeu_ps(&rsrq_[slot][ue], value);
+        }
+    }
+}
+
+#else
+
+void RadioPropagation::measureAvx2(size_t begin, size_t end) {
+    measureRange(begin, end);
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef RADIO_PROPAGATION_HPP
+#define RADIO_PROPAGATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct PropagationConfig {
+    float frequencyGhz;         // Carrier frequency
+    float ueHeightM;
+    float shadowingSigmaDb;     // Log-normal shadowing, fixed per UE-cell pair
+    float noiseDbmPerRe;        // Thermal noise plus UE noise figure, per resource element
+};
+
+// Downlink measurement model for UEs against their neighbor cells.
+//
+// Path loss follows the 3GPP TR 38.901 UMa LOS formula
+// PL = 28 + 22 log10(d3D) + 20 log10(fc), with log-normal shadowing drawn
+// from a hash of the UE and cell, so a link keeps its shadowing between
+// measurement periods. RSRP is the cell's reference signal power less path
+// loss plus shadowing. RSRQ assumes fully loaded cells: RSSI over one RB is
+// 12 resource elements of every measured cell plus noise. Reported values
+// are clamped to the TS 38.133 ranges.
+//
+// UEs, neighbor lists and results are stored as structures of arrays, one
+// array per field and per neighbor slot, so measure() streams through them
+// eight UEs at a time. The AVX2 path is picked at run time on CPUs that
+// have it; the scalar path computes the same model. Cell 0 is a silent
+// placeholder that fills unused neighbor slots. Not thread-safe.
+class RadioPropagation {
+public:
+    static constexpr uint32_t NEIGHBORS = 8;        // Measured cells per UE
+    static constexpr uint32_t NO_CELL = 0;
+    static constexpr float MIN_RSRP_DBM = -156.0f;
+    static constexpr float MAX_RSRP_DBM = -31.0f;
+    static constexpr float MIN_RSRQ_DB = -19.5f;
+    static constexpr float MAX_RSRQ_DB = -3.0f;
+
+    explicit RadioPropagation(const PropagationConfig& config = PropagationConfig{3.5f, 1.5f, 6.0f, -122.0f});
+
+    // Cell sites; returns the cell's index, from 1
+    uint32_t addCell(uint32_t cellId, float x, float y, float heightM, float rsPowerDbm);
+    uint32_t getCellId(uint32_t cell) const { return cellIds_[cell]; }
+    size_t getCellCount() const { return cellIds_.size() - 1; }
+
+    // UEs; positions in metres on the same plane as the cells
+    uint32_t addUe(float x, float y);
+    void setUePosition(uint32_t ue, float x, float y) { ueX_[ue] = x; ueY_[ue] = y; }
+    void setNeighbors(uint32_t ue, const uint32_t* cells, uint32_t count);
+    uint32_t getNeighbor(uint32_t ue, uint32_t slot) const { return neighbors_[slot][ue]; }
+    size_t getUeCount() const { return ueX_.size(); }
+    void reserve(size_t ues);
+
+    // Recomputes RSRP and RSRQ of every UE against each of its neighbors
+    void measure();
+    void measureScalar();
+    static bool hasAvx2();
+
+    float getRsrp(uint32_t ue, uint32_t slot) const { return rsrp_[slot][ue]; }
+    float getRsrq(uint32_t ue, uint32_t slot) const { return rsrq_[slot][ue]; }
+    const float* getRsrpRow(uint32_t slot) const { return rsrp_[slot].data(); }
+    const float* getRsrqRow(uint32_t slot) const { return rsrq_[slot].data(); }
+    uint32_t getBestCell(uint32_t ue) const;        // Strongest neighbor, NO_CELL if none
+
+private:
+    PropagationConfig config_;
+    float pathLossConstant_;        // 28 + 20 log10(fc)
+    float noiseMw_;
+
+    std::vector<uint32_t> cellIds_;
+    std::vector<float> cellX_;
+    std::vector<float> cellY_;
+    std::vector<float> cellDh2_;    // Squared height above the UE
+    std::vector<float> cellPower_;
+
+    std::vector<float> ueX_;
+    std::vector<float> ueY_;
+    std::vector<uint32_t> neighbors_[NEIGHBORS];
+    std::vector<float> rsrp_[NEIGHBORS];
+    std::vector<float> rsrq_[NEIGHBORS];
+
+    void measureRange(size_t begin, size_t end);
+    void measureAvx2(size_t begin, size_t end);
+};
+
+#endif // RADIO_PROPAGATION_HPP
@@ -0,0 +1,161 @@
+#include "SpatialGrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float bucketSizeM)
+    : baseBucketSize_(bucketSizeM > 0 ? bucketSizeM : 1.0f), bucketSize_(baseBucketSize_),
+      minX_(0), minY_(0), columns_(1), rows_(1),
+      bucketStart_(2, 0) {}
+
+void SpatialGrid::add(uint32_t id, Position position) {
+    pendingIds_.push_back(id);
+    pendingPositions_.push_back(position);
+}
+
+void SpatialGrid::clear() {
+    pendingIds_.clear();
+    pendingPositions_.clear();
+    build();
+}
+
+void SpatialGrid::build() {
+    minX_ = minY_ = 0;
+    float maxX = 0;
+    float maxY = 0;
+    if (!pendingPositions_.empty()) {
+        minX_ = maxX = pendingPositions_.front().x;
+        minY_ = maxY = pendingPositions_.front().y;
+    }
+    for (const Position& position : pendingPositions_) {
+        minX_ = std::min(minX_, position.x);
+        maxX = std::max(maxX, position.x);
+        minY_ = std::min(minY_, position.y);
+        maxY = std::max(maxY, position.y);
+    }
+
+    // Sparse layouts get coarser buckets rather than mostly empty ones
+    bucketSize_ = baseBucketSize_;
+    size_t maxBuckets = 4 * pendingIds_.size() + 16;
+    for (;;) {
+        double columns = std::floor((maxX - minX_) / bucketSize_) + 1;
+        double rows = std::floor((maxY - minY_) / bucketSize_) + 1;
+        if (columns * rows <= static_cast<double>(maxBuckets)) {
+            columns_ = static_cast<int32_t>(columns);
+            rows_ = static_cast<int32_t>(rows);
+            break;
+        }
+        bucketSize_ *= static_cast<float>(std::sqrt(columns * rows / maxBuckets)) * 1.01f;
+    }
+
+    // Counting sort by bucket
+    size_t bucketCount = static_cast<size_t>(columns_) * static_cast<size_t>(rows_);
+    std::vector<uint32_t> buckets(pendingIds_.size());
+    bucketStart_.assign(bucketCount + 1, 0);
+    for (size_t i = 0; i < pendingIds_.size(); ++i) {
+        buckets[i] = static_cast<uint32_t>(rowOf(pendingPositions_[i].y) * columns_ +
+                                           columnOf(pendingPositions_[i].x));
+        bucketStart_[buckets[i] + 1]++;
+    }
+    for (size_t b = 0; b < bucketCount; ++b) {
+        bucketStart_[b + 1] += bucketStart_[b];
+    }
+
+    std::vector<uint32_t> next(bucketStart_.begin(), bucketStart_.end() - 1);
+    ids_.resize(pendingIds_.size());
+    xs_.resize(pendingIds_.size());
+    ys_.resize(pendingIds_.size());
+    for (size_t i = 0; i < pendingIds_.size(); ++i) {
+        uint32_t slot = next[buckets[i]]++;
+        ids_[slot] = pendingIds_[i];
+        xs_[slot] = pendingPositions_[i].x;
+        ys_[slot] = pendingPositions_[i].y;
+    }
+}
+
+size_t SpatialGrid::queryNearest(Position center, uint32_t k, uint32_t* ids) const {
+    k = std::min(k, MAX_NEAREST);
+    if (k == 0 || ids_.empty()) {
+        return 0;
+    }
+
+    float distances[MAX_NEAREST];
+    size_t found = 0;
+    int32_t column = columnOf(center.x);
+    int32_t row = rowOf(center.y);
+
+    for (int32_t ring = 0;; ++ring) {
+        int32_t top = row - ring;
+        int32_t bottom = row + ring;
+        for (int32_t r = std::max(top, 0); r <= std::min(bottom, rows_ - 1); ++r) {
+            // Whole rows at the ring's top and bottom, only its two ends in between
+            int32_t step = (r == top || r == bottom) ? 1 : 2 * ring;
+            for (int32_t c = column - ring; c <= column + ring; c += step) {
+                if (c < 0 || c >= columns_) {
+                    continue;
+                }
+                size_t bucket = static_cast<size_t>(r) * columns_ + c;
+                for (uint32_t i = bucketStart_[bucket]; i < bucketStart_[bucket + 1]; ++i) {
+                    float dx = xs_[i] - center.x;
+                    float dy = ys_[i] - center.y;
+                    float d2 = dx * dx + dy * dy;
+                    if (found == k && d2 >= distances[k - 1]) {
+                        continue;
+                    }
+                    size_t at = found < k ? found++ : k - 1;
+                    while (at > 0 && distances[at - 1] > d2) {
+                        distances[at] = distances[at - 1];
+                        ids[at] = ids[at - 1];
+                        at--;
+                    }
+                    distances[at] = d2;
+                    ids[at] = ids_[i];
+                }
+            }
+        }
+
+        // Nearest point any unvisited bucket could hold
+        float bound = -1;
+        auto consider = [&bound](bool unvisited, float distance) {
+            if (unvisited && (bound < 0 || distance < bound)) {
+                bound = distance;
+            }
+        };
+        consider(column - ring > 0, center.x - (minX_ + (column - ring) * bucketSize_));
+        consider(column + ring < columns_ - 1, minX_ + (column + ring + 1) * bucketSize_ - center.x);
+        consider(row - ring > 0, center.y - (minY_ + (row - ring) * bucketSize_));
+        consider(row + ring < rows_ - 1, minY_ + (row + ring + 1) * bucketSize_ - center.y);
+        if (bound < 0 || (found == k && distances[k - 1] <= bound * bound)) {
+            return found;
+        }
+    }
+}
+
+size_t SpatialGrid::queryRadius(Position center, float radius, std::vector<uint32_t>& ids) const {
+    size_t before = ids.size();
+    float radius2 = radius * radius;
+    int32_t firstColumn = columnOf(center.x - radius);
+    int32_t lastColumn = columnOf(center.x + radius);
+    for (int32_t r = rowOf(center.y - radius); r <= rowOf(center.y + radius); ++r) {
+        // Buckets of one row are adjacent, so the row's span is one run
+        size_t first = bucketStart_[static_cast<size_t>(r) * columns_ + firstColumn];
+        size_t last = bucketStart_[static_cast<size_t>(r) * columns_ + lastColumn + 1];
+        for (size_t i = first; i < last; ++i) {
+            float dx = xs_[i] - center.x;
+            float dy = ys_[i] - center.y;
+            if (dx * dx + dy * dy <= radius2) {
+                ids.push_back(ids_[i]);
+            }
+        }
+    }
+    return ids.size() - before;
+}
+
+int32_t SpatialGrid::columnOf(float x) const {
+    float column = std::floor((x - minX_) / bucketSize_);
+    return column <= 0 ? 0 : (column >= columns_ - 1 ? columns_ - 1 : static_cast<int32_t>(column));
+}
+
+int32_t SpatialGrid::rowOf(float y) const {
+    float row = std::floor((y - minY_) / bucketSize_);
+    return row <= 0 ? 0 : (row >= rows_ - 1 ? rows_ - 1 : static_cast<int32_t>(row));
+}
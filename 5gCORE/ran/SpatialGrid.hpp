@@ -0,0 +1,59 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include "../common/Types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform grid index over points on the plane (cell sites, typically).
+//
+// Points are added, then build() sorts them into square buckets of a fixed
+// size, stored contiguously bucket by bucket (IDs and coordinates in
+// separate arrays), with one offset per bucket. A query looks only at
+// the buckets around its center: nearest-k walks outward ring by ring and
+// stops once no unvisited bucket can hold a closer point, so with the
+// bucket size near the typical site spacing it touches a few buckets
+// whatever the total count. The grid spans the points' bounding box; each
+// build() starts from the configured bucket size and coarsens it if that
+// would need far more buckets than points.
+// Adding points after build() needs another build(). Not thread-safe.
+class SpatialGrid {
+public:
+    static constexpr uint32_t MAX_NEAREST = 64;
+
+    explicit SpatialGrid(float bucketSizeM = 1000.0f);
+
+    void add(uint32_t id, Position position);
+    void build();
+    void clear();
+    size_t size() const { return pendingIds_.size(); }
+    float getBucketSize() const { return bucketSize_; }     // As of the last build()
+
+    // Up to k (at most MAX_NEAREST) IDs, nearest first; returns how many
+    // were found
+    size_t queryNearest(Position center, uint32_t k, uint32_t* ids) const;
+    // Appends the IDs within radius metres, in no particular order
+    size_t queryRadius(Position center, float radius, std::vector<uint32_t>& ids) const;
+
+private:
+    float baseBucketSize_;          // Configured
+    float bucketSize_;              // In use
+    float minX_;
+    float minY_;
+    int32_t columns_;
+    int32_t rows_;
+
+    std::vector<uint32_t> pendingIds_;      // Everything added, in order
+    std::vector<Position> pendingPositions_;
+
+    std::vector<uint32_t> bucketStart_;     // columns_ * rows_ + 1 offsets
+    std::vector<uint32_t> ids_;             // By bucket
+    std::vector<float> xs_;
+    std::vector<float> ys_;
+
+    int32_t columnOf(float x) const;
+    int32_t rowOf(float y) const;
+};
+
+#endif // SPATIAL_GRID_HPP
@@ -0,0 +1,244 @@
+#include "IpPool.hpp"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+bool IpPool::addIpv4Pool(const std::string& dnn, const std::string& cidr) {
+    size_t slash = cidr.find('/');
+    uint32_t network = 0;
+    if (slash == std::string::npos || !parseIpv4(cidr.substr(0, slash), network)) {
+        return false;
+    }
+
+    int length = std::atoi(cidr.c_str() + slash + 1);
+    if (length < 8 || length > 30) {
+        return false;  // Larger than a /8 or too small to hold a host
+    }
+
+    uint32_t mask = 0xFFFFFFFFu << (32 - length);
+    uint32_t hosts = (1u << (32 - length)) - 2;  // Minus network and broadcast
+
+    std::unique_ptr<Range> range(new Range());
+    range->base = (network & mask) + 1;
+    range->prefixLength = static_cast<uint8_t>(length);
+    range->slots.reset(hosts);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_[dnn].ipv4 = std::move(range);
+    return true;
+}
+
+bool IpPool::addIpv6Pool(const std::string& dnn, const std::string& prefix) {
+    size_t slash = prefix.find('/');
+    uint64_t network = 0;
+    if (slash == std::string::npos || !parseIpv6Prefix(prefix.substr(0, slash), network)) {
+        return false;
+    }
+
+    int length = std::atoi(prefix.c_str() + slash + 1);
+    if (length < 40 || length > 64) {
+        return false;  // Keeps the bitmap at 2^24 prefixes at most
+    }
+
+    uint64_t mask = ~0ULL << (64 - length);
+    uint64_t count = 1ULL << (64 - length);
+
+    std::unique_ptr<Range> range(new Range());
+    range->base = network & mask;
+    range->prefixLength = static_cast<uint8_t>(length);
+    range->slots.reset(static_cast<uint32_t>(std::min<uint64_t>(count, MAX_IPV6_PREFIXES)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_[dnn].ipv6 = std::move(range);
+    return true;
+}
+
+bool IpPool::allocateIpv4(const std::string& dnn, uint32_t& address) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pools_.find(dnn);
+    uint64_t value = 0;
+    if (it == pools_.end() || !allocate(it->second.ipv4.get(), value)) {
+        return false;
+    }
+    address = static_cast<uint32_t>(value);
+    return true;
+}
+
+bool IpPool::releaseIpv4(uint32_t address) {
+    return release(address, false);
+}
+
+bool IpPool::allocateIpv6Prefix(const std::string& dnn, uint64_t& prefix) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pools_.find(dnn);
+    return it != pools_.end() && allocate(it->second.ipv6.get(), prefix);
+}
+
+bool IpPool::releaseIpv6Prefix(uint64_t prefix) {
+    return release(prefix, true);
+}
+
+uint32_t IpPool::allocateIpv4(const std::string& dnn, uint32_t* addresses, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pools_.find(dnn);
+    if (it == pools_.end()) {
+        return 0;
+    }
+
+    Range* range = it->second.ipv4.get();
+    uint64_t value = 0;
+    uint32_t allocated = 0;
+    while (allocated < count && allocate(range, value)) {
+        addresses[allocated++] = static_cast<uint32_t>(value);
+    }
+    return allocated;
+}
+
+uint32_t IpPool::allocateIpv6Prefixes(const std::string& dnn, uint64_t* prefixes, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pools_.find(dnn);
+    if (it == pools_.end()) {
+        return 0;
+    }
+
+    Range* range = it->second.ipv6.get();
+    uint32_t allocated = 0;
+    while (allocated < count && allocate(range, prefixes[allocated])) {
+        allocated++;
+    }
+    return allocated;
+}
+
+uint32_t IpPool::releaseIpv4(const uint32_t* addresses, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t released = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        released += releaseLocked(addresses[i], false) ? 1 : 0;
+    }
+    return released;
+}
+
+uint32_t IpPool::releaseIpv6Prefixes(const uint64_t* prefixes, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t released = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        released += releaseLocked(prefixes[i], true) ? 1 : 0;
+    }
+    return released;
+}
+
+bool IpPool::hasDnn(const std::string& dnn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pools_.find(dnn) != pools_.end();
+}
+
+uint32_t IpPool::getIpv4Allocated(const std::string& dnn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Range* range = findRange(dnn, false);
+    return range ? range->slots.getUsedCount() : 0;
+}
+
+uint32_t IpPool::getIpv4Available(const std::string& dnn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Range* range = findRange(dnn, false);
+    return range ? range->slots.getFreeCount() : 0;
+}
+
+uint32_t IpPool::getIpv6Allocated(const std::string& dnn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Range* range = findRange(dnn, true);
+    return range ? range->slots.getUsedCount() : 0;
+}
+
+uint32_t IpPool::getIpv6Available(const std::string& dnn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Range* range = findRange(dnn, true);
+    return range ? range->slots.getFreeCount() : 0;
+}
+
+std::string IpPool::formatIpv4(uint32_t address) {
+    char text[INET_ADDRSTRLEN];
+    std::snprintf(text, sizeof(text), "%u.%u.%u.%u", address >> 24, (address >> 16) & 0xFF,
+                  (address >> 8) & 0xFF, address & 0xFF);
+    return text;
+}
+
+std::string IpPool::formatIpv6Prefix(uint64_t prefix) {
+    uint8_t bytes[16] = {0};
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(prefix >> (56 - 8 * i));
+    }
+    char text[INET6_ADDRSTRLEN];
+    if (!inet_ntop(AF_INET6, bytes, text, sizeof(text))) {
+        return "";
+    }
+    return std::string(text) + "/64";
+}
+
+bool IpPool::parseIpv4(const std::string& text, uint32_t& address) {
+    struct in_addr parsed;
+    if (inet_pton(AF_INET, text.c_str(), &parsed) != 1) {
+        return false;
+    }
+    address = ntohl(parsed.s_addr);
+    return true;
+}
+
+bool IpPool::parseIpv6Prefix(const std::string& text, uint64_t& prefix) {
+    std::string address = text.substr(0, text.find('/'));
+    uint8_t bytes[16];
+    if (inet_pton(AF_INET6, address.c_str(), bytes) != 1) {
+        return false;
+    }
+    prefix = 0;
+    for (int i = 0; i < 8; ++i) {
+        prefix = (prefix << 8) | bytes[i];
+    }
+    return true;
+}
+
+bool IpPool::allocate(Range* range, uint64_t& value) {
+    if (!range) {
+        return false;
+    }
+    uint32_t slot = range->slots.acquire();
+    if (slot == HierarchicalBitmap::NONE) {
+        return false;
+    }
+    value = range->base + slot;
+    return true;
+}
+
+bool IpPool::release(uint64_t value, bool ipv6) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return releaseLocked(value, ipv6);
+}
+
+bool IpPool::releaseLocked(uint64_t value, bool ipv6) {
+    // Addresses go back to whichever pool contains them, so a session that
+    // changed DNN still releases into the right range
+    for (auto& pair : pools_) {
+        Range* range = ipv6 ? pair.second.ipv6.get() : pair.second.ipv4.get();
+        if (!range || value < range->base) {
+            continue;
+        }
+        uint64_t slot = value - range->base;
+        if (slot < range->slots.getSize()) {
+            if (!range->slots.test(static_cast<uint32_t>(slot))) {
+                return false;  // Double release
+            }
+            range->slots.clear(static_cast<uint32_t>(slot));
+            return true;
+        }
+    }
+    return false;
+}
+
+const IpPool::Range* IpPool::findRange(const std::string& dnn, bool ipv6) const {
+    auto it = pools_.find(dnn);
+    if (it == pools_.end()) {
+        return nullptr;
+    }
+    return ipv6 ? it->second.ipv6.get() : it->second.ipv4.get();
+}
@@ -0,0 +1,73 @@
+#ifndef IP_POOL_HPP
+#define IP_POOL_HPP
+
+#include "../common/HierarchicalBitmap.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// UE address pools, one IPv4 range and one IPv6 prefix pool per DNN.
+//
+// IPv4 pools hand out single addresses from a CIDR block (network and
+// broadcast addresses excluded). IPv6 pools hand out /64 prefixes carved from
+// a shorter operator prefix, as SMF does for IPv6 PDU sessions. Each pool is
+// a hierarchical bitmap, so allocate and release are O(1) in the pool size
+// and freed addresses are reused lowest-first. All operations are guarded by
+// one mutex; addresses are returned in host byte order.
+class IpPool {
+public:
+    static constexpr uint32_t MAX_IPV6_PREFIXES = 1u << 24;  // /64s per pool
+
+    IpPool() = default;
+
+    bool addIpv4Pool(const std::string& dnn, const std::string& cidr);
+    bool addIpv6Pool(const std::string& dnn, const std::string& prefix);
+
+    bool allocateIpv4(const std::string& dnn, uint32_t& address);
+    bool releaseIpv4(uint32_t address);
+    bool allocateIpv6Prefix(const std::string& dnn, uint64_t& prefix);
+    bool releaseIpv6Prefix(uint64_t prefix);
+
+    // Batch forms take the lock once; they return how many were handled,
+    // which is short of count only when the pool runs dry
+    uint32_t allocateIpv4(const std::string& dnn, uint32_t* addresses, uint32_t count);
+    uint32_t allocateIpv6Prefixes(const std::string& dnn, uint64_t* prefixes, uint32_t count);
+    uint32_t releaseIpv4(const uint32_t* addresses, uint32_t count);
+    uint32_t releaseIpv6Prefixes(const uint64_t* prefixes, uint32_t count);
+
+    bool hasDnn(const std::string& dnn) const;
+    uint32_t getIpv4Allocated(const std::string& dnn) const;
+    uint32_t getIpv4Available(const std::string& dnn) const;
+    uint32_t getIpv6Allocated(const std::string& dnn) const;
+    uint32_t getIpv6Available(const std::string& dnn) const;
+
+    static std::string formatIpv4(uint32_t address);
+    static std::string formatIpv6Prefix(uint64_t prefix);   // "fd00:0:0:1::/64"
+    static bool parseIpv4(const std::string& text, uint32_t& address);
+    static bool parseIpv6Prefix(const std::string& text, uint64_t& prefix);
+
+private:
+    struct Range {
+        uint64_t base;          // First assignable address / prefix
+        uint8_t prefixLength;
+        HierarchicalBitmap slots;
+    };
+
+    struct DnnPools {
+        std::unique_ptr<Range> ipv4;
+        std::unique_ptr<Range> ipv6;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, DnnPools> pools_;
+
+    static bool allocate(Range* range, uint64_t& value);
+    bool release(uint64_t value, bool ipv6);
+    bool releaseLocked(uint64_t value, bool ipv6);
+    const Range* findRange(const std::string& dnn, bool ipv6) const;
+};
+
+#endif // IP_POOL_HPP
@@ -4,128 +4,277 @@
 #include <sstream>
 #include <iomanip>
 
-static uint32_t sessionIdCounter = 5000;
-static uint32_t ipAddrCounter = 1;
-
-SMF::SMF() : NetworkFunction(NFType::SMF, "SMF") {
+SMF::SMF() : NetworkFunction(NFType::SMF, "SMF"), sessionIdBatch_(sessionIds_),
+             activeSessionCount_(0), counterEpoch_(0), releaseBatch_(nullptr),
+             n4QueueHead_(0), n4Sequence_(0), n4Flushing_(false) {
+    defaultRules_.qosRateKbps = 1000;
+    defaultRules_.qfi = DEFAULT_QFI;
+    defaultRules_.fiveQi = DEFAULT_FIVE_QI;
+    defaultRules_.priorityLevel = 90;   // Standardized default for 5QI 9
+    defaultRules_.urrVolumeThreshold = DEFAULT_URR_VOLUME_THRESHOLD;
+    defaultRules_.urrTimeThresholdMs = DEFAULT_URR_TIME_THRESHOLD_MS;
+
+    configureDnnPool(DEFAULT_DNN, "10.0.0.0/16", "fd00::/48");
+    configureDnnPool("ims", "10.1.0.0/16", "fd01::/48");
     logger_.info(name_, "SMF initialized");
 }
 
+const SMF::StateHandler SMF::stateHandlers_[SessionStateMachine::STATE_COUNT] = {
+    nullptr,                // IDLE
+    &SMF::onActivating,
+    &SMF::onActive,
+    &SMF::onModifying,
+    &SMF::onDeactivating,
+    &SMF::onTerminated
+};
+
 SessionId SMF::createPduSession(UeId ueId, const std::string& dnn, Snssai snssai) {
-    SessionId sessionId = ++sessionIdCounter;
+    if (sessions_.getUeSessionCount(ueId) >= MAX_PDU_SESSIONS_PER_UE) {
+        logger_.warning(name_, "UE " + std::to_string(ueId) + " already has " + 
+                               std::to_string(MAX_PDU_SESSIONS_PER_UE) + " PDU sessions");
+        return 0;
+    }
 
-    PduSessionContext context;
-    context.pduSessionId = sessionId;
-    context.ueId = ueId;
-    context.state = SessionState::ACTIVATING;
-    context.snssai = snssai;
-    context.dnn = dnn;
-    context.ipv4Address = generateIpv4Address();
-    context.ipv6Address = generateIpv6Address();
-    context.ulTraffic = 0;
-    context.dlTraffic = 0;
+    SessionId sessionId = sessionIdBatch_.allocate();
+    if (sessionId == 0) {
+        logger_.error(name_, "Session ID space exhausted");
+        return 0;
+    }
 
-    pduSessions_[sessionId] = context;
-    ueSessionMap_[ueId].push_back(sessionId);
+    SessionStore::Handle handle = sessions_.create(sessionId, ueId);
+    if (handle == SessionStore::INVALID_HANDLE) {
+        logger_.error(name_, "Session ID already in use: " + std::to_string(sessionId));
+        sessionIds_.release(sessionId);
+        return 0;
+    }
 
-    logSessionCreation(sessionId, ueId);
+    SessionStore::Session& session = sessions_.at(handle);
+    session.snssai = snssai;
+    session.dnnId = sessions_.internDnn(dnn);
+    allocateUeAddresses(session, dnn);
+    dispatchSessionEvent(session, {SessionEvent::ESTABLISH, KEEP_DNN, false});
 
     return sessionId;
 }
 
 bool SMF::activatePduSession(SessionId sessionId) {
-    auto it = pduSessions_.find(sessionId);
-    if (it == pduSessions_.end()) {
-        logger_.error(name_, "Session not found: " + std::to_string(sessionId));
-        return false;
-    }
-
-    it->second.state = SessionState::ACTIVE;
-    activeSessions_[sessionId] = SessionState::ACTIVE;
+    return activatePduSession(sessionId, defaultRules_);
+}
 
-    logSessionActivation(sessionId);
+bool SMF::activatePduSession(SessionId sessionId, const N4SessionRules& rules) {
+    if (!n4Sender_) {
+        return postSessionEvent(sessionId, PendingEvent{SessionEvent::ACTIVATE, KEEP_DNN, false});
+    }
 
-    return true;
+    // With N4 the session becomes active when the UPF confirms establishment
+    UserPlaneUpdate update;
+    update.fields = N4_FIELD_QOS | N4_FIELD_QOS_FLOW | N4_FIELD_URR;
+    update.rules = rules;
+    update.buffering = false;
+    return postUserPlaneUpdate(sessionId, SessionEvent::PROVISION, std::move(update));
 }
 
 bool SMF::modifyPduSession(SessionId sessionId, const std::string& newDnn) {
-    auto it = pduSessions_.find(sessionId);
-    if (it == pduSessions_.end()) {
-        logger_.error(name_, "Session not found: " + std::to_string(sessionId));
-        return false;
-    }
+    return postSessionEvent(sessionId, PendingEvent{SessionEvent::MODIFY, sessions_.internDnn(newDnn), false});
+}
 
-    if (it->second.state != SessionState::ACTIVE) {
-        logger_.warning(name_, "Cannot modify inactive session: " + std::to_string(sessionId));
-        return false;
-    }
+bool SMF::modifyPduSession(SessionId sessionId, const N4SessionRules& rules) {
+    UserPlaneUpdate update;
+    update.fields = N4_FIELD_QOS | N4_FIELD_QOS_FLOW | N4_FIELD_URR;
+    update.rules = rules;
+    update.buffering = false;
+    return postUserPlaneUpdate(sessionId, SessionEvent::MODIFY, std::move(update));
+}
 
-    it->second.state = SessionState::MODIFYING;
-    it->second.dnn = newDnn;
-    it->second.state = SessionState::ACTIVE;
+bool SMF::setDownlinkBuffering(SessionId sessionId, bool enabled) {
+    UserPlaneUpdate update;
+    update.fields = N4_FIELD_BUFFERING;
+    update.rules = defaultRules_;
+    update.buffering = enabled;
+    return postUserPlaneUpdate(sessionId, SessionEvent::MODIFY, std::move(update));
+}
 
-    logger_.info(name_, "Session modified: " + std::to_string(sessionId) + 
-                       " | New DNN: " + newDnn);
+bool SMF::installPacketDetectionRules(SessionId sessionId, const std::vector<PacketDetectionRule>& rules) {
+    UserPlaneUpdate update;
+    update.fields = N4_FIELD_PDRS;
+    update.rules = defaultRules_;
+    update.buffering = false;
+    update.pdrs = rules;
+    return postUserPlaneUpdate(sessionId, SessionEvent::MODIFY, std::move(update));
+}
 
-    return true;
+bool SMF::completePduSessionModification(SessionId sessionId) {
+    return postSessionEvent(sessionId, PendingEvent{SessionEvent::MODIFY_COMPLETE, KEEP_DNN, false});
 }
 
 bool SMF::releasePduSession(SessionId sessionId) {
-    auto it = pduSessions_.find(sessionId);
-    if (it == pduSessions_.end()) {
-        logger_.warning(name_, "Session not found for release: " + std::to_string(sessionId));
-        return false;
+    return postSessionEvent(sessionId, PendingEvent{SessionEvent::RELEASE, KEEP_DNN, false});
+}
+
+bool SMF::terminatePduSession(SessionId sessionId) {
+    return postSessionEvent(sessionId, PendingEvent{SessionEvent::TERMINATE, KEEP_DNN, false});
+}
+
+uint32_t SMF::terminateUeSessions(UeId ueId) {
+    const SessionStore::UeSessions* ue = sessions_.findUe(ueId);
+    if (!ue) {
+        return 0;
     }
 
-    it->second.state = SessionState::DEACTIVATING;
-    activeSessions_.erase(sessionId);
+    // Copy first: the set shrinks, and is freed, as sessions are erased
+    SessionStore::UeSessions handles = *ue;
+    for (uint32_t i = 0; i < handles.count; ++i) {
+        dispatchSessionEvent(sessions_.at(handles.handles[i]), {SessionEvent::TERMINATE, KEEP_DNN, false});
+    }
 
-    logger_.debug(name_, "Session deactivating: " + std::to_string(sessionId));
+    logger_.info(name_, "UE sessions terminated | UE=" + std::to_string(ueId) + 
+                       " | Sessions=" + std::to_string(handles.count));
+    return handles.count;
+}
 
-    return true;
+bool SMF::postSessionEvent(SessionId sessionId, SessionEvent event) {
+    return postSessionEvent(sessionId, PendingEvent{event, KEEP_DNN, false});
 }
 
-bool SMF::terminatePduSession(SessionId sessionId) {
-    auto it = pduSessions_.find(sessionId);
-    if (it == pduSessions_.end()) {
-        logger_.warning(name_, "Session not found for termination: " + std::to_string(sessionId));
-        return false;
+uint32_t SMF::getPendingEventCount(SessionId sessionId) const {
+    SessionStore::Handle handle = sessions_.find(sessionId);
+    return handle == SessionStore::INVALID_HANDLE ? 0 : sessions_.at(handle).pendingEvents;
+}
+
+std::vector<SessionId> SMF::createPduSessions(const std::vector<PduSessionRequest>& requests) {
+    std::vector<SessionId> sessionIds(requests.size(), 0);
+    sessions_.reserve(sessions_.size() + requests.size());
+    uint32_t idCount = sessionIds_.allocate(sessionIds.data(), static_cast<uint32_t>(requests.size()));
+
+    // New sessions are grouped by address pool so each pool is locked once
+    std::map<std::string, std::vector<SessionStore::Handle>> byPool;
+    std::vector<SessionStore::Handle>* group = nullptr;
+    const std::string* groupDnn = nullptr;
+    uint32_t created = 0;
+
+    std::vector<SessionId> unused;
+    for (size_t i = 0; i < idCount; ++i) {
+        const PduSessionRequest& request = requests[i];
+        SessionId sessionId = sessionIds[i];
+        SessionStore::Handle handle = sessions_.create(sessionId, request.ueId);
+        if (handle == SessionStore::INVALID_HANDLE) {
+            unused.push_back(sessionId);   // UE at its session limit
+            sessionIds[i] = 0;
+            continue;
+        }
+
+        SessionStore::Session& session = sessions_.at(handle);
+        session.snssai = request.snssai;
+        session.dnnId = sessions_.internDnn(request.dnn);
+        session.bulk = true;
+        created++;
+
+        if (!groupDnn || *groupDnn != request.dnn) {
+            groupDnn = &request.dnn;
+            group = &byPool[ipPool_.hasDnn(request.dnn) ? request.dnn : DEFAULT_DNN];
+        }
+        group->push_back(handle);
+    }
+
+    sessionIds_.release(unused.data(), static_cast<uint32_t>(unused.size()));
+    for (const auto& pair : byPool) {
+        allocateUeAddresses(pair.first, pair.second);
+    }
+
+    // Same transitions as one by one; with N4 sessions turn active as the
+    // UPF confirms each bundle
+    SessionEvent activation = n4Sender_ ? SessionEvent::PROVISION : SessionEvent::ACTIVATE;
+    for (const auto& pair : byPool) {
+        for (SessionStore::Handle handle : pair.second) {
+            SessionStore::Session& session = sessions_.at(handle);
+            dispatchSessionEvent(session, {SessionEvent::ESTABLISH, KEEP_DNN, false});
+            dispatchSessionEvent(session, {activation, KEEP_DNN, false});
+        }
     }
 
-    UeId ueId = it->second.ueId;
-    pduSessions_.erase(it);
-    activeSessions_.erase(sessionId);
+    flushN4Requests();
 
-    // Remove from UE session map
-    auto& ueSession = ueSessionMap_[ueId];
-    ueSession.erase(std::remove(ueSession.begin(), ueSession.end(), sessionId), 
-                    ueSession.end());
+    logger_.info(name_, "PDU Sessions established | Requested=" + std::to_string(requests.size()) + 
+                       " | Created=" + std::to_string(created) + 
+                       " | Rejected=" + std::to_string(requests.size() - created));
+    return sessionIds;
+}
 
-    logSessionTermination(sessionId);
+uint32_t SMF::releasePduSessions(const std::vector<SessionId>& sessionIds) {
+    // Sessions the UPF confirms, or all of them without N4, free their
+    // addresses and IDs in one batch per pool at the end
+    ReleaseBatch batch;
+    batch.ipv4.reserve(sessionIds.size());
+    batch.ipv6.reserve(sessionIds.size());
+    batch.sessionIds.reserve(sessionIds.size());
+    releaseBatch_ = &batch;
+
+    uint32_t released = 0;
+    for (SessionId sessionId : sessionIds) {
+        SessionStore::Session* session = findSession(sessionId);
+        if (!session) {
+            continue;
+        }
+        session->bulk = true;
+        if (!dispatchSessionEvent(*session, {SessionEvent::RELEASE, KEEP_DNN, false})) {
+            continue;
+        }
+        released++;
 
-    return true;
+        // With N4 the DELETE answer terminates the session; without one
+        // there is no user plane to wait for
+        if (!n4Sender_) {
+            dispatchSessionEvent(*session, {SessionEvent::TERMINATE, KEEP_DNN, true});
+        }
+    }
+    flushN4Requests();
+
+    releaseBatch_ = nullptr;
+    sessionIds_.release(batch.sessionIds.data(), static_cast<uint32_t>(batch.sessionIds.size()));
+    ipPool_.releaseIpv4(batch.ipv4.data(), static_cast<uint32_t>(batch.ipv4.size()));
+    ipPool_.releaseIpv6Prefixes(batch.ipv6.data(), static_cast<uint32_t>(batch.ipv6.size()));
+
+    logger_.info(name_, "PDU Sessions released | Requested=" + std::to_string(sessionIds.size()) + 
+                       " | Released=" + std::to_string(released));
+    return released;
 }
 
-PduSessionContext* SMF::getPduSessionContext(SessionId sessionId) {
-    auto it = pduSessions_.find(sessionId);
-    if (it != pduSessions_.end()) {
-        return &it->second;
+bool SMF::getPduSessionContext(SessionId sessionId, PduSessionContext& context) const {
+    SessionStore::Handle handle = sessions_.find(sessionId);
+    if (handle == SessionStore::INVALID_HANDLE) {
+        return false;
     }
-    return nullptr;
+
+    // Expand the compact record into the descriptive context
+    const SessionStore::Session& session = sessions_.at(handle);
+    context.pduSessionId = session.sessionId;
+    context.ueId = session.ueId;
+    context.state = session.state;
+    context.snssai = session.snssai;
+    context.dnn = sessions_.getDnnName(session.dnnId);
+    context.ipv4Address = session.ipv4 ? IpPool::formatIpv4(session.ipv4) : "";
+    context.ipv6Address = session.ipv6Prefix ? IpPool::formatIpv6Prefix(session.ipv6Prefix) : "";
+    context.ulTraffic = session.ulTraffic;
+    context.dlTraffic = session.dlTraffic;
+    return true;
 }
 
 bool SMF::isSessionActive(SessionId sessionId) const {
-    return activeSessions_.find(sessionId) != activeSessions_.end();
+    SessionStore::Handle handle = sessions_.find(sessionId);
+    return handle != SessionStore::INVALID_HANDLE &&
+           sessions_.at(handle).state == SessionState::ACTIVE;
 }
 
 std::vector<SessionId> SMF::getActiveSessions(UeId ueId) const {
     std::vector<SessionId> result;
-    
-    auto it = ueSessionMap_.find(ueId);
-    if (it != ueSessionMap_.end()) {
-        for (SessionId sessionId : it->second) {
-            if (isSessionActive(sessionId)) {
-                result.push_back(sessionId);
+
+    // Handles in the UE's set point straight at the session records
+    const SessionStore::UeSessions* ue = sessions_.findUe(ueId);
+    if (ue) {
+        for (uint32_t i = 0; i < ue->count; ++i) {
+            const SessionStore::Session& session = sessions_.at(ue->handles[i]);
+            if (session.state == SessionState::ACTIVE) {
+                result.push_back(session.sessionId);
             }
         }
     }
@@ -133,24 +282,60 @@ std::vector<SessionId> SMF::getActiveSessions(UeId ueId) const {
     return result;
 }
 
+uint32_t SMF::getUeSessionCount(UeId ueId) const {
+    return sessions_.getUeSessionCount(ueId);
+}
+
 void SMF::recordUplink(SessionId sessionId, uint64_t bytes) {
-    auto it = pduSessions_.find(sessionId);
-    if (it != pduSessions_.end()) {
-        it->second.ulTraffic += bytes;
+    SessionStore::Session* session = findSession(sessionId);
+    if (session) {
+        session->ulTraffic += bytes;
         logger_.debug(name_, "Uplink recorded: Session=" + std::to_string(sessionId) + 
                             " | Bytes=" + std::to_string(bytes));
     }
 }
 
 void SMF::recordDownlink(SessionId sessionId, uint64_t bytes) {
-    auto it = pduSessions_.find(sessionId);
-    if (it != pduSessions_.end()) {
-        it->second.dlTraffic += bytes;
+    SessionStore::Session* session = findSession(sessionId);
+    if (session) {
+        session->dlTraffic += bytes;
         logger_.debug(name_, "Downlink recorded: Session=" + std::to_string(sessionId) + 
                             " | Bytes=" + std::to_string(bytes));
     }
 }
 
+void SMF::applyUsageReports(const std::vector<UsageReport>& reports) {
+    // Traffic totals come from counter deltas; reports mark URR events only
+    size_t known = 0;
+    for (const auto& report : reports) {
+        if (sessions_.find(report.sessionId) != SessionStore::INVALID_HANDLE) {
+            known++;
+        }
+    }
+
+    logger_.debug(name_, "Usage reports received: " + std::to_string(known) + 
+                        "/" + std::to_string(reports.size()));
+}
+
+size_t SMF::applyCounterDeltas(uint32_t epoch, const std::vector<CounterDelta>& deltas) {
+    size_t applied = 0;
+    for (const auto& delta : deltas) {
+        SessionStore::Handle handle = sessions_.find(delta.sessionId);
+        if (handle == SessionStore::INVALID_HANDLE) {
+            continue;  // Released before the epoch closed
+        }
+        SessionStore::Session& session = sessions_.at(handle);
+        session.ulTraffic += delta.ulBytes;
+        session.dlTraffic += delta.dlBytes;
+        applied++;
+    }
+    counterEpoch_ = std::max(counterEpoch_, epoch);
+
+    logger_.debug(name_, "Counter deltas applied | Epoch=" + std::to_string(epoch) + 
+                        " | Sessions=" + std::to_string(applied) + "/" + std::to_string(deltas.size()));
+    return applied;
+}
+
 void SMF::handleMessage(std::shared_ptr<Message> message) {
     if (!message) return;
 
@@ -172,6 +357,22 @@ void SMF::handleMessage(std::shared_ptr<Message> message) {
             }
             break;
         }
+        case MessageType::DOWNLINK_DATA_NOTIFICATION: {
+            auto ddnMsg = std::dynamic_pointer_cast<DownlinkDataNotificationMessage>(message);
+            if (ddnMsg && sessions_.find(ddnMsg->getSessionId()) != SessionStore::INVALID_HANDLE) {
+                logger_.info(name_, "Downlink data pending for idle UE " + 
+                                   std::to_string(message->getSourceId()) + 
+                                   " | Session=" + std::to_string(ddnMsg->getSessionId()));
+            }
+            break;
+        }
+        case MessageType::USAGE_REPORT: {
+            auto reportMsg = std::dynamic_pointer_cast<UsageReportMessage>(message);
+            if (reportMsg) {
+                applyUsageReports(reportMsg->getReports());
+            }
+            break;
+        }
         default:
             logger_.warning(name_, "Unknown message type");
             break;
@@ -180,52 +381,459 @@ void SMF::handleMessage(std::shared_ptr<Message> message) {
 
 void SMF::printActiveSessions() const {
     std::cout << "\n================== SMF Active Sessions ==================\n";
-    std::cout << "Total Sessions: " << pduSessions_.size() << "\n";
-    std::cout << "Active Sessions: " << activeSessions_.size() << "\n\n";
+    std::cout << "Total Sessions: " << sessions_.size() << "\n";
+    std::cout << "Active Sessions: " << activeSessionCount_ << "\n\n";
 
-    for (const auto& pair : pduSessions_) {
-        const auto& session = pair.second;
-        std::cout << "Session ID: " << session.pduSessionId 
+    sessions_.forEach([this](const SessionStore::Session& session) {
+        std::cout << "Session ID: " << session.sessionId 
                   << " | UE: " << session.ueId 
-                  << " | DNN: " << session.dnn 
-                  << " | IPv4: " << session.ipv4Address 
+                  << " | DNN: " << sessions_.getDnnName(session.dnnId) 
+                  << " | IPv4: " << IpPool::formatIpv4(session.ipv4) 
                   << " | UL: " << session.ulTraffic << "B"
                   << " | DL: " << session.dlTraffic << "B\n";
-    }
+    });
     std::cout << "========================================================\n\n";
 }
 
 std::string SMF::getSMFStatus() const {
     std::ostringstream oss;
     oss << "SMF Status:\n"
-        << "  Total Sessions: " << pduSessions_.size() << "\n"
-        << "  Active Sessions: " << activeSessions_.size() << "\n";
+        << "  Total Sessions: " << sessions_.size() << "\n"
+        << "  Active Sessions: " << activeSessionCount_ << "\n"
+        << "  Session Store: " << (sessions_.getMemoryBytes() / 1024) << " KB\n";
     return oss.str();
 }
 
-std::string SMF::generateIpv4Address() {
-    std::ostringstream oss;
-    oss << "10.0." << (ipAddrCounter / 256) << "." << (ipAddrCounter % 256);
-    ipAddrCounter++;
-    return oss.str();
+bool SMF::configureDnnPool(const std::string& dnn, const std::string& ipv4Cidr,
+                           const std::string& ipv6Prefix) {
+    if (!ipPool_.addIpv4Pool(dnn, ipv4Cidr) || !ipPool_.addIpv6Pool(dnn, ipv6Prefix)) {
+        logger_.error(name_, "Invalid address pool for DNN " + dnn + ": " + 
+                            ipv4Cidr + " / " + ipv6Prefix);
+        return false;
+    }
+
+    logger_.info(name_, "Address pool configured | DNN=" + dnn + 
+                       " | IPv4=" + ipv4Cidr + " | IPv6=" + ipv6Prefix);
+    return true;
 }
 
-std::string SMF::generateIpv6Address() {
-    std::ostringstream oss;
-    oss << "fd00::" << std::hex << ipAddrCounter;
-    return oss.str();
+SessionStore::Session* SMF::findSession(SessionId sessionId) {
+    SessionStore::Handle handle = sessions_.find(sessionId);
+    return handle == SessionStore::INVALID_HANDLE ? nullptr : &sessions_.at(handle);
+}
+
+bool SMF::postSessionEvent(SessionId sessionId, const PendingEvent& event) {
+    SessionStore::Session* session = findSession(sessionId);
+    if (!session) {
+        const char* reason = sessionIds_.isStale(sessionId) ? "Stale session ID: " : "Session not found: ";
+        logger_.warning(name_, reason + std::to_string(sessionId) + 
+                               " | Event=" + SessionStateMachine::toString(event.event));
+        return false;
+    }
+
+    bool accepted = dispatchSessionEvent(*session, event);
+
+    // TERMINATE is never deferred, so a session with a queue is still live
+    if (event.event != SessionEvent::TERMINATE && session->pendingEvents > 0) {
+        replayPendingEvents(*session);
+    }
+    return accepted;
+}
+
+bool SMF::dispatchSessionEvent(SessionStore::Session& session, const PendingEvent& event) {
+    SessionTransition transition = SessionStateMachine::lookup(session.state, event.event);
+
+    if (transition.action == TransitionAction::DEFER) {
+        if (session.pendingEvents >= MAX_PENDING_EVENTS) {
+            logger_.warning(name_, "Session event queue full | Session=" + std::to_string(session.sessionId) + 
+                                   " | Event=" + SessionStateMachine::toString(event.event));
+            return false;
+        }
+        pendingEvents_[session.sessionId].push_back(event);
+        session.pendingEvents++;
+        logger_.debug(name_, "Session event deferred | Session=" + std::to_string(session.sessionId) + 
+                            " | Event=" + SessionStateMachine::toString(event.event) + 
+                            " | State=" + SessionStateMachine::toString(session.state));
+        return true;
+    }
+
+    if (transition.action == TransitionAction::REJECT) {
+        logger_.warning(name_, "Invalid session event | Session=" + std::to_string(session.sessionId) + 
+                               " | Event=" + SessionStateMachine::toString(event.event) + 
+                               " | State=" + SessionStateMachine::toString(session.state));
+        return false;
+    }
+
+    setSessionState(session, transition.next);
+    StateHandler handler = stateHandlers_[static_cast<size_t>(transition.next)];
+    if (handler) {
+        (this->*handler)(session, event);
+    }
+    return true;
+}
+
+void SMF::replayPendingEvents(SessionStore::Session& session) {
+    // Stops at the next transient state; its completion event resumes the replay
+    while (session.pendingEvents > 0 && !SessionStateMachine::isTransient(session.state)) {
+        auto it = pendingEvents_.find(session.sessionId);
+        PendingEvent next = it->second.front();
+        it->second.pop_front();
+        if (--session.pendingEvents == 0) {
+            pendingEvents_.erase(it);
+        }
+        dispatchSessionEvent(session, next);
+    }
+}
+
+void SMF::onActivating(SessionStore::Session& session, const PendingEvent& event) {
+    if (event.event == SessionEvent::ESTABLISH) {
+        if (!session.bulk) {
+            logSessionCreation(session.sessionId, session.ueId);
+        }
+        return;
+    }
+
+    // PROVISION: the UPF's answer brings ACTIVATE, or TERMINATE on refusal
+    auto it = userPlaneUpdates_.find(session.sessionId);
+    if (it == userPlaneUpdates_.end()) {
+        queueN4Operation(N4Operation::ESTABLISH, session,
+                         N4_FIELD_QOS | N4_FIELD_QOS_FLOW | N4_FIELD_URR, defaultRules_);
+    } else {
+        queueN4Operation(N4Operation::ESTABLISH, session, std::move(it->second));
+        userPlaneUpdates_.erase(it);
+    }
+}
+
+void SMF::onActive(SessionStore::Session& session, const PendingEvent& event) {
+    if (event.event == SessionEvent::ACTIVATE) {
+        if (!session.bulk) {
+            logSessionActivation(session.sessionId);
+        }
+    } else if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Session modified: " + std::to_string(session.sessionId) + 
+                           " | New DNN: " + sessions_.getDnnName(session.dnnId));
+    }
+}
+
+void SMF::onModifying(SessionStore::Session& session, const PendingEvent& event) {
+    if (event.dnnId != KEEP_DNN) {
+        session.dnnId = event.dnnId;
+    }
+    if (n4Sender_) {
+        // The UPF keeps no per-DNN state: a DNN change alone carries no rules
+        auto it = userPlaneUpdates_.find(session.sessionId);
+        if (it == userPlaneUpdates_.end()) {
+            queueN4Operation(N4Operation::MODIFY, session, 0, defaultRules_);
+        } else {
+            queueN4Operation(N4Operation::MODIFY, session, std::move(it->second));
+            userPlaneUpdates_.erase(it);
+        }
+    }
+    if (logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Session modifying: " + std::to_string(session.sessionId));
+    }
+}
+
+void SMF::onDeactivating(SessionStore::Session& session, const PendingEvent& /*event*/) {
+    if (n4Sender_) {
+        queueN4Operation(N4Operation::DELETE, session, 0, defaultRules_);
+    }
+    if (!session.bulk && logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Session deactivating: " + std::to_string(session.sessionId));
+    }
+}
+
+// The only place a session's resources are freed, however it ended
+void SMF::onTerminated(SessionStore::Session& session, const PendingEvent& event) {
+    SessionId sessionId = session.sessionId;
+    if (n4Sender_ && !event.userPlaneAck) {
+        queueN4Operation(N4Operation::DELETE, session, 0, defaultRules_);
+    }
+    if (session.pendingEvents > 0) {
+        pendingEvents_.erase(sessionId);
+    }
+    if (!userPlaneUpdates_.empty()) {
+        userPlaneUpdates_.erase(sessionId);
+    }
+
+    bool bulk = session.bulk;
+    if (releaseBatch_) {
+        if (session.ipv4 != 0) {
+            releaseBatch_->ipv4.push_back(session.ipv4);
+        }
+        if (session.ipv6Prefix != 0) {
+            releaseBatch_->ipv6.push_back(session.ipv6Prefix);
+        }
+        releaseBatch_->sessionIds.push_back(sessionId);
+    } else {
+        releaseUeAddresses(session);
+        sessionIds_.release(sessionId);
+    }
+    sessions_.erase(sessionId);  // Also leaves the UE's session set
+
+    if (!bulk) {
+        logSessionTermination(sessionId);
+    }
+}
+
+bool SMF::postUserPlaneUpdate(SessionId sessionId, SessionEvent event, UserPlaneUpdate&& update) {
+    if (!n4Sender_) {
+        logger_.warning(name_, "No N4 peer for user plane update | Session=" + std::to_string(sessionId));
+        return false;
+    }
+
+    // Updates made while an N4 request is under way merge into the next one
+    auto inserted = userPlaneUpdates_.try_emplace(sessionId, std::move(update));
+    if (!inserted.second) {
+        UserPlaneUpdate& pending = inserted.first->second;
+        if (update.fields & (N4_FIELD_QOS | N4_FIELD_QOS_FLOW | N4_FIELD_URR)) {
+            pending.rules = update.rules;
+        }
+        if (update.fields & N4_FIELD_BUFFERING) {
+            pending.buffering = update.buffering;
+        }
+        if (update.fields & N4_FIELD_PDRS) {
+            pending.pdrs = std::move(update.pdrs);
+        }
+        pending.fields |= update.fields;
+    }
+
+    if (!postSessionEvent(sessionId, PendingEvent{event, KEEP_DNN, false})) {
+        userPlaneUpdates_.erase(sessionId);
+        return false;
+    }
+    return true;
+}
+
+void SMF::queueN4Operation(N4Operation operation, const SessionStore::Session& session,
+                           uint8_t fields, const N4SessionRules& rules) {
+    UserPlaneUpdate update;
+    update.fields = fields;
+    update.rules = rules;
+    update.buffering = false;
+    queueN4Operation(operation, session, std::move(update));
+}
+
+void SMF::queueN4Operation(N4Operation operation, const SessionStore::Session& session,
+                           UserPlaneUpdate&& update) {
+    n4Queue_.emplace_back();
+    N4SessionOperation& op = n4Queue_.back();
+    op.operation = operation;
+    op.fields = update.fields;
+    op.sessionId = session.sessionId;
+    op.ueId = session.ueId;
+    op.rules = update.rules;
+    op.buffering = update.buffering;
+    op.pdrs = std::move(update.pdrs);
+
+    // A full bundle goes out without waiting for the caller's flush
+    if (getN4QueuedCount() >= N4_MAX_BUNDLE) {
+        flushN4Requests();
+    }
+}
+
+uint32_t SMF::flushN4Requests() {
+    // Responses delivered synchronously re-enter here; the outer loop sends
+    if (!n4Sender_ || n4Flushing_) {
+        return 0;
+    }
+    n4Flushing_ = true;
+
+    uint32_t sent = 0;
+    std::vector<uint8_t> message;
+    while (n4QueueHead_ < n4Queue_.size() && n4InFlight_.size() < N4_MAX_IN_FLIGHT) {
+        size_t count = std::min(n4Queue_.size() - n4QueueHead_, N4_MAX_BUNDLE);
+        uint32_t sequence = ++n4Sequence_;
+
+        message.clear();
+        N4Codec::encodeSessionRequest(sequence, n4Queue_.data() + n4QueueHead_, count, message);
+        n4QueueHead_ += count;
+        n4InFlight_[sequence] = static_cast<uint32_t>(count);
+        sent++;
+
+        n4Sender_(message.data(), message.size());
+    }
+
+    if (n4QueueHead_ == n4Queue_.size()) {
+        n4Queue_.clear();
+        n4QueueHead_ = 0;
+    } else if (n4QueueHead_ > n4Queue_.size() / 2) {
+        n4Queue_.erase(n4Queue_.begin(), n4Queue_.begin() + n4QueueHead_);
+        n4QueueHead_ = 0;
+    }
+    n4Flushing_ = false;
+
+    if (sent > 0) {
+        logger_.debug(name_, "N4 requests sent: " + std::to_string(sent) + 
+                            " | In flight=" + std::to_string(n4InFlight_.size()));
+    }
+    return sent;
+}
+
+void SMF::handleN4Message(const uint8_t* data, size_t length) {
+    N4Header header;
+    if (!N4Codec::decodeHeader(data, length, header)) {
+        logger_.warning(name_, "Malformed N4 message dropped | Length=" + std::to_string(length));
+        return;
+    }
+
+    if (header.type == N4MessageType::COUNTER_DELTAS) {
+        std::vector<CounterDelta> deltas;
+        if (N4Codec::decodeCounterDeltas(data, length, deltas)) {
+            applyCounterDeltas(header.sequence, deltas);
+        } else {
+            logger_.warning(name_, "Malformed N4 counter deltas | Epoch=" + std::to_string(header.sequence));
+        }
+        return;
+    }
+
+    if (header.type == N4MessageType::USAGE_REPORT) {
+        std::vector<UsageReport> reports;
+        if (N4Codec::decodeUsageReport(data, length, reports)) {
+            applyUsageReports(reports);
+        } else {
+            logger_.warning(name_, "Malformed N4 usage report | Seq=" + std::to_string(header.sequence));
+        }
+        return;
+    }
+
+    std::vector<N4SessionResult> results;
+    if (header.type != N4MessageType::SESSION_RESPONSE ||
+        !N4Codec::decodeSessionResponse(data, length, results)) {
+        logger_.warning(name_, "Unexpected N4 message | Seq=" + std::to_string(header.sequence));
+        return;
+    }
+
+    auto it = n4InFlight_.find(header.sequence);
+    if (it == n4InFlight_.end()) {
+        logger_.warning(name_, "N4 response without request | Seq=" + std::to_string(header.sequence));
+        return;
+    }
+    n4InFlight_.erase(it);
+
+    for (const auto& result : results) {
+        applyN4Result(result);
+    }
+
+    // The window has room again
+    flushN4Requests();
+}
+
+void SMF::applyN4Result(const N4SessionResult& result) {
+    if (!findSession(result.sessionId)) {
+        return;  // Released while the request was in flight
+    }
+
+    bool accepted = result.cause == N4Cause::ACCEPTED ||
+                    (result.operation == N4Operation::ESTABLISH && result.cause == N4Cause::SESSION_EXISTS);
+    if (!accepted) {
+        logger_.warning(name_, std::string("N4 ") + N4Codec::toString(result.operation) + 
+                               " failed | Session=" + std::to_string(result.sessionId) + 
+                               " | Cause=" + N4Codec::toString(result.cause));
+    }
+
+    switch (result.operation) {
+        case N4Operation::ESTABLISH:
+            // Without a user plane the session cannot be used
+            postSessionEvent(result.sessionId, PendingEvent{
+                accepted ? SessionEvent::ACTIVATE : SessionEvent::TERMINATE, KEEP_DNN, true});
+            break;
+        case N4Operation::MODIFY:
+            if (result.cause == N4Cause::SESSION_NOT_FOUND) {
+                // The UPF lost the session: nothing is left to delete there
+                postSessionEvent(result.sessionId, PendingEvent{SessionEvent::TERMINATE, KEEP_DNN, true});
+                break;
+            }
+            if (!accepted) {
+                // The UPF validates before changing anything, so a refusal
+                // leaves it on the last accepted rules: drop the change and
+                // go back to ACTIVE
+                userPlaneUpdates_.erase(result.sessionId);
+            }
+            postSessionEvent(result.sessionId, PendingEvent{SessionEvent::MODIFY_COMPLETE, KEEP_DNN, true});
+            break;
+        case N4Operation::DELETE:
+            postSessionEvent(result.sessionId, PendingEvent{SessionEvent::TERMINATE, KEEP_DNN, true});
+            break;
+    }
+}
+
+void SMF::setSessionState(SessionStore::Session& session, SessionState state) {
+    // The active count replaces a separate set of active sessions
+    if (session.state == SessionState::ACTIVE && state != SessionState::ACTIVE) {
+        activeSessionCount_--;
+    } else if (session.state != SessionState::ACTIVE && state == SessionState::ACTIVE) {
+        activeSessionCount_++;
+    }
+    session.state = state;
+}
+
+void SMF::allocateUeAddresses(SessionStore::Session& session, const std::string& dnn) {
+    // DNNs without their own pool draw from the default DNN
+    const std::string& poolDnn = ipPool_.hasDnn(dnn) ? dnn : DEFAULT_DNN;
+
+    if (!ipPool_.allocateIpv4(poolDnn, session.ipv4)) {
+        session.ipv4 = 0;
+        logger_.warning(name_, "IPv4 pool exhausted | DNN=" + poolDnn + 
+                               " | Session=" + std::to_string(session.sessionId));
+    }
+
+    if (!ipPool_.allocateIpv6Prefix(poolDnn, session.ipv6Prefix)) {
+        session.ipv6Prefix = 0;
+        logger_.warning(name_, "IPv6 prefix pool exhausted | DNN=" + poolDnn + 
+                               " | Session=" + std::to_string(session.sessionId));
+    }
+}
+
+void SMF::allocateUeAddresses(const std::string& poolDnn,
+                              const std::vector<SessionStore::Handle>& handles) {
+    uint32_t count = static_cast<uint32_t>(handles.size());
+    std::vector<uint32_t> ipv4(count);
+    std::vector<uint64_t> ipv6(count);
+    uint32_t ipv4Count = ipPool_.allocateIpv4(poolDnn, ipv4.data(), count);
+    uint32_t ipv6Count = ipPool_.allocateIpv6Prefixes(poolDnn, ipv6.data(), count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        SessionStore::Session& session = sessions_.at(handles[i]);
+        session.ipv4 = i < ipv4Count ? ipv4[i] : 0;
+        session.ipv6Prefix = i < ipv6Count ? ipv6[i] : 0;
+    }
+
+    if (ipv4Count < count || ipv6Count < count) {
+        logger_.warning(name_, "Address pool exhausted | DNN=" + poolDnn + 
+                               " | IPv4 short=" + std::to_string(count - ipv4Count) + 
+                               " | IPv6 short=" + std::to_string(count - ipv6Count));
+    }
+}
+
+void SMF::releaseUeAddresses(const SessionStore::Session& session) {
+    if (session.ipv4 != 0) {
+        ipPool_.releaseIpv4(session.ipv4);
+    }
+    if (session.ipv6Prefix != 0) {
+        ipPool_.releaseIpv6Prefix(session.ipv6Prefix);
+    }
 }
 
 void SMF::logSessionCreation(SessionId sessionId, UeId ueId) {
+    if (!logger_.isEnabled(LogLevel::INFO)) {
+        return;
+    }
     logger_.info(name_, "PDU Session Created | ID=" + std::to_string(sessionId) + 
                        " | UE=" + std::to_string(ueId));
 }
 
 void SMF::logSessionActivation(SessionId sessionId) {
+    if (!logger_.isEnabled(LogLevel::INFO)) {
+        return;
+    }
     logger_.info(name_, "PDU Session Activated | ID=" + std::to_string(sessionId));
 }
 
 void SMF::logSessionTermination(SessionId sessionId) {
+    if (!logger_.isEnabled(LogLevel::INFO)) {
+        return;
+    }
     logger_.info(name_, "PDU Session Terminated | ID=" + std::to_string(sessionId));
 }
 
@@ -236,8 +844,20 @@ void SMF::start() {
 
 void SMF::stop() {
     NetworkFunction::stop();
-    pduSessions_.clear();
-    ueSessionMap_.clear();
-    activeSessions_.clear();
+    std::vector<SessionId> live;
+    live.reserve(sessions_.size());
+    sessions_.forEach([this, &live](const SessionStore::Session& session) {
+        releaseUeAddresses(session);
+        live.push_back(session.sessionId);
+    });
+    sessionIds_.release(live.data(), static_cast<uint32_t>(live.size()));
+    sessionIdBatch_.flush();
+    sessions_.clear();
+    pendingEvents_.clear();
+    n4Queue_.clear();
+    n4QueueHead_ = 0;
+    n4InFlight_.clear();
+    userPlaneUpdates_.clear();
+    activeSessionCount_ = 0;
     logger_.info(name_, "SMF stopped");
 }
@@ -3,7 +3,14 @@
 
 #include "../common/NetworkFunction.hpp"
 #include "../common/Types.hpp"
+#include "../common/N4Protocol.hpp"
+#include "IpPool.hpp"
+#include "SessionIdAllocator.hpp"
+#include "SessionStateMachine.hpp"
+#include "SessionStore.hpp"
+#include <deque>
 #include <map>
+#include <unordered_map>
 
 class SMF : public NetworkFunction {
 public:
@@ -13,18 +20,69 @@ public:
     // PDU Session Management
     SessionId createPduSession(UeId ueId, const std::string& dnn, Snssai snssai);
     bool activatePduSession(SessionId sessionId);
+    bool activatePduSession(SessionId sessionId, const N4SessionRules& rules);
     bool modifyPduSession(SessionId sessionId, const std::string& newDnn);
+    bool modifyPduSession(SessionId sessionId, const N4SessionRules& rules);
     bool releasePduSession(SessionId sessionId);
     bool terminatePduSession(SessionId sessionId);
+    bool completePduSessionModification(SessionId sessionId);
+    uint32_t terminateUeSessions(UeId ueId);
+
+    // Bulk establishment and release for mass attach/detach, with the same
+    // transitions as the single-session calls. With N4, sessions stay
+    // ACTIVATING until the UPF confirms them, and released ones stay
+    // DEACTIVATING, keeping their addresses, until it confirms the deletion;
+    // without N4 both complete at once. The returned IDs line up with the
+    // requests, with 0 for a rejected request. Each call logs one summary
+    // line; its sessions log nothing of their own.
+    std::vector<SessionId> createPduSessions(const std::vector<PduSessionRequest>& requests);
+    uint32_t releasePduSessions(const std::vector<SessionId>& sessionIds);
+
+    // Feeds one event through the session state machine. Events that arrive
+    // while the session is in a transient state are queued on the session and
+    // replayed in order once it settles; returns false only on rejection.
+    bool postSessionEvent(SessionId sessionId, SessionEvent event);
+    uint32_t getPendingEventCount(SessionId sessionId) const;
+
+    // N4 towards the UPF. Once a sender is set, activation, modification and
+    // release are provisioned on the UPF and complete when it answers; the
+    // operations are queued and go out bundled on flushN4Requests(), with up
+    // to N4_MAX_IN_FLIGHT requests pipelined. Without a sender the SMF
+    // completes transitions itself.
+    void setN4Sender(N4Sender sender) { n4Sender_ = std::move(sender); }
+    void setDefaultUserPlaneRules(const N4SessionRules& rules) { defaultRules_ = rules; }
+    uint32_t flushN4Requests();
+    void handleN4Message(const uint8_t* data, size_t length);
+    size_t getN4QueuedCount() const { return n4Queue_.size() - n4QueueHead_; }
+    size_t getN4InFlightCount() const { return n4InFlight_.size(); }
+
+    // User-plane changes of a live session go to the UPF as N4
+    // modifications; the session is MODIFYING until the UPF answers. A
+    // refused modification is dropped and the session goes back to ACTIVE on
+    // its previous user plane. They need an N4 sender.
+    bool setDownlinkBuffering(SessionId sessionId, bool enabled);
+    bool installPacketDetectionRules(SessionId sessionId, const std::vector<PacketDetectionRule>& rules);
+
+    // UE Address Pools
+    bool configureDnnPool(const std::string& dnn, const std::string& ipv4Cidr,
+                          const std::string& ipv6Prefix);
+    const IpPool& getIpPool() const { return ipPool_; }
 
     // Session Queries
-    PduSessionContext* getPduSessionContext(SessionId sessionId);
+    bool getPduSessionContext(SessionId sessionId, PduSessionContext& context) const;
     bool isSessionActive(SessionId sessionId) const;
     std::vector<SessionId> getActiveSessions(UeId ueId) const;
+    uint32_t getUeSessionCount(UeId ueId) const;
 
     // Traffic Handling
     void recordUplink(SessionId sessionId, uint64_t bytes);
     void recordDownlink(SessionId sessionId, uint64_t bytes);
+    void applyUsageReports(const std::vector<UsageReport>& reports);
+
+    // Session traffic counters follow the UPF through per-epoch delta
+    // batches (see UPF::publishCounterDeltas); one pass per batch
+    size_t applyCounterDeltas(uint32_t epoch, const std::vector<CounterDelta>& deltas);
+    uint32_t getCounterEpoch() const { return counterEpoch_; }
 
     // Message Handling
     void handleMessage(std::shared_ptr<Message> message) override;
@@ -32,18 +90,84 @@ public:
     // Statistics
     void printActiveSessions() const;
     std::string getSMFStatus() const;
-    uint32_t getActiveSessionCount() const { return activeSessions_.size(); }
+    uint32_t getActiveSessionCount() const { return activeSessionCount_; }
+    uint32_t getSessionCount() const { return static_cast<uint32_t>(sessions_.size()); }
+    const SessionIdAllocator& getSessionIdAllocator() const { return sessionIds_; }
 
     void start() override;
     void stop() override;
 
 private:
-    std::map<SessionId, PduSessionContext> pduSessions_;
-    std::map<UeId, std::vector<SessionId>> ueSessionMap_;
-    std::map<SessionId, SessionState> activeSessions_;
+    static constexpr uint32_t MAX_PENDING_EVENTS = 8;
+    static constexpr SessionStore::DnnId KEEP_DNN = 0xFFFF;
+    static constexpr size_t N4_MAX_BUNDLE = 1024;
+    static constexpr size_t N4_MAX_IN_FLIGHT = 32;
+
+    struct PendingEvent {
+        SessionEvent event;
+        SessionStore::DnnId dnnId;   // New DNN for MODIFY
+        bool userPlaneAck;           // Raised by an N4 response
+    };
+
+    // Rule fields the session's next N4 modification carries
+    struct UserPlaneUpdate {
+        uint8_t fields;              // N4_FIELD_* set below
+        N4SessionRules rules;
+        bool buffering;
+        std::vector<PacketDetectionRule> pdrs;
+    };
+
+    typedef void (SMF::*StateHandler)(SessionStore::Session& session, const PendingEvent& event);
+    static const StateHandler stateHandlers_[SessionStateMachine::STATE_COUNT];
+
+    SessionIdAllocator sessionIds_;
+    SessionIdAllocator::Batch sessionIdBatch_;
+    SessionStore sessions_;
+    std::unordered_map<SessionId, std::deque<PendingEvent>> pendingEvents_;
+    uint32_t activeSessionCount_;
+    uint32_t counterEpoch_;
+    IpPool ipPool_;
+
+    // Resources of sessions terminated during releasePduSessions, freed
+    // together when it returns
+    struct ReleaseBatch {
+        std::vector<uint32_t> ipv4;
+        std::vector<uint64_t> ipv6;
+        std::vector<SessionId> sessionIds;
+    };
+    ReleaseBatch* releaseBatch_;
+
+    N4Sender n4Sender_;
+    N4SessionRules defaultRules_;
+    std::vector<N4SessionOperation> n4Queue_;
+    size_t n4QueueHead_;                                 // First unsent operation
+    std::unordered_map<uint32_t, uint32_t> n4InFlight_;  // Sequence -> operations
+    std::unordered_map<SessionId, UserPlaneUpdate> userPlaneUpdates_;
+    uint32_t n4Sequence_;
+    bool n4Flushing_;
+
+    SessionStore::Session* findSession(SessionId sessionId);
+    bool postSessionEvent(SessionId sessionId, const PendingEvent& event);
+    bool dispatchSessionEvent(SessionStore::Session& session, const PendingEvent& event);
+    void replayPendingEvents(SessionStore::Session& session);
+    bool postUserPlaneUpdate(SessionId sessionId, SessionEvent event, UserPlaneUpdate&& update);
+    void queueN4Operation(N4Operation operation, const SessionStore::Session& session,
+                          uint8_t fields, const N4SessionRules& rules);
+    void queueN4Operation(N4Operation operation, const SessionStore::Session& session,
+                          UserPlaneUpdate&& update);
+    void applyN4Result(const N4SessionResult& result);
+
+    // State entry handlers, indexed by SessionState
+    void onActivating(SessionStore::Session& session, const PendingEvent& event);
+    void onActive(SessionStore::Session& session, const PendingEvent& event);
+    void onModifying(SessionStore::Session& session, const PendingEvent& event);
+    void onDeactivating(SessionStore::Session& session, const PendingEvent& event);
+    void onTerminated(SessionStore::Session& session, const PendingEvent& event);
 
-    std::string generateIpv4Address();
-    std::string generateIpv6Address();
+    void setSessionState(SessionStore::Session& session, SessionState state);
+    void allocateUeAddresses(SessionStore::Session& session, const std::string& dnn);
+    void releaseUeAddresses(const SessionStore::Session& session);
+    void allocateUeAddresses(const std::string& poolDnn, const std::vector<SessionStore::Handle>& handles);
     void logSessionCreation(SessionId sessionId, UeId ueId);
     void logSessionActivation(SessionId sessionId);
     void logSessionTermination(SessionId sessionId);
@@ -0,0 +1,179 @@
+#include "SessionIdAllocator.hpp"
+
+// Process-wide record of which index blocks belong to some allocator
+struct BlockRegistry {
+    std::mutex mutex;
+    bool claimed[SessionIdAllocator::BLOCK_COUNT];
+};
+
+static BlockRegistry& blockRegistry() {
+    static BlockRegistry registry = {};
+    return registry;
+}
+
+SessionIdAllocator::Batch::Batch(SessionIdAllocator& allocator)
+    : allocator_(allocator), next_(0), count_(0) {}
+
+SessionId SessionIdAllocator::Batch::allocate() {
+    if (next_ == count_) {
+        next_ = 0;
+        count_ = allocator_.allocate(ids_, BATCH_SIZE);
+        if (count_ == 0) {
+            return 0;
+        }
+    }
+    return ids_[next_++];
+}
+
+void SessionIdAllocator::Batch::flush() {
+    allocator_.release(ids_ + next_, count_ - next_);
+    next_ = 0;
+    count_ = 0;
+}
+
+SessionIdAllocator::SessionIdAllocator()
+    : nextFresh_(0), freshEnd_(0), allocated_(0), rejectedReleases_(0) {}
+
+SessionIdAllocator::~SessionIdAllocator() {
+    for (uint32_t block : blocks_) {
+        returnBlock(block);
+    }
+}
+
+SessionId SessionIdAllocator::allocate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SessionId sessionId = 0;
+    allocateLocked(sessionId);
+    return sessionId;
+}
+
+bool SessionIdAllocator::release(SessionId sessionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return releaseLocked(sessionId);
+}
+
+uint32_t SessionIdAllocator::allocate(SessionId* sessionIds, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t allocated = 0;
+    while (allocated < count && allocateLocked(sessionIds[allocated])) {
+        allocated++;
+    }
+    return allocated;
+}
+
+uint32_t SessionIdAllocator::release(const SessionId* sessionIds, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t released = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        released += releaseLocked(sessionIds[i]) ? 1 : 0;
+    }
+    return released;
+}
+
+bool SessionIdAllocator::isCurrent(SessionId sessionId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint16_t* slot = slotLocked(indexOf(sessionId));
+    return slot && *slot == (LIVE | generationOf(sessionId));
+}
+
+bool SessionIdAllocator::isStale(SessionId sessionId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t index = indexOf(sessionId);
+    const uint16_t* slot = slotLocked(index);
+    if (!slot || index == 0 || index == INDEX_MASK) {
+        return false;
+    }
+    // Blocks are issued in order, so only the newest has unissued indices
+    bool issued = (index >> BLOCK_BITS) != blocks_.back() || index < nextFresh_;
+    return issued && *slot != (LIVE | generationOf(sessionId));
+}
+
+uint32_t SessionIdAllocator::getAllocatedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocated_;
+}
+
+uint32_t SessionIdAllocator::getBlockCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<uint32_t>(blocks_.size());
+}
+
+uint64_t SessionIdAllocator::getRejectedReleaseCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rejectedReleases_;
+}
+
+bool SessionIdAllocator::allocateLocked(SessionId& sessionId) {
+    uint32_t index = 0;
+    if (freeIndices_.size() >= REUSE_THRESHOLD ||
+        (nextFresh_ == freshEnd_ && !claimBlockLocked() && !freeIndices_.empty())) {
+        index = freeIndices_.front();
+        freeIndices_.pop_front();
+    } else if (nextFresh_ != freshEnd_) {
+        index = nextFresh_++;
+    } else {
+        return false;
+    }
+
+    uint16_t* slot = slotLocked(index);
+    *slot |= LIVE;
+    sessionId = static_cast<SessionId>(*slot & 0xFF) << INDEX_BITS | index;
+    allocated_++;
+    return true;
+}
+
+bool SessionIdAllocator::releaseLocked(SessionId sessionId) {
+    uint32_t index = indexOf(sessionId);
+    uint16_t* slot = slotLocked(index);
+    if (!slot || *slot != (LIVE | generationOf(sessionId))) {
+        rejectedReleases_++;
+        return false;
+    }
+
+    *slot = static_cast<uint16_t>((*slot + 1) & 0xFF);   // Next generation, not live
+    freeIndices_.push_back(index);
+    allocated_--;
+    return true;
+}
+
+bool SessionIdAllocator::claimBlockLocked() {
+    uint32_t block = 0;
+    if (!claimBlock(block)) {
+        return false;
+    }
+
+    slots_[block].reset(new uint16_t[BLOCK_SIZE]());
+    blocks_.push_back(block);
+    nextFresh_ = block << BLOCK_BITS;
+    freshEnd_ = nextFresh_ + BLOCK_SIZE;
+    if (nextFresh_ == 0) {
+        nextFresh_ = 1;        // ID 0 means "no session"
+    }
+    if (freshEnd_ == INDEX_MASK + 1) {
+        freshEnd_--;           // Generation 255 would make it 0xFFFFFFFF
+    }
+    return true;
+}
+
+uint16_t* SessionIdAllocator::slotLocked(uint32_t index) const {
+    uint16_t* block = slots_[index >> BLOCK_BITS].get();
+    return block ? &block[index & (BLOCK_SIZE - 1)] : nullptr;
+}
+
+bool SessionIdAllocator::claimBlock(uint32_t& block) {
+    BlockRegistry& registry = blockRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (block = 0; block < BLOCK_COUNT; ++block) {
+        if (!registry.claimed[block]) {
+            registry.claimed[block] = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SessionIdAllocator::returnBlock(uint32_t block) {
+    BlockRegistry& registry = blockRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.claimed[block] = false;
+}
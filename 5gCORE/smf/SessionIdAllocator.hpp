@@ -0,0 +1,97 @@
+#ifndef SESSION_ID_ALLOCATOR_HPP
+#define SESSION_ID_ALLOCATOR_HPP
+
+#include "../common/Types.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Session ID allocation shared by SMF instances and threads.
+//
+// A SessionId is an 8-bit generation over a 24-bit index. The index space
+// is cut into 256 blocks of 64K; each allocator claims blocks from a
+// process-wide registry as it needs them and hands them back on
+// destruction, so SMF instances never collide and never talk to each other
+// after the claim. Released indices are reused first-in first-out once
+// REUSE_THRESHOLD of them are waiting, with the generation bumped, so a
+// stale ID stays unequal to the session that took its place for at least
+// 255 further reuses. ID 0 is never issued.
+//
+// All allocator calls are thread-safe. A Batch is a per-thread cache that
+// refills BATCH_SIZE IDs under one lock acquisition.
+class SessionIdAllocator {
+public:
+    static constexpr uint32_t INDEX_BITS = 24;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t BLOCK_BITS = 16;
+    static constexpr uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+    static constexpr uint32_t BLOCK_COUNT = 1u << (INDEX_BITS - BLOCK_BITS);
+    static constexpr uint32_t REUSE_THRESHOLD = 4096;
+    static constexpr uint32_t BATCH_SIZE = 64;
+
+    class Batch {
+    public:
+        explicit Batch(SessionIdAllocator& allocator);
+        ~Batch() { flush(); }
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+        SessionId allocate();    // 0 when the ID space is exhausted
+        void flush();            // Hands unused IDs back
+
+    private:
+        SessionIdAllocator& allocator_;
+        SessionId ids_[BATCH_SIZE];
+        uint32_t next_;
+        uint32_t count_;
+    };
+
+    SessionIdAllocator();
+    ~SessionIdAllocator();
+    SessionIdAllocator(const SessionIdAllocator&) = delete;
+    SessionIdAllocator& operator=(const SessionIdAllocator&) = delete;
+
+    SessionId allocate();
+    bool release(SessionId sessionId);     // False for stale, foreign or free IDs
+
+    // Batch forms take the lock once and return how many were handled
+    uint32_t allocate(SessionId* sessionIds, uint32_t count);
+    uint32_t release(const SessionId* sessionIds, uint32_t count);
+
+    bool isCurrent(SessionId sessionId) const;   // Allocated here, latest generation
+    bool isStale(SessionId sessionId) const;     // Ours, but released or reissued
+
+    uint32_t getAllocatedCount() const;
+    uint32_t getBlockCount() const;
+    uint64_t getRejectedReleaseCount() const;
+
+    static uint32_t indexOf(SessionId sessionId) { return sessionId & INDEX_MASK; }
+    static uint8_t generationOf(SessionId sessionId) {
+        return static_cast<uint8_t>(sessionId >> INDEX_BITS);
+    }
+
+private:
+    // Per-index slot state: generation in the low byte, LIVE when issued
+    static constexpr uint16_t LIVE = 0x100;
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<uint16_t[]> slots_[BLOCK_COUNT];   // Null unless claimed
+    std::vector<uint32_t> blocks_;                     // Claimed, in order
+    std::deque<uint32_t> freeIndices_;
+    uint32_t nextFresh_;                               // In the newest block
+    uint32_t freshEnd_;
+    uint32_t allocated_;
+    uint64_t rejectedReleases_;
+
+    bool allocateLocked(SessionId& sessionId);
+    bool releaseLocked(SessionId sessionId);
+    bool claimBlockLocked();
+    uint16_t* slotLocked(uint32_t index) const;
+
+    static bool claimBlock(uint32_t& block);
+    static void returnBlock(uint32_t block);
+};
+
+#endif // SESSION_ID_ALLOCATOR_HPP
@@ -0,0 +1,107 @@
+#ifndef SESSION_STATE_MACHINE_HPP
+#define SESSION_STATE_MACHINE_HPP
+
+#include "../common/Types.hpp"
+#include <cstddef>
+#include <cstdint>
+
+enum class SessionEvent : uint8_t {
+    ESTABLISH,          // Session record created, resources being set up
+    PROVISION,          // User plane requested from the UPF (N4 establishment)
+    ACTIVATE,           // User plane set up, session usable
+    MODIFY,             // Change requested (DNN, QoS)
+    MODIFY_COMPLETE,    // User plane acknowledged the change
+    RELEASE,            // Release requested, user plane being torn down
+    TERMINATE           // Hard teardown, valid from any live state
+};
+
+enum class TransitionAction : uint8_t {
+    APPLY,              // Move to the next state and run its handler
+    DEFER,              // Queue until the session leaves a transient state
+    REJECT              // Not valid in this state
+};
+
+struct SessionTransition {
+    SessionState next;
+    TransitionAction action;
+};
+
+// PDU session transitions as a compile-time table indexed by
+// [state][event]. ACTIVATING, MODIFYING and DEACTIVATING are transient:
+// they wait for a completion event, and events that arrive meanwhile are
+// deferred rather than applied on top of a half-finished change. TERMINATE
+// is the exception and always applies. PROVISION keeps a session in
+// ACTIVATING while its user plane is requested; the answer brings ACTIVATE.
+class SessionStateMachine {
+public:
+    static constexpr size_t STATE_COUNT = 6;
+    static constexpr size_t EVENT_COUNT = 7;
+
+    static constexpr SessionTransition lookup(SessionState state, SessionEvent event) {
+        return TABLE[static_cast<size_t>(state)][static_cast<size_t>(event)];
+    }
+
+    static constexpr bool isTransient(SessionState state) {
+        return state == SessionState::ACTIVATING || state == SessionState::MODIFYING ||
+               state == SessionState::DEACTIVATING;
+    }
+
+    static const char* toString(SessionState state) {
+        static const char* const names[STATE_COUNT] = {
+            "IDLE", "ACTIVATING", "ACTIVE", "MODIFYING", "DEACTIVATING", "TERMINATED"
+        };
+        return names[static_cast<size_t>(state)];
+    }
+
+    static const char* toString(SessionEvent event) {
+        static const char* const names[EVENT_COUNT] = {
+            "ESTABLISH", "PROVISION", "ACTIVATE", "MODIFY", "MODIFY_COMPLETE", "RELEASE", "TERMINATE"
+        };
+        return names[static_cast<size_t>(event)];
+    }
+
+    // Stable states never defer, so replaying a queue always makes progress
+    static constexpr bool stableStatesNeverDefer() {
+        for (size_t state = 0; state < STATE_COUNT; ++state) {
+            for (size_t event = 0; event < EVENT_COUNT; ++event) {
+                if (TABLE[state][event].action == TransitionAction::DEFER &&
+                    !isTransient(static_cast<SessionState>(state))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    typedef SessionState S;
+    typedef TransitionAction A;
+
+    // Columns: ESTABLISH, PROVISION, ACTIVATE, MODIFY, MODIFY_COMPLETE, RELEASE, TERMINATE
+    static constexpr SessionTransition TABLE[STATE_COUNT][EVENT_COUNT] = {
+        // IDLE
+        {{S::ACTIVATING, A::APPLY}, {S::IDLE, A::REJECT}, {S::IDLE, A::REJECT}, {S::IDLE, A::REJECT},
+         {S::IDLE, A::REJECT}, {S::IDLE, A::REJECT}, {S::TERMINATED, A::APPLY}},
+        // ACTIVATING
+        {{S::ACTIVATING, A::REJECT}, {S::ACTIVATING, A::APPLY}, {S::ACTIVE, A::APPLY}, {S::ACTIVATING, A::DEFER},
+         {S::ACTIVATING, A::REJECT}, {S::ACTIVATING, A::DEFER}, {S::TERMINATED, A::APPLY}},
+        // ACTIVE
+        {{S::ACTIVE, A::REJECT}, {S::ACTIVE, A::REJECT}, {S::ACTIVE, A::REJECT}, {S::MODIFYING, A::APPLY},
+         {S::ACTIVE, A::REJECT}, {S::DEACTIVATING, A::APPLY}, {S::TERMINATED, A::APPLY}},
+        // MODIFYING
+        {{S::MODIFYING, A::REJECT}, {S::MODIFYING, A::REJECT}, {S::MODIFYING, A::REJECT}, {S::MODIFYING, A::DEFER},
+         {S::ACTIVE, A::APPLY}, {S::MODIFYING, A::DEFER}, {S::TERMINATED, A::APPLY}},
+        // DEACTIVATING
+        {{S::DEACTIVATING, A::REJECT}, {S::DEACTIVATING, A::REJECT}, {S::DEACTIVATING, A::REJECT},
+         {S::DEACTIVATING, A::REJECT}, {S::DEACTIVATING, A::REJECT}, {S::DEACTIVATING, A::REJECT},
+         {S::TERMINATED, A::APPLY}},
+        // TERMINATED
+        {{S::TERMINATED, A::REJECT}, {S::TERMINATED, A::REJECT}, {S::TERMINATED, A::REJECT},
+         {S::TERMINATED, A::REJECT}, {S::TERMINATED, A::REJECT}, {S::TERMINATED, A::REJECT},
+         {S::TERMINATED, A::REJECT}},
+    };
+};
+
+static_assert(SessionStateMachine::stableStatesNeverDefer(), "Only transient states may defer events");
+
+#endif // SESSION_STATE_MACHINE_HPP
@@ -0,0 +1,119 @@
+#include "SessionStore.hpp"
+
+SessionStore::SessionStore(size_t expectedSessions)
+    : index_(expectedSessions), ueIndex_(expectedSessions) {
+}
+
+SessionStore::Handle SessionStore::create(SessionId sessionId, UeId ueId) {
+    if (find(sessionId) != INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+
+    Handle handle = pool_.acquire();
+    if (!linkToUe(ueId, handle)) {
+        pool_.release(handle);
+        return INVALID_HANDLE;
+    }
+    index_.insert(sessionId, handle);
+
+    Session& session = pool_.at(handle);
+    session = Session();
+    session.sessionId = sessionId;
+    session.ueId = ueId;
+    session.state = SessionState::IDLE;
+    return handle;
+}
+
+SessionStore::Handle SessionStore::find(SessionId sessionId) const {
+    uint32_t handle = index_.find(sessionId);
+    return handle == DenseIndex::NOT_FOUND ? INVALID_HANDLE : handle;
+}
+
+bool SessionStore::erase(SessionId sessionId) {
+    Handle handle = find(sessionId);
+    if (handle == INVALID_HANDLE) {
+        return false;
+    }
+
+    index_.erase(sessionId);
+    unlinkFromUe(pool_.at(handle).ueId, handle);
+    pool_.at(handle).sessionId = 0;
+    pool_.release(handle);
+    return true;
+}
+
+void SessionStore::reserve(size_t sessions) {
+    pool_.reserve(sessions);
+    index_.reserve(sessions);
+}
+
+void SessionStore::clear() {
+    pool_.clear();
+    index_.clear();
+    uePool_.clear();
+    ueIndex_.clear();
+}
+
+const SessionStore::UeSessions* SessionStore::findUe(UeId ueId) const {
+    uint32_t ueHandle = ueIndex_.find(ueId);
+    return ueHandle == DenseIndex::NOT_FOUND ? nullptr : &uePool_.at(ueHandle);
+}
+
+uint32_t SessionStore::getUeSessionCount(UeId ueId) const {
+    const UeSessions* ue = findUe(ueId);
+    return ue ? ue->count : 0;
+}
+
+size_t SessionStore::getMemoryBytes() const {
+    return pool_.getMemoryBytes() + index_.capacity() * sizeof(uint64_t) +
+           uePool_.getMemoryBytes() + ueIndex_.capacity() * sizeof(uint64_t);
+}
+
+SessionStore::DnnId SessionStore::internDnn(const std::string& dnn) {
+    auto it = dnnIds_.find(dnn);
+    if (it != dnnIds_.end()) {
+        return it->second;
+    }
+
+    DnnId dnnId = static_cast<DnnId>(dnnNames_.size());
+    dnnNames_.push_back(dnn);
+    dnnIds_[dnn] = dnnId;
+    return dnnId;
+}
+
+bool SessionStore::linkToUe(UeId ueId, Handle handle) {
+    uint32_t ueHandle = ueIndex_.find(ueId);
+    if (ueHandle == DenseIndex::NOT_FOUND) {
+        ueHandle = uePool_.acquire();
+        uePool_.at(ueHandle).count = 0;
+        ueIndex_.insert(ueId, ueHandle);
+    }
+
+    UeSessions& ue = uePool_.at(ueHandle);
+    if (ue.count == MAX_PDU_SESSIONS_PER_UE) {
+        return false;
+    }
+    ue.handles[ue.count++] = handle;
+    return true;
+}
+
+void SessionStore::unlinkFromUe(UeId ueId, Handle handle) {
+    uint32_t ueHandle = ueIndex_.find(ueId);
+    if (ueHandle == DenseIndex::NOT_FOUND) {
+        return;
+    }
+
+    // At most 15 entries in one cache line; swap the last one into the gap
+    UeSessions& ue = uePool_.at(ueHandle);
+    for (uint32_t i = 0; i < ue.count; ++i) {
+        if (ue.handles[i] == handle) {
+            ue.handles[i] = ue.handles[--ue.count];
+            break;
+        }
+    }
+
+    if (ue.count == 0) {
+        ueIndex_.erase(ueId);
+        uePool_.release(ueHandle);
+    }
+}
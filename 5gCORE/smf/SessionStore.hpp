@@ -0,0 +1,94 @@
+#ifndef SESSION_STORE_HPP
+#define SESSION_STORE_HPP
+
+#include "../common/Types.hpp"
+#include "../common/DenseIndex.hpp"
+#include "../common/SlabPool.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compact PDU session storage for the SMF.
+//
+// Each session is one fixed-size record in a slab pool, addressed by a
+// handle; a DenseIndex maps SessionId to handle. State is stored inline,
+// addresses are binary and the DNN is an interned 16-bit ID, so the record
+// is 48 bytes; its 8-byte index entry, with the index's spare slots, brings a
+// session to about 64. Create, find and erase are O(1).
+//
+// Sessions are also grouped per UE: a UE owns one 64-byte record holding the
+// handles of its (at most 15) sessions, found through a second DenseIndex.
+// Per-UE queries and teardown touch that one record instead of scanning.
+// Not thread-safe; the SMF serializes access.
+class SessionStore {
+public:
+    typedef uint32_t Handle;
+    typedef uint16_t DnnId;
+    static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+    struct Session {
+        uint64_t ipv6Prefix;    // Upper 64 bits of the /64, 0 = none
+        uint64_t ulTraffic;
+        uint64_t dlTraffic;
+        SessionId sessionId;    // 0 marks a free record
+        UeId ueId;
+        Snssai snssai;
+        uint32_t ipv4;          // Host byte order, 0 = none
+        DnnId dnnId;
+        SessionState state;
+        uint8_t pendingEvents;  // Deferred events queued in the SMF
+        bool bulk;              // Created or released in bulk: logged in summary only
+    };
+
+    struct UeSessions {
+        uint32_t count;
+        Handle handles[MAX_PDU_SESSIONS_PER_UE];
+    };
+
+    explicit SessionStore(size_t expectedSessions = 1024);
+
+    // INVALID_HANDLE if the ID exists or the UE has no free session slot
+    Handle create(SessionId sessionId, UeId ueId);
+    Handle find(SessionId sessionId) const;
+    bool erase(SessionId sessionId);
+    void reserve(size_t sessions);
+    void clear();
+
+    Session& at(Handle handle) { return pool_.at(handle); }
+    const Session& at(Handle handle) const { return pool_.at(handle); }
+    size_t size() const { return index_.size(); }
+    size_t getUeCount() const { return ueIndex_.size(); }
+    const UeSessions* findUe(UeId ueId) const;
+    uint32_t getUeSessionCount(UeId ueId) const;
+    size_t getMemoryBytes() const;
+
+    // Visits live sessions in slot order
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (Handle handle = 0; handle < pool_.getHighWater(); ++handle) {
+            const Session& session = pool_.at(handle);
+            if (session.sessionId != 0) {
+                visit(session);
+            }
+        }
+    }
+
+    DnnId internDnn(const std::string& dnn);
+    const std::string& getDnnName(DnnId dnnId) const { return dnnNames_[dnnId]; }
+
+private:
+    bool linkToUe(UeId ueId, Handle handle);
+    void unlinkFromUe(UeId ueId, Handle handle);
+
+    SlabPool<Session> pool_;
+    DenseIndex index_;
+    SlabPool<UeSessions> uePool_;
+    DenseIndex ueIndex_;
+    std::vector<std::string> dnnNames_;
+    std::unordered_map<std::string, DnnId> dnnIds_;
+};
+
+static_assert(sizeof(SessionStore::Session) == 48, "Session record grew past 48 bytes");
+static_assert(sizeof(SessionStore::UeSessions) == 64, "Per-UE session set is one 64-byte record");
+
+#endif // SESSION_STORE_HPP
@@ -18,8 +18,10 @@ std::string UDM::generateAuthenticationChallenge(Imsi imsi) {
 
     authContexts_[imsi] = context;
 
-    logger_.info(name_, "Authentication challenge generated for IMSI: " + 
-                       std::to_string(imsi));
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Authentication challenge generated for IMSI: " + 
+                           std::to_string(imsi));
+    }
 
     return challenge;
 }
@@ -104,9 +106,33 @@ bool UDM::destroyAuthContext(Imsi imsi) {
 void UDM::handleMessage(std::shared_ptr<Message> message) {
     if (!message) return;
 
-    logger_.debug(name_, "Handling message: " + message->toString());
+    if (logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Handling message: " + message->toString());
+    }
 
     switch (message->getType()) {
+        case MessageType::AUTH_VECTOR_REQUEST: {
+            auto vectorMsg = std::dynamic_pointer_cast<AuthVectorRequestMessage>(message);
+            if (!vectorMsg) {
+                break;
+            }
+            // Subscription first; the vector goes out with the UDR's answer
+            if (!send(NFType::UDR, std::make_shared<SubscriptionDataRequestMessage>(
+                          vectorMsg->getSourceId(), vectorMsg->getImsi()))) {
+                logger_.warning(name_, "No UDR connected, rejecting IMSI: " + 
+                                      std::to_string(vectorMsg->getImsi()));
+                send(NFType::AMF, std::make_shared<AuthVectorResponseMessage>(
+                         vectorMsg->getSourceId(), vectorMsg->getImsi(), false, std::string()));
+            }
+            break;
+        }
+        case MessageType::SUBSCRIPTION_DATA_RESPONSE: {
+            auto dataMsg = std::dynamic_pointer_cast<SubscriptionDataResponseMessage>(message);
+            if (dataMsg) {
+                answerAuthVectorRequest(*dataMsg);
+            }
+            break;
+        }
         case MessageType::AUTHENTICATION_REQUEST: {
             auto authMsg = std::dynamic_pointer_cast<AuthenticationRequestMessage>(message);
             if (authMsg) {
@@ -127,6 +153,22 @@ void UDM::handleMessage(std::shared_ptr<Message> message) {
     }
 }
 
+void UDM::answerAuthVectorRequest(const SubscriptionDataResponseMessage& response) {
+    Imsi imsi = response.getImsi();
+    bool authorized = response.isFound() && !response.getData().accessRestrictionData;
+    std::string challenge;
+    if (authorized) {
+        challenge = generateAuthenticationChallenge(imsi);
+        subscriptionCache_[imsi] = response.getData();
+    } else if (logger_.isEnabled(LogLevel::WARNING)) {
+        logger_.warning(name_, "Auth vector refused (" + 
+                              std::string(response.isFound() ? "access restricted" : "no subscription") + 
+                              ") | IMSI=" + std::to_string(imsi));
+    }
+    send(NFType::AMF, std::make_shared<AuthVectorResponseMessage>(
+             response.getSourceId(), imsi, authorized, challenge));
+}
+
 void UDM::printAuthenticationStatus() const {
     std::cout << "\n================== UDM Authentication Status ==================\n";
     std::cout << "Active Auth Contexts: " << authContexts_.size() << "\n";
@@ -50,6 +50,7 @@ private:
     std::map<Imsi, std::string> publicKeyStore_;
 
     std::string generateChallenge(Imsi imsi);
+    void answerAuthVectorRequest(const SubscriptionDataResponseMessage& response);
     void logAuthenticationAttempt(Imsi imsi, bool success);
 };
 
@@ -86,9 +86,20 @@ std::string UDR::getAccessInfo(Imsi imsi) const {
 void UDR::handleMessage(std::shared_ptr<Message> message) {
     if (!message) return;
 
-    logger_.debug(name_, "Handling message: " + message->toString());
+    if (logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Handling message: " + message->toString());
+    }
 
     switch (message->getType()) {
+        case MessageType::SUBSCRIPTION_DATA_REQUEST: {
+            auto dataMsg = std::dynamic_pointer_cast<SubscriptionDataRequestMessage>(message);
+            if (dataMsg) {
+                send(NFType::UDM, std::make_shared<SubscriptionDataResponseMessage>(
+                         dataMsg->getSourceId(), dataMsg->getImsi(),
+                         getSubscriptionData(dataMsg->getImsi())));
+            }
+            break;
+        }
         case MessageType::REGISTRATION_REQUEST: {
             auto regMsg = std::dynamic_pointer_cast<RegistrationRequestMessage>(message);
             if (regMsg) {
@@ -131,11 +142,15 @@ std::string UDR::getUDRStatus() const {
 }
 
 void UDR::logDataStored(Imsi imsi) {
-    logger_.info(name_, "Subscription Data Stored | IMSI=" + std::to_string(imsi));
+    if (logger_.isEnabled(LogLevel::INFO)) {
+        logger_.info(name_, "Subscription Data Stored | IMSI=" + std::to_string(imsi));
+    }
 }
 
 void UDR::logDataRetrieved(Imsi imsi) {
-    logger_.debug(name_, "Subscription Data Retrieved | IMSI=" + std::to_string(imsi));
+    if (logger_.isEnabled(LogLevel::DEBUG)) {
+        logger_.debug(name_, "Subscription Data Retrieved | IMSI=" + std::to_string(imsi));
+    }
 }
 
 void UDR::start() {
@@ -4,7 +4,7 @@
 
 UserEquipment::UserEquipment(UeId ueId, Imsi imsi, Imei imei, const std::string& phoneNumber)
     : ueId_(ueId), imsi_(imsi), imei_(imei), phoneNumber_(phoneNumber),
-      state_(UeState::IDLE), connectedGnb_(0), currentSessionId_(0),
+      state_(UeState::IDLE), connectedGnb_(0), currentSessionId_(0), guti_(),
       totalUlData_(0), totalDlData_(0) {
     logger_.info("UE", "Creating UE: ID=" + std::to_string(ueId) + 
                        ", IMSI=" + std::to_string(imsi));
@@ -22,6 +22,8 @@ public:
     UeState getState() const { return state_; }
     GnbId getConnectedGnb() const { return connectedGnb_; }
     SessionId getCurrentSessionId() const { return currentSessionId_; }
+    const Guti& getGuti() const { return guti_; }   // Valid once registered
+    void setGuti(const Guti& guti) { guti_ = guti; }
 
     // State management
     void setState(UeState newState);
@@ -60,6 +62,7 @@ private:
     UeState state_;
     GnbId connectedGnb_;
     SessionId currentSessionId_;
+    Guti guti_;
 
     // Traffic statistics
     uint64_t totalUlData_;
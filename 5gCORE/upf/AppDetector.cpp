@@ -0,0 +1,267 @@
+#include "AppDetector.hpp"
+#include <cstring>
+#include <queue>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+AppDetector::AppDetector() : stateCount_(0) {
+    // Host names only use letters, digits, '-', '.' and '_'; everything
+    // else shares symbol 0. Upper case folds onto lower case.
+    std::memset(symbols_, 0, sizeof(symbols_));
+    for (int c = 'a'; c <= 'z'; ++c) {
+        symbols_[c] = static_cast<uint8_t>(1 + c - 'a');
+        symbols_[c - 'a' + 'A'] = symbols_[c];
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        symbols_[c] = static_cast<uint8_t>(27 + c - '0');
+    }
+    symbols_[static_cast<uint8_t>('-')] = 37;
+    symbols_[static_cast<uint8_t>('.')] = 38;
+    symbols_[static_cast<uint8_t>('_')] = 39;
+    clear();
+}
+
+void AppDetector::compile(const std::vector<ApplicationPattern>& patterns) {
+    clear();
+
+    // Trie of all patterns; 0 marks a missing edge until the DFA is completed
+    for (const auto& entry : patterns) {
+        if (entry.pattern.empty() || entry.pattern.size() > MAX_HOST_LENGTH) {
+            continue;
+        }
+
+        uint32_t state = 0;
+        for (char c : entry.pattern) {
+            size_t edge = state * ALPHABET + symbols_[static_cast<uint8_t>(c)];
+            if (transitions_[edge] == 0) {
+                transitions_[edge] = stateCount_++;
+                transitions_.resize(stateCount_ * ALPHABET, 0);
+                bestPattern_.push_back(NO_MATCH);
+            }
+            state = transitions_[edge];
+        }
+
+        if (bestPattern_[state] == NO_MATCH) {
+            bestPattern_[state] = static_cast<uint32_t>(patternApps_.size());
+            patternApps_.push_back(entry.appId);
+            patternLengths_.push_back(static_cast<uint16_t>(entry.pattern.size()));
+        }
+    }
+    shorterPattern_.assign(patternApps_.size(), NO_MATCH);
+
+    // Breadth-first pass: fill failure links and turn missing edges into the
+    // failure state's edge, giving a complete DFA
+    std::vector<uint32_t> failure(stateCount_, 0);
+    std::queue<uint32_t> pending;
+    for (uint32_t symbol = 0; symbol < ALPHABET; ++symbol) {
+        uint32_t next = transitions_[symbol];
+        if (next != 0) {
+            failure[next] = 0;
+            pending.push(next);
+        }
+    }
+
+    while (!pending.empty()) {
+        uint32_t state = pending.front();
+        pending.pop();
+
+        // A state's own pattern is always longer than anything on its failure
+        // chain, whose best pattern is then the next suffix to try
+        uint32_t inherited = bestPattern_[failure[state]];
+        if (bestPattern_[state] == NO_MATCH) {
+            bestPattern_[state] = inherited;
+        } else {
+            shorterPattern_[bestPattern_[state]] = inherited;
+        }
+
+        for (uint32_t symbol = 0; symbol < ALPHABET; ++symbol) {
+            uint32_t& next = transitions_[state * ALPHABET + symbol];
+            uint32_t fallback = transitions_[failure[state] * ALPHABET + symbol];
+            if (next != 0) {
+                failure[next] = fallback;
+                pending.push(next);
+            } else {
+                next = fallback;
+            }
+        }
+    }
+}
+
+void AppDetector::clear() {
+    stateCount_ = 1;
+    transitions_.assign(ALPHABET, 0);
+    bestPattern_.assign(1, NO_MATCH);
+    patternApps_.clear();
+    patternLengths_.clear();
+    shorterPattern_.clear();
+}
+
+AppId AppDetector::inspect(const uint8_t* payload, size_t length) const {
+    if (patternApps_.empty() || length == 0) {
+        return APP_UNKNOWN;
+    }
+
+    char host[MAX_HOST_LENGTH + 1];
+    size_t hostLength = 0;
+    if (!extractTlsSni(payload, length, host, hostLength) &&
+        !extractHttpHost(payload, length, host, hostLength)) {
+        return APP_UNKNOWN;
+    }
+
+    return matchHost(host, hostLength);
+}
+
+AppId AppDetector::matchHost(const char* host, size_t length) const {
+    const uint32_t* table = transitions_.data();
+    uint32_t state = 0;
+    for (size_t i = 0; i < length; ++i) {
+        state = table[state * ALPHABET + symbols_[static_cast<uint8_t>(host[i])]];
+    }
+
+    // The final state holds the patterns ending with the name, longest
+    // first; take the first that also starts at a label
+    for (uint32_t pattern = bestPattern_[state]; pattern != NO_MATCH; pattern = shorterPattern_[pattern]) {
+        size_t start = length - patternLengths_[pattern];
+        if (start == 0 || host[start - 1] == '.' || host[start] == '.') {
+            return patternApps_[pattern];
+        }
+    }
+    return APP_UNKNOWN;
+}
+
+bool AppDetector::extractTlsSni(const uint8_t* payload, size_t length, char* host, size_t& hostLength) {
+    // TLS record header (5) + handshake header (4) + version (2) + random (32)
+    if (length < 44 || payload[0] != 0x16 || payload[1] != 0x03 || payload[5] != 0x01) {
+        return false;
+    }
+
+    const uint8_t* p = payload + 43;
+    const uint8_t* end = payload + length;
+
+    auto read16 = [](const uint8_t* at) { return static_cast<size_t>(at[0] << 8 | at[1]); };
+
+    // Session ID, cipher suites and compression methods
+    size_t sessionIdLength = p[0];
+    p += 1 + sessionIdLength;
+    if (p + 2 > end) return false;
+    p += 2 + read16(p);
+    if (p + 1 > end) return false;
+    p += 1 + p[0];
+    if (p + 2 > end) return false;
+
+    const uint8_t* extensionsEnd = p + 2 + read16(p);
+    p += 2;
+    if (extensionsEnd > end) {
+        extensionsEnd = end;  // ClientHello continues in the next segment
+    }
+
+    while (p + 4 <= extensionsEnd) {
+        size_t type = read16(p);
+        size_t extensionLength = read16(p + 2);
+        p += 4;
+        if (p + extensionLength > extensionsEnd) {
+            return false;
+        }
+
+        // server_name: list length (2), name type (1), name length (2), name
+        if (type == 0x0000 && extensionLength >= 5 && p[2] == 0x00) {
+            size_t nameLength = read16(p + 3);
+            if (nameLength == 0 || nameLength > MAX_HOST_LENGTH || 5 + nameLength > extensionLength) {
+                return false;
+            }
+            copyLowercase(host, p + 5, nameLength);
+            hostLength = nameLength;
+            return true;
+        }
+        p += extensionLength;
+    }
+
+    return false;
+}
+
+bool AppDetector::extractHttpHost(const uint8_t* payload, size_t length, char* host, size_t& hostLength) {
+    // Request line starts with an upper-case method followed by a space
+    size_t method = 0;
+    while (method < length && method < 8 && payload[method] >= 'A' && payload[method] <= 'Z') {
+        method++;
+    }
+    if (method < 3 || method >= length || payload[method] != ' ') {
+        return false;
+    }
+
+    const uint8_t* end = payload + length;
+    const uint8_t* line = findByte(payload, end, '\n');
+
+    while (line != end) {
+        const uint8_t* p = line + 1;
+        if (end - p >= 5 && (p[0] | 0x20) == 'h' && (p[1] | 0x20) == 'o' &&
+            (p[2] | 0x20) == 's' && (p[3] | 0x20) == 't' && p[4] == ':') {
+            p += 5;
+            while (p < end && (*p == ' ' || *p == '\t')) {
+                p++;
+            }
+            const uint8_t* value = p;
+            while (p < end && *p != '\r' && *p != '\n' && *p != ':') {
+                p++;  // Port suffix is not part of the name
+            }
+
+            size_t nameLength = static_cast<size_t>(p - value);
+            if (nameLength == 0 || nameLength > MAX_HOST_LENGTH) {
+                return false;
+            }
+            copyLowercase(host, value, nameLength);
+            hostLength = nameLength;
+            return true;
+        }
+
+        // Blank line ends the header block
+        if (p < end && (*p == '\r' || *p == '\n')) {
+            return false;
+        }
+        line = findByte(p, end, '\n');
+    }
+
+    return false;
+}
+
+void AppDetector::copyLowercase(char* dst, const uint8_t* src, size_t length) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i upperA = _mm_set1_epi8('A' - 1);
+    const __m128i upperZ = _mm_set1_epi8('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(chunk, upperA), _mm_cmplt_epi8(chunk, upperZ));
+        chunk = _mm_or_si128(chunk, _mm_and_si128(isUpper, caseBit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), chunk);
+    }
+#endif
+    for (; i < length; ++i) {
+        uint8_t c = src[i];
+        dst[i] = static_cast<char>((c >= 'A' && c <= 'Z') ? c | 0x20 : c);
+    }
+    dst[length] = '\0';
+}
+
+const uint8_t* AppDetector::findByte(const uint8_t* begin, const uint8_t* end, uint8_t value) {
+    const uint8_t* p = begin;
+#ifdef __SSE2__
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    for (; p + 16 <= end; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == value) {
+            return p;
+        }
+    }
+    return end;
+}
@@ -0,0 +1,62 @@
+#ifndef APP_DETECTOR_HPP
+#define APP_DETECTOR_HPP
+
+#include "../common/Types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ApplicationPattern {
+    std::string pattern;   // Host name or domain suffix, e.g. "googlevideo.com"
+    AppId appId;
+};
+
+// Application detection from the server name a flow opens with.
+//
+// The name is taken from the SNI extension of a TLS ClientHello or from the
+// Host header of an HTTP request, and matched against all patterns at once
+// with an Aho-Corasick automaton. The automaton is compiled into a dense DFA
+// over the host-name alphabet (case folded), so matching is one table load
+// per character. A pattern matches the whole name or a suffix starting at a
+// label, so "youtube.com" matches "www.youtube.com" but not "notyoutube.com"
+// or "youtube.com.evil.net"; the longest match wins. Locating the Host header
+// and lowercasing the name use SSE2 when available.
+class AppDetector {
+public:
+    static constexpr size_t MAX_HOST_LENGTH = 255;
+
+    AppDetector();
+
+    void compile(const std::vector<ApplicationPattern>& patterns);
+    void clear();
+
+    // Returns APP_UNKNOWN when the payload carries no name or nothing matches
+    AppId inspect(const uint8_t* payload, size_t length) const;
+    AppId matchHost(const char* host, size_t length) const;
+
+    size_t getPatternCount() const { return patternApps_.size(); }
+    size_t getStateCount() const { return stateCount_; }
+    bool isEmpty() const { return patternApps_.empty(); }
+
+    // Payload parsers; copy the lowercased name into host
+    static bool extractTlsSni(const uint8_t* payload, size_t length, char* host, size_t& hostLength);
+    static bool extractHttpHost(const uint8_t* payload, size_t length, char* host, size_t& hostLength);
+
+private:
+    static constexpr uint32_t ALPHABET = 40;
+    static constexpr uint32_t NO_MATCH = 0xFFFFFFFF;
+
+    std::vector<uint32_t> transitions_;   // stateCount_ x ALPHABET
+    std::vector<uint32_t> bestPattern_;   // Longest pattern ending in each state
+    std::vector<uint32_t> shorterPattern_; // Next longest pattern that is a suffix of each one
+    std::vector<AppId> patternApps_;
+    std::vector<uint16_t> patternLengths_;
+    uint32_t stateCount_;
+    uint8_t symbols_[256];
+
+    static void copyLowercase(char* dst, const uint8_t* src, size_t length);
+    static const uint8_t* findByte(const uint8_t* begin, const uint8_t* end, uint8_t value);
+};
+
+#endif // APP_DETECTOR_HPP
@@ -0,0 +1,101 @@
+#include "FlowCache.hpp"
+#include <cstring>
+
+FlowCache::FlowCache(uint32_t capacity, uint32_t idleTimeoutSec)
+    : idleTimeoutSec_(idleTimeoutSec), hits_(0), misses_(0), evictions_(0) {
+    // Round the number of sets up to a power of two
+    uint32_t sets = 1;
+    while (sets * WAYS < capacity) {
+        sets <<= 1;
+    }
+    setMask_ = sets - 1;
+    entries_.resize(sets * WAYS);
+    clear();
+}
+
+FlowCache::Entry* FlowCache::lookup(const FiveTuple& tuple, uint32_t teid, uint8_t direction,
+                                    uint32_t generation, uint32_t now) {
+    Entry* set = &entries_[setIndex(tuple, teid, direction) * WAYS];
+
+    for (uint32_t way = 0; way < WAYS; ++way) {
+        Entry& entry = set[way];
+        if (!entry.valid || !sameFlow(entry, tuple, teid, direction)) {
+            continue;
+        }
+
+        if (entry.generation != generation || now - entry.lastSeen > idleTimeoutSec_) {
+            entry.valid = 0;  // Session changed or flow went idle
+            break;
+        }
+
+        entry.lastSeen = now;
+        hits_++;
+        return &entry;
+    }
+
+    misses_++;
+    return nullptr;
+}
+
+FlowCache::Entry* FlowCache::insert(const FiveTuple& tuple, uint32_t teid, uint8_t direction,
+                                    uint32_t generation, uint32_t now, const PacketDetectionRule& pdr) {
+    Entry* set = &entries_[setIndex(tuple, teid, direction) * WAYS];
+
+    // Prefer a free way, otherwise evict the least recently seen flow
+    Entry* victim = &set[0];
+    for (uint32_t way = 0; way < WAYS; ++way) {
+        if (!set[way].valid) {
+            victim = &set[way];
+            break;
+        }
+        if (now - set[way].lastSeen > now - victim->lastSeen) {
+            victim = &set[way];
+        }
+    }
+
+    if (victim->valid) {
+        evictions_++;
+    }
+
+    victim->srcIp = tuple.srcIp;
+    victim->dstIp = tuple.dstIp;
+    victim->srcPort = tuple.srcPort;
+    victim->dstPort = tuple.dstPort;
+    victim->protocol = tuple.protocol;
+    victim->direction = direction;
+    victim->qfi = pdr.qfi;
+    victim->valid = 1;
+    victim->teid = teid;
+    victim->generation = generation;
+    victim->lastSeen = now;
+    victim->pdrId = pdr.pdrId;
+    victim->farId = pdr.farId;
+    victim->appId = APP_UNKNOWN;
+    victim->dpiPackets = 0;
+    return victim;
+}
+
+void FlowCache::clear() {
+    std::memset(entries_.data(), 0, entries_.size() * sizeof(Entry));
+}
+
+double FlowCache::getHitRatio() const {
+    uint64_t total = hits_ + misses_;
+    return total == 0 ? 0.0 : static_cast<double>(hits_) / total;
+}
+
+uint32_t FlowCache::setIndex(const FiveTuple& tuple, uint32_t teid, uint8_t direction) const {
+    uint64_t h = (static_cast<uint64_t>(tuple.srcIp) << 32 | tuple.dstIp) * 0x9E3779B97F4A7C15ULL;
+    h ^= (static_cast<uint64_t>(tuple.srcPort) << 40 | static_cast<uint64_t>(tuple.dstPort) << 24 |
+          static_cast<uint64_t>(tuple.protocol) << 16 | direction) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= static_cast<uint64_t>(teid) * 0x165667B19E3779F9ULL;
+    h ^= h >> 31;
+    return static_cast<uint32_t>(h) & setMask_;
+}
+
+bool FlowCache::sameFlow(const Entry& entry, const FiveTuple& tuple, uint32_t teid, uint8_t direction) {
+    return entry.srcIp == tuple.srcIp && entry.dstIp == tuple.dstIp &&
+           entry.srcPort == tuple.srcPort && entry.dstPort == tuple.dstPort &&
+           entry.protocol == tuple.protocol && entry.teid == teid &&
+           entry.direction == direction;
+}
@@ -0,0 +1,68 @@
+#ifndef FLOW_CACHE_HPP
+#define FLOW_CACHE_HPP
+
+#include "../common/Types.hpp"
+#include <cstdint>
+#include <vector>
+
+// Exact-match flow cache placed in front of the PDR classifier.
+//
+// Keyed by 5-tuple, TEID and direction; stores the PDR, FAR and QFI the
+// classifier picked for the flow, and the flow's application detection state.
+// Sessions without a classifier still get uplink entries, for detection only.
+// The table is 4-way set associative with a fixed number of sets, so memory is
+// bounded and a full set evicts its least recently seen entry. Entries carry
+// the session's flow generation: any change to the session (QoS, PDRs, detach)
+// bumps the generation and old entries stop matching without a sweep. Entries
+// idle for longer than the timeout age out.
+// One instance belongs to one forwarding worker and is not thread-safe.
+class FlowCache {
+public:
+    static constexpr uint32_t WAYS = 4;
+
+    struct Entry {
+        uint32_t srcIp;
+        uint32_t dstIp;
+        uint16_t srcPort;
+        uint16_t dstPort;
+        uint8_t protocol;
+        uint8_t direction;   // 0 = uplink, 1 = downlink
+        uint8_t qfi;
+        uint8_t valid;
+        uint32_t teid;
+        uint32_t generation;
+        uint32_t lastSeen;   // Seconds on the caller's clock
+        uint32_t pdrId;
+        uint32_t farId;
+        AppId appId;         // Set once application detection succeeds
+        uint8_t dpiPackets;  // Packets inspected so far
+    };
+
+    FlowCache(uint32_t capacity, uint32_t idleTimeoutSec);
+
+    Entry* lookup(const FiveTuple& tuple, uint32_t teid, uint8_t direction,
+                  uint32_t generation, uint32_t now);
+    Entry* insert(const FiveTuple& tuple, uint32_t teid, uint8_t direction,
+                uint32_t generation, uint32_t now, const PacketDetectionRule& pdr);
+    void clear();
+
+    uint32_t getCapacity() const { return static_cast<uint32_t>(entries_.size()); }
+    uint64_t getHits() const { return hits_; }
+    uint64_t getMisses() const { return misses_; }
+    uint64_t getEvictions() const { return evictions_; }
+    double getHitRatio() const;
+
+private:
+    std::vector<Entry> entries_;
+    uint32_t setMask_;
+    uint32_t idleTimeoutSec_;
+
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t evictions_;
+
+    uint32_t setIndex(const FiveTuple& tuple, uint32_t teid, uint8_t direction) const;
+    static bool sameFlow(const Entry& entry, const FiveTuple& tuple, uint32_t teid, uint8_t direction);
+};
+
+#endif // FLOW_CACHE_HPP
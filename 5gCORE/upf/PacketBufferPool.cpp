@@ -0,0 +1,30 @@
+#include "PacketBufferPool.hpp"
+
+PacketBufferPool::PacketBufferPool(uint32_t capacity)
+    : buffers_(capacity), freeHead_(capacity > 0 ? 0 : INVALID_INDEX), freeCount_(capacity) {
+    for (uint32_t i = 0; i < capacity; ++i) {
+        buffers_[i].size = 0;
+        buffers_[i].qfi = 0;
+        buffers_[i].next = (i + 1 < capacity) ? i + 1 : INVALID_INDEX;
+    }
+}
+
+uint32_t PacketBufferPool::acquire() {
+    if (freeHead_ == INVALID_INDEX) {
+        return INVALID_INDEX;
+    }
+
+    uint32_t index = freeHead_;
+    freeHead_ = buffers_[index].next;
+    buffers_[index].next = INVALID_INDEX;
+    freeCount_--;
+    return index;
+}
+
+void PacketBufferPool::release(uint32_t index) {
+    buffers_[index].size = 0;
+    buffers_[index].qfi = 0;
+    buffers_[index].next = freeHead_;
+    freeHead_ = index;
+    freeCount_++;
+}
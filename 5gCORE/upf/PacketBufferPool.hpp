@@ -0,0 +1,38 @@
+#ifndef PACKET_BUFFER_POOL_HPP
+#define PACKET_BUFFER_POOL_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-size pool of downlink packet descriptors. Buffers are linked into
+// per-session FIFOs through their 'next' index, so buffering and releasing a
+// packet never touches the allocator.
+class PacketBufferPool {
+public:
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+    struct BufferedPacket {
+        uint32_t size;
+        uint32_t next;
+        uint8_t qfi;        // Flow the packet was classified to, for egress on release
+    };
+
+    explicit PacketBufferPool(uint32_t capacity);
+
+    uint32_t acquire();
+    void release(uint32_t index);
+
+    BufferedPacket& at(uint32_t index) { return buffers_[index]; }
+    const BufferedPacket& at(uint32_t index) const { return buffers_[index]; }
+
+    uint32_t getCapacity() const { return static_cast<uint32_t>(buffers_.size()); }
+    uint32_t getFreeCount() const { return freeCount_; }
+    uint32_t getUsedCount() const { return getCapacity() - freeCount_; }
+
+private:
+    std::vector<BufferedPacket> buffers_;
+    uint32_t freeHead_;
+    uint32_t freeCount_;
+};
+
+#endif // PACKET_BUFFER_POOL_HPP
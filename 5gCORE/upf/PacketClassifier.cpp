@@ -0,0 +1,226 @@
+#include "PacketClassifier.hpp"
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+void PacketClassifier::compile(const std::vector<PacketDetectionRule>& rules) {
+    clear();
+    rules_ = rules;
+
+    scanOrder_.resize(rules_.size());
+    for (uint32_t i = 0; i < rules_.size(); ++i) {
+        scanOrder_[i] = i;
+    }
+    std::stable_sort(scanOrder_.begin(), scanOrder_.end(), [this](uint32_t a, uint32_t b) {
+        return rules_[a].precedence < rules_[b].precedence;
+    });
+
+    if (rules_.size() <= LINEAR_SCAN_LIMIT) {
+        return;
+    }
+
+    std::map<std::tuple<uint8_t, uint8_t, bool, bool, bool>, size_t> tupleIndex;
+
+    // Insert in precedence order so every candidate chain stays sorted
+    for (uint32_t i : scanOrder_) {
+        const SdfFilter& filter = rules_[i].filter;
+        uint8_t srcLen = std::min<uint8_t>(filter.srcPrefixLen, 32);
+        uint8_t dstLen = std::min<uint8_t>(filter.dstPrefixLen, 32);
+        bool srcPortExact = filter.srcPortLow == filter.srcPortHigh;
+        bool dstPortExact = filter.dstPortLow == filter.dstPortHigh;
+        bool hasProtocol = filter.protocol != 0;
+
+        auto key = std::make_tuple(srcLen, dstLen, srcPortExact, dstPortExact, hasProtocol);
+        auto found = tupleIndex.find(key);
+        if (found == tupleIndex.end()) {
+            Tuple tuple;
+            tuple.srcMask = prefixMask(srcLen);
+            tuple.dstMask = prefixMask(dstLen);
+            tuple.srcPortMask = srcPortExact ? 0xFFFF : 0x0000;
+            tuple.dstPortMask = dstPortExact ? 0xFFFF : 0x0000;
+            tuple.protocolMask = hasProtocol ? 0xFF : 0x00;
+            tuple.bestPrecedence = rules_[i].precedence;
+            tuple.entryCount = 0;
+            tuple.entries.assign(16, Entry{0, 0, EMPTY_SLOT});
+            found = tupleIndex.emplace(key, tuples_.size()).first;
+            tuples_.push_back(std::move(tuple));
+        }
+
+        Tuple& tuple = tuples_[found->second];
+        uint64_t ipKey = (static_cast<uint64_t>(filter.srcIp & tuple.srcMask) << 32) |
+                         (filter.dstIp & tuple.dstMask);
+        uint64_t portKey = (static_cast<uint64_t>(filter.srcPortLow & tuple.srcPortMask) << 24) |
+                           (static_cast<uint64_t>(filter.dstPortLow & tuple.dstPortMask) << 8) |
+                           (filter.protocol & tuple.protocolMask);
+        addCandidate(tuple.findOrInsert(ipKey, portKey), i);
+    }
+
+    std::sort(tuples_.begin(), tuples_.end(), [](const Tuple& a, const Tuple& b) {
+        return a.bestPrecedence < b.bestPrecedence;
+    });
+}
+
+void PacketClassifier::clear() {
+    rules_.clear();
+    scanOrder_.clear();
+    tuples_.clear();
+    candidates_.clear();
+}
+
+const PacketDetectionRule* PacketClassifier::classify(const FiveTuple& tuple) const {
+    if (tuples_.empty()) {
+        for (uint32_t index : scanOrder_) {
+            if (matches(rules_[index].filter, tuple)) {
+                return &rules_[index];
+            }
+        }
+        return nullptr;
+    }
+
+    uint32_t bestIndex = EMPTY_SLOT;
+    uint32_t bestPrecedence = 0xFFFFFFFF;
+
+    for (const auto& space : tuples_) {
+        if (bestIndex != EMPTY_SLOT && space.bestPrecedence >= bestPrecedence) {
+            break;  // Remaining tuples cannot hold a better rule
+        }
+
+        uint64_t ipKey = (static_cast<uint64_t>(tuple.srcIp & space.srcMask) << 32) |
+                         (tuple.dstIp & space.dstMask);
+        uint64_t portKey = (static_cast<uint64_t>(tuple.srcPort & space.srcPortMask) << 24) |
+                           (static_cast<uint64_t>(tuple.dstPort & space.dstPortMask) << 8) |
+                           (tuple.protocol & space.protocolMask);
+
+        const Entry* entry = space.find(ipKey, portKey);
+        if (!entry) {
+            continue;
+        }
+
+        for (uint32_t c = entry->head; c != EMPTY_SLOT; c = candidates_[c].next) {
+            const PacketDetectionRule& rule = rules_[candidates_[c].ruleIndex];
+            if (rule.precedence >= bestPrecedence) {
+                break;  // Chain is sorted: nothing better follows
+            }
+            if (portsMatch(rule.filter, tuple)) {
+                bestIndex = candidates_[c].ruleIndex;
+                bestPrecedence = rule.precedence;
+                break;
+            }
+        }
+    }
+
+    return bestIndex == EMPTY_SLOT ? nullptr : &rules_[bestIndex];
+}
+
+const PacketDetectionRule* PacketClassifier::classifyLinear(const FiveTuple& tuple) const {
+    const PacketDetectionRule* best = nullptr;
+    for (const auto& rule : rules_) {
+        if ((!best || rule.precedence < best->precedence) && matches(rule.filter, tuple)) {
+            best = &rule;
+        }
+    }
+    return best;
+}
+
+size_t PacketClassifier::getEntryCount() const {
+    size_t count = 0;
+    for (const auto& tuple : tuples_) {
+        count += tuple.entryCount;
+    }
+    return count;
+}
+
+bool PacketClassifier::matches(const SdfFilter& filter, const FiveTuple& tuple) {
+    uint32_t srcMask = prefixMask(std::min<uint8_t>(filter.srcPrefixLen, 32));
+    uint32_t dstMask = prefixMask(std::min<uint8_t>(filter.dstPrefixLen, 32));
+    return (tuple.srcIp & srcMask) == (filter.srcIp & srcMask) &&
+           (tuple.dstIp & dstMask) == (filter.dstIp & dstMask) &&
+           portsMatch(filter, tuple) &&
+           (filter.protocol == 0 || filter.protocol == tuple.protocol);
+}
+
+void PacketClassifier::addCandidate(Entry& entry, uint32_t ruleIndex) {
+    Candidate candidate;
+    candidate.ruleIndex = ruleIndex;
+    candidate.next = EMPTY_SLOT;
+    uint32_t index = static_cast<uint32_t>(candidates_.size());
+    candidates_.push_back(candidate);
+
+    // Rules arrive in precedence order: append at the tail
+    if (entry.head == EMPTY_SLOT) {
+        entry.head = index;
+        return;
+    }
+    uint32_t tail = entry.head;
+    while (candidates_[tail].next != EMPTY_SLOT) {
+        tail = candidates_[tail].next;
+    }
+    candidates_[tail].next = index;
+}
+
+PacketClassifier::Entry& PacketClassifier::Tuple::findOrInsert(uint64_t ipKey, uint64_t portKey) {
+    if ((entryCount + 1) * 2 > entries.size()) {
+        grow();
+    }
+
+    size_t mask = entries.size() - 1;
+    size_t slot = hashKey(ipKey, portKey) & mask;
+    while (entries[slot].head != EMPTY_SLOT) {
+        if (entries[slot].ipKey == ipKey && entries[slot].portKey == portKey) {
+            return entries[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    entries[slot].ipKey = ipKey;
+    entries[slot].portKey = portKey;
+    entryCount++;
+    return entries[slot];
+}
+
+const PacketClassifier::Entry* PacketClassifier::Tuple::find(uint64_t ipKey, uint64_t portKey) const {
+    size_t mask = entries.size() - 1;
+    size_t slot = hashKey(ipKey, portKey) & mask;
+    while (entries[slot].head != EMPTY_SLOT) {
+        if (entries[slot].ipKey == ipKey && entries[slot].portKey == portKey) {
+            return &entries[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+void PacketClassifier::Tuple::grow() {
+    std::vector<Entry> old;
+    old.swap(entries);
+    entries.assign(old.size() * 2, Entry{0, 0, EMPTY_SLOT});
+
+    size_t mask = entries.size() - 1;
+    for (const auto& entry : old) {
+        if (entry.head == EMPTY_SLOT) {
+            continue;
+        }
+        size_t slot = hashKey(entry.ipKey, entry.portKey) & mask;
+        while (entries[slot].head != EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
+        }
+        entries[slot] = entry;
+    }
+}
+
+bool PacketClassifier::portsMatch(const SdfFilter& filter, const FiveTuple& tuple) {
+    return tuple.srcPort >= filter.srcPortLow && tuple.srcPort <= filter.srcPortHigh &&
+           tuple.dstPort >= filter.dstPortLow && tuple.dstPort <= filter.dstPortHigh;
+}
+
+uint32_t PacketClassifier::prefixMask(uint8_t prefixLen) {
+    return prefixLen == 0 ? 0 : (0xFFFFFFFFu << (32 - prefixLen));
+}
+
+uint64_t PacketClassifier::hashKey(uint64_t ipKey, uint64_t portKey) {
+    uint64_t h = ipKey * 0x9E3779B97F4A7C15ULL ^ (portKey + 0x632BE59BD9B4E019ULL);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
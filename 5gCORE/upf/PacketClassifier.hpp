@@ -0,0 +1,77 @@
+#ifndef PACKET_CLASSIFIER_HPP
+#define PACKET_CLASSIFIER_HPP
+
+#include "../common/Types.hpp"
+#include <cstdint>
+#include <vector>
+
+// Tuple-space search classifier for SDF filters.
+//
+// Rules are compiled into one exact-match hash table per "tuple" (the
+// combination of source/destination prefix lengths, exact-or-wildcard ports
+// and protocol wildcard). Port ranges hash as wildcards and are verified on
+// a short per-entry candidate chain kept in precedence order. Tuples are
+// probed in order of their best precedence, so a lookup stops as soon as no
+// remaining tuple can beat the match already found. Small rule sets skip the
+// tables and use a precedence-ordered scan.
+class PacketClassifier {
+public:
+    PacketClassifier() = default;
+
+    void compile(const std::vector<PacketDetectionRule>& rules);
+    void clear();
+
+    const PacketDetectionRule* classify(const FiveTuple& tuple) const;
+
+    // Reference implementation used to validate the compiled tables
+    const PacketDetectionRule* classifyLinear(const FiveTuple& tuple) const;
+
+    bool isEmpty() const { return rules_.empty(); }
+    size_t getRuleCount() const { return rules_.size(); }
+    size_t getTupleCount() const { return tuples_.size(); }
+    size_t getEntryCount() const;
+
+    static bool matches(const SdfFilter& filter, const FiveTuple& tuple);
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+    static constexpr size_t LINEAR_SCAN_LIMIT = 24;
+
+    struct Entry {
+        uint64_t ipKey;      // (src & mask) << 32 | (dst & mask)
+        uint64_t portKey;    // sport << 24 | dport << 8 | protocol
+        uint32_t head;       // First candidate, EMPTY_SLOT when unused
+    };
+
+    struct Candidate {
+        uint32_t ruleIndex;
+        uint32_t next;
+    };
+
+    struct Tuple {
+        uint32_t srcMask;
+        uint32_t dstMask;
+        uint16_t srcPortMask;
+        uint16_t dstPortMask;
+        uint8_t protocolMask;
+        uint32_t bestPrecedence;
+        uint32_t entryCount;
+        std::vector<Entry> entries;  // Open addressing, power-of-two size
+
+        Entry& findOrInsert(uint64_t ipKey, uint64_t portKey);
+        const Entry* find(uint64_t ipKey, uint64_t portKey) const;
+        void grow();
+    };
+
+    std::vector<PacketDetectionRule> rules_;
+    std::vector<uint32_t> scanOrder_;      // Rule indices by precedence
+    std::vector<Tuple> tuples_;
+    std::vector<Candidate> candidates_;
+
+    void addCandidate(Entry& entry, uint32_t ruleIndex);
+    static bool portsMatch(const SdfFilter& filter, const FiveTuple& tuple);
+    static uint32_t prefixMask(uint8_t prefixLen);
+    static uint64_t hashKey(uint64_t ipKey, uint64_t portKey);
+};
+
+#endif // PACKET_CLASSIFIER_HPP
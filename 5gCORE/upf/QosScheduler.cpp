@@ -0,0 +1,271 @@
+#include "QosScheduler.hpp"
+#include <algorithm>
+
+QosScheduler::QosScheduler(uint32_t capacity)
+    : pool_(capacity), freeHead_(NONE), queuedCount_(0), droppedCount_(0),
+      gbrBacklog_(0), activeHead_(NONE), activeTail_(NONE) {
+    for (uint32_t i = 0; i < MAX_QFI; ++i) {
+        Queue& queue = queues_[i];
+        queue.head = NONE;
+        queue.tail = NONE;
+        queue.count = 0;
+        queue.priorityLevel = 0;
+        queue.quantum = BASE_QUANTUM;
+        queue.deficit = 0;
+        queue.nextActive = NONE;
+        queue.rank = 0;
+        queue.isGbr = false;
+        queue.configured = false;
+        queue.active = false;
+        rankToQfi_[i] = 0;
+    }
+    clear();
+}
+
+void QosScheduler::configureFlow(uint8_t qfi, uint8_t fiveQi, uint32_t priorityLevel) {
+    if (qfi >= MAX_QFI) {
+        return;
+    }
+
+    Queue& queue = queues_[qfi];
+    bool isGbr = isGbrFiveQi(fiveQi);
+
+    // Reclassifying a backlogged queue: take it off the DRR ring first
+    if (queue.active && isGbr) {
+        removeActive(qfi);
+    }
+
+    queue.configured = true;
+    queue.isGbr = isGbr;
+    queue.fiveQi = fiveQi;
+    queue.priorityLevel = priorityLevel;
+    // Lower priority level means more important: grant a larger DRR quantum
+    uint32_t weight = 1 + (127 - std::min<uint32_t>(priorityLevel, 127)) / 16;
+    queue.quantum = BASE_QUANTUM * weight;
+
+    rebuildGbrRanks();
+
+    if (queue.count > 0) {
+        if (queue.isGbr) {
+            gbrBacklog_ |= 1ULL << queue.rank;
+        } else if (!queue.active) {
+            appendActive(qfi);
+        }
+    }
+}
+
+bool QosScheduler::enqueue(uint8_t qfi, SessionId sessionId, uint32_t size) {
+    if (qfi >= MAX_QFI || freeHead_ == NONE) {
+        droppedCount_++;
+        return false;
+    }
+
+    uint32_t index = freeHead_;
+    freeHead_ = pool_[index].next;
+
+    Descriptor& descriptor = pool_[index];
+    descriptor.sessionId = sessionId;
+    descriptor.size = size;
+    descriptor.next = NONE;
+
+    Queue& queue = queues_[qfi];
+    if (queue.tail == NONE) {
+        queue.head = index;
+    } else {
+        pool_[queue.tail].next = index;
+    }
+    queue.tail = index;
+    queue.count++;
+    queuedCount_++;
+
+    if (queue.isGbr) {
+        gbrBacklog_ |= 1ULL << queue.rank;
+    } else if (!queue.active) {
+        appendActive(qfi);
+    }
+
+    return true;
+}
+
+bool QosScheduler::dequeue(ScheduledPacket& packet) {
+    // Strict priority: the lowest set bit is the most important GBR queue
+    if (gbrBacklog_ != 0) {
+        uint8_t qfi = rankToQfi_[__builtin_ctzll(gbrBacklog_)];
+        Queue& queue = queues_[qfi];
+        popHead(queue, packet, qfi);
+        if (queue.count == 0) {
+            gbrBacklog_ &= ~(1ULL << queue.rank);
+        }
+        return true;
+    }
+
+    // Deficit round robin across backlogged non-GBR queues
+    while (activeHead_ != NONE) {
+        uint8_t qfi = static_cast<uint8_t>(activeHead_);
+        Queue& queue = queues_[qfi];
+        uint32_t size = pool_[queue.head].size;
+
+        if (queue.deficit >= size) {
+            queue.deficit -= size;
+            popHead(queue, packet, qfi);
+            if (queue.count == 0) {
+                activeHead_ = queue.nextActive;
+                if (activeHead_ == NONE) {
+                    activeTail_ = NONE;
+                }
+                queue.nextActive = NONE;
+                queue.active = false;
+                queue.deficit = 0;
+            }
+            return true;
+        }
+
+        // Turn over: grant the next quantum and move to the back of the ring
+        queue.deficit += queue.quantum;
+        if (queue.nextActive != NONE) {
+            activeHead_ = queue.nextActive;
+            queue.nextActive = NONE;
+            queues_[activeTail_].nextActive = qfi;
+            activeTail_ = qfi;
+        }
+    }
+
+    return false;
+}
+
+void QosScheduler::clear() {
+    for (uint32_t i = 0; i < pool_.size(); ++i) {
+        pool_[i].next = (i + 1 < pool_.size()) ? i + 1 : NONE;
+    }
+    freeHead_ = pool_.empty() ? NONE : 0;
+    queuedCount_ = 0;
+
+    for (uint32_t i = 0; i < MAX_QFI; ++i) {
+        queues_[i].head = NONE;
+        queues_[i].tail = NONE;
+        queues_[i].count = 0;
+        queues_[i].deficit = 0;
+        queues_[i].nextActive = NONE;
+        queues_[i].active = false;
+    }
+    gbrBacklog_ = 0;
+    activeHead_ = NONE;
+    activeTail_ = NONE;
+}
+
+bool QosScheduler::isGbrFiveQi(uint8_t fiveQi) {
+    switch (fiveQi) {
+        case 1: case 2: case 3: case 4:
+        case 65: case 66: case 67:
+        case 71: case 72: case 73: case 74: case 75: case 76:
+        case 82: case 83: case 84: case 85: case 86:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t QosScheduler::defaultPriorityLevel(uint8_t fiveQi) {
+    switch (fiveQi) {
+        case 1: return 20;
+        case 2: return 40;
+        case 3: return 30;
+        case 4: return 50;
+        case 5: return 10;
+        case 6: return 60;
+        case 7: return 70;
+        case 8: return 80;
+        case 9: return 90;
+        case 65: return 7;
+        case 66: return 20;
+        case 67: return 15;
+        case 69: return 5;
+        case 70: return 55;
+        case 79: return 65;
+        case 80: return 68;
+        default: return 90;
+    }
+}
+
+void QosScheduler::rebuildGbrRanks() {
+    uint8_t order[MAX_QFI];
+    uint32_t count = 0;
+    for (uint32_t qfi = 0; qfi < MAX_QFI; ++qfi) {
+        if (queues_[qfi].configured && queues_[qfi].isGbr) {
+            order[count++] = static_cast<uint8_t>(qfi);
+        }
+    }
+
+    std::sort(order, order + count, [this](uint8_t a, uint8_t b) {
+        if (queues_[a].priorityLevel != queues_[b].priorityLevel) {
+            return queues_[a].priorityLevel < queues_[b].priorityLevel;
+        }
+        return a < b;
+    });
+
+    gbrBacklog_ = 0;
+    for (uint32_t rank = 0; rank < count; ++rank) {
+        Queue& queue = queues_[order[rank]];
+        queue.rank = static_cast<uint8_t>(rank);
+        rankToQfi_[rank] = order[rank];
+        if (queue.count > 0) {
+            gbrBacklog_ |= 1ULL << rank;
+        }
+    }
+}
+
+void QosScheduler::popHead(Queue& queue, ScheduledPacket& packet, uint8_t qfi) {
+    uint32_t index = queue.head;
+    Descriptor& descriptor = pool_[index];
+
+    packet.sessionId = descriptor.sessionId;
+    packet.size = descriptor.size;
+    packet.qfi = qfi;
+
+    queue.head = descriptor.next;
+    if (queue.head == NONE) {
+        queue.tail = NONE;
+    }
+    queue.count--;
+    queuedCount_--;
+
+    descriptor.next = freeHead_;
+    freeHead_ = index;
+}
+
+void QosScheduler::appendActive(uint8_t qfi) {
+    Queue& queue = queues_[qfi];
+    queue.active = true;
+    queue.nextActive = NONE;
+    if (activeTail_ == NONE) {
+        activeHead_ = qfi;
+    } else {
+        queues_[activeTail_].nextActive = qfi;
+    }
+    activeTail_ = qfi;
+}
+
+void QosScheduler::removeActive(uint8_t qfi) {
+    uint32_t previous = NONE;
+    uint32_t current = activeHead_;
+    while (current != NONE && current != qfi) {
+        previous = current;
+        current = queues_[current].nextActive;
+    }
+    if (current == NONE) {
+        return;
+    }
+
+    Queue& queue = queues_[qfi];
+    if (previous == NONE) {
+        activeHead_ = queue.nextActive;
+    } else {
+        queues_[previous].nextActive = queue.nextActive;
+    }
+    if (activeTail_ == qfi) {
+        activeTail_ = previous;
+    }
+    queue.nextActive = NONE;
+    queue.active = false;
+    queue.deficit = 0;
+}
@@ -0,0 +1,88 @@
+#ifndef QOS_SCHEDULER_HPP
+#define QOS_SCHEDULER_HPP
+
+#include "../common/Types.hpp"
+#include <cstdint>
+#include <vector>
+
+// Downlink egress scheduler with one queue per QFI.
+//
+// GBR queues are served in strict priority order: each GBR queue owns a bit
+// in a rank-ordered bitmap, so picking the highest-priority backlogged queue
+// is a single count-trailing-zeros. Non-GBR queues share the remaining
+// capacity through deficit round robin, with a quantum derived from their
+// priority level. Packets live in a preallocated descriptor pool linked per
+// queue, so enqueue and dequeue are O(1) and never allocate.
+class QosScheduler {
+public:
+    static constexpr uint32_t MAX_QFI = 64;
+
+    struct ScheduledPacket {
+        SessionId sessionId;
+        uint32_t size;
+        uint8_t qfi;
+    };
+
+    explicit QosScheduler(uint32_t capacity);
+
+    void configureFlow(uint8_t qfi, uint8_t fiveQi, uint32_t priorityLevel);
+    bool isConfigured(uint8_t qfi) const { return qfi < MAX_QFI && queues_[qfi].configured; }
+    uint8_t getFiveQi(uint8_t qfi) const { return qfi < MAX_QFI ? queues_[qfi].fiveQi : 0; }
+    uint32_t getPriorityLevel(uint8_t qfi) const { return qfi < MAX_QFI ? queues_[qfi].priorityLevel : 0; }
+
+    bool enqueue(uint8_t qfi, SessionId sessionId, uint32_t size);
+    bool dequeue(ScheduledPacket& packet);
+    void clear();
+
+    uint32_t getQueuedCount() const { return queuedCount_; }
+    uint32_t getQueueLength(uint8_t qfi) const { return qfi < MAX_QFI ? queues_[qfi].count : 0; }
+    uint64_t getDroppedCount() const { return droppedCount_; }
+
+    // Standardized 5QI characteristics (TS 23.501 table 5.7.4-1)
+    static bool isGbrFiveQi(uint8_t fiveQi);
+    static uint32_t defaultPriorityLevel(uint8_t fiveQi);
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+    static constexpr uint32_t BASE_QUANTUM = 1500;
+
+    struct Descriptor {
+        SessionId sessionId;
+        uint32_t size;
+        uint32_t next;
+    };
+
+    struct Queue {
+        uint32_t head;
+        uint32_t tail;
+        uint32_t count;
+        uint32_t priorityLevel;
+        uint32_t quantum;
+        uint32_t deficit;
+        uint32_t nextActive;    // DRR ring link (non-GBR only)
+        uint8_t rank;           // Bit position in gbrBacklog_ (GBR only)
+        uint8_t fiveQi;
+        bool isGbr;
+        bool configured;
+        bool active;
+    };
+
+    std::vector<Descriptor> pool_;
+    uint32_t freeHead_;
+    uint32_t queuedCount_;
+    uint64_t droppedCount_;
+
+    Queue queues_[MAX_QFI];
+    uint8_t rankToQfi_[MAX_QFI];
+    uint64_t gbrBacklog_;       // Bit per GBR rank with packets queued
+
+    uint32_t activeHead_;       // DRR ring of backlogged non-GBR queues
+    uint32_t activeTail_;
+
+    void rebuildGbrRanks();
+    void popHead(Queue& queue, ScheduledPacket& packet, uint8_t qfi);
+    void appendActive(uint8_t qfi);
+    void removeActive(uint8_t qfi);
+};
+
+#endif // QOS_SCHEDULER_HPP
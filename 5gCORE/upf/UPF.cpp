@@ -2,8 +2,17 @@
 #include <iostream>
 #include <algorithm>
 
-UPF::UPF() : NetworkFunction(NFType::UPF, "UPF"),
-             totalUplinkTraffic_(0), totalDownlinkTraffic_(0) {
+UPF::UPF(uint32_t dlBufferPoolSize) : NetworkFunction(NFType::UPF, "UPF"),
+             totalUplinkTraffic_(0), totalDownlinkTraffic_(0),
+             bufferPool_(dlBufferPoolSize), droppedDownlinkPackets_(0),
+             unmatchedPackets_(0), teidCounter_(0),
+             flowCache_(FLOW_CACHE_CAPACITY, FLOW_CACHE_IDLE_TIMEOUT_SEC),
+             flowCacheEnabled_(true), flowGenerationCounter_(0),
+             flowClockPackets_(0), flowClockSec_(0),
+             qosScheduler_(EGRESS_QUEUE_CAPACITY), egressPackets_(0),
+             counterEpoch_(0), n4ReportSequence_(0), n4Operations_(0) {
+    std::fill(qfiSessions_, qfiSessions_ + QosScheduler::MAX_QFI, 0);
+    refreshFlowClock();
     logger_.info(name_, "UPF initialized");
 }
 
@@ -20,8 +29,29 @@ void UPF::attachPduSession(SessionId sessionId, UeId ueId) {
     metrics.downlinkBytes = 0;
     metrics.qosRate = 1000;  // Default 1 Mbps
     metrics.isAttached = true;
+    metrics.unreportedUlBytes = 0;
+    metrics.unreportedDlBytes = 0;
+    metrics.volumeThreshold = DEFAULT_URR_VOLUME_THRESHOLD;
+    metrics.timeThreshold = std::chrono::milliseconds(DEFAULT_URR_TIME_THRESHOLD_MS);
+    metrics.measurementStart = std::chrono::steady_clock::now();
+    metrics.urrGeneration = 0;
+    metrics.isBuffering = false;
+    metrics.ddnSent = false;
+    metrics.bufferHead = PacketBufferPool::INVALID_INDEX;
+    metrics.bufferTail = PacketBufferPool::INVALID_INDEX;
+    metrics.bufferedCount = 0;
+    metrics.teid = ++teidCounter_;
+    metrics.flowGeneration = ++flowGenerationCounter_;
+    metrics.egressScheduled = false;
+    metrics.defaultQfi = DEFAULT_QFI;
+    metrics.appUsagePending = false;
+    metrics.syncedUlBytes = 0;
+    metrics.syncedDlBytes = 0;
+    metrics.countersDirty = false;
 
-    attachedSessions_[sessionId] = metrics;
+    auto& stored = attachedSessions_[sessionId];
+    stored = metrics;
+    armUsageDeadline(stored);
 
     logger_.info(name_, "PDU Session attached | Session=" + std::to_string(sessionId) + 
                        " | UE=" + std::to_string(ueId));
@@ -34,7 +64,27 @@ void UPF::detachPduSession(SessionId sessionId) {
         return;
     }
 
+    flushDownlinkBuffer(it->second, false);
+    drainApplicationUsage(it->second, detachedAppUsage_);
+
+    // Traffic since the last epoch goes out with the next one
+    const SessionMetrics& metrics = it->second;
+    if (metrics.countersDirty) {
+        detachedDeltas_.push_back({sessionId, metrics.uplinkBytes - metrics.syncedUlBytes,
+                                   metrics.downlinkBytes - metrics.syncedDlBytes});
+    }
+
+    // Final report so usage since the last report is not lost
+    if (it->second.unreportedUlBytes > 0 || it->second.unreportedDlBytes > 0) {
+        emitUsageReport(it->second, UsageReportTrigger::TERMINATION,
+                        std::chrono::steady_clock::now());
+    }
+
+    if (it->second.egressScheduled) {
+        qfiSessions_[it->second.defaultQfi]--;
+    }
     attachedSessions_.erase(it);
+    compactUsageDeadlines();
     logger_.info(name_, "PDU Session detached | Session=" + std::to_string(sessionId));
 }
 
@@ -46,10 +96,7 @@ void UPF::forwardUplinkPacket(SessionId sessionId, uint32_t packetSize) {
         return;
     }
 
-    it->second.uplinkBytes += packetSize;
-    totalUplinkTraffic_ += packetSize;
-
-    logPacketForwarding(sessionId, true, packetSize);
+    forwardUplink(it->second, packetSize);
 }
 
 void UPF::forwardDownlinkPacket(SessionId sessionId, uint32_t packetSize) {
@@ -60,10 +107,138 @@ void UPF::forwardDownlinkPacket(SessionId sessionId, uint32_t packetSize) {
         return;
     }
 
-    it->second.downlinkBytes += packetSize;
-    totalDownlinkTraffic_ += packetSize;
+    forwardDownlink(it->second, packetSize, it->second.defaultQfi);
+}
+
+void UPF::forwardUplinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize) {
+    forwardUplinkPacket(sessionId, tuple, packetSize, nullptr, 0);
+}
+
+void UPF::forwardDownlinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize) {
+    forwardDownlinkPacket(sessionId, tuple, packetSize, nullptr, 0);
+}
+
+void UPF::forwardUplinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize,
+                              const uint8_t* payload, size_t payloadLength) {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end()) {
+        logger_.warning(name_, "Cannot forward: Session not found - " + 
+                               std::to_string(sessionId));
+        return;
+    }
+
+    FlowMatch match;
+    match.flow = nullptr;
+    if (it->second.classifier && !matchFlow(it->second, tuple, 0, match)) {
+        unmatchedPackets_++;
+        return;  // No PDR matched: drop
+    }
+    if (!appDetector_.isEmpty()) {
+        detectApplication(it->second, tuple, 0, match, payload, payloadLength, packetSize);
+    }
+    forwardUplink(it->second, packetSize);
+}
+
+void UPF::forwardDownlinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize,
+                                const uint8_t* payload, size_t payloadLength) {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end()) {
+        logger_.warning(name_, "Cannot forward: Session not found - " + 
+                               std::to_string(sessionId));
+        return;
+    }
+
+    FlowMatch match;
+    match.qfi = it->second.defaultQfi;
+    match.flow = nullptr;
+    if (it->second.classifier && !matchFlow(it->second, tuple, 1, match)) {
+        unmatchedPackets_++;
+        return;  // No PDR matched: drop
+    }
+    if (!appDetector_.isEmpty()) {
+        detectApplication(it->second, tuple, 1, match, payload, payloadLength, packetSize);
+    }
+    forwardDownlink(it->second, packetSize, match.qfi);
+}
+
+void UPF::installPacketDetectionRules(SessionId sessionId,
+                                      const std::vector<PacketDetectionRule>& rules) {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end()) {
+        logger_.warning(name_, "Cannot install PDRs: Session not found - " + 
+                               std::to_string(sessionId));
+        return;
+    }
+
+    if (rules.empty()) {
+        it->second.classifier.reset();
+        it->second.flowGeneration = ++flowGenerationCounter_;
+        return;
+    }
+
+    auto classifier = std::make_shared<PacketClassifier>();
+    classifier->compile(rules);
+    it->second.classifier = classifier;
+    it->second.flowGeneration = ++flowGenerationCounter_;
+
+    logger_.debug(name_, "PDRs installed | Session=" + std::to_string(sessionId) + 
+                        " | Rules=" + std::to_string(classifier->getRuleCount()) + 
+                        " | Tuples=" + std::to_string(classifier->getTupleCount()));
+}
+
+const PacketDetectionRule* UPF::classifyPacket(SessionId sessionId, const FiveTuple& tuple) const {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end() || !it->second.classifier) {
+        return nullptr;
+    }
+    return it->second.classifier->classify(tuple);
+}
+
+uint32_t UPF::getTeid(SessionId sessionId) const {
+    auto it = attachedSessions_.find(sessionId);
+    if (it != attachedSessions_.end()) {
+        return it->second.teid;
+    }
+    return 0;
+}
+
+void UPF::setDownlinkBuffering(SessionId sessionId, bool enabled) {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end()) {
+        logger_.warning(name_, "Cannot set buffering: Session not found - " + 
+                               std::to_string(sessionId));
+        return;
+    }
+
+    auto& metrics = it->second;
+    if (metrics.isBuffering == enabled) {
+        return;
+    }
+
+    metrics.isBuffering = enabled;
+    metrics.ddnSent = false;
+
+    if (enabled) {
+        logger_.info(name_, "DL buffering enabled | Session=" + std::to_string(sessionId));
+    } else {
+        uint32_t delivered = flushDownlinkBuffer(metrics, true);
+        logger_.info(name_, "DL buffering disabled | Session=" + std::to_string(sessionId) + 
+                           " | Delivered=" + std::to_string(delivered));
+    }
+}
 
-    logPacketForwarding(sessionId, false, packetSize);
+std::vector<std::shared_ptr<Message>> UPF::collectDownlinkDataNotifications() {
+    std::vector<std::shared_ptr<Message>> notifications;
+    notifications.swap(pendingNotifications_);
+    return notifications;
+}
+
+uint32_t UPF::getBufferedPacketCount(SessionId sessionId) const {
+    auto it = attachedSessions_.find(sessionId);
+    if (it != attachedSessions_.end()) {
+        return it->second.bufferedCount;
+    }
+    return 0;
 }
 
 void UPF::setQoS(SessionId sessionId, uint32_t bitrate) {
@@ -75,10 +250,186 @@ void UPF::setQoS(SessionId sessionId, uint32_t bitrate) {
     }
 
     it->second.qosRate = bitrate;
+    it->second.flowGeneration = ++flowGenerationCounter_;  // Cached flows re-resolve QoS
     logger_.debug(name_, "QoS configured | Session=" + std::to_string(sessionId) + 
                         " | Rate=" + std::to_string(bitrate) + "kbps");
 }
 
+void UPF::installApplicationPatterns(const std::vector<ApplicationPattern>& patterns) {
+    appDetector_.compile(patterns);
+    flowCache_.clear();  // Flows already classified are inspected again
+
+    logger_.info(name_, "Application patterns installed | Patterns=" + 
+                       std::to_string(appDetector_.getPatternCount()) + 
+                       " | States=" + std::to_string(appDetector_.getStateCount()));
+}
+
+std::vector<ApplicationUsage> UPF::collectApplicationUsage() {
+    std::vector<ApplicationUsage> usage;
+    usage.swap(detachedAppUsage_);
+
+    for (SessionId sessionId : appUsageSessions_) {
+        auto it = attachedSessions_.find(sessionId);
+        if (it != attachedSessions_.end()) {
+            drainApplicationUsage(it->second, usage);
+        }
+    }
+    appUsageSessions_.clear();
+
+    return usage;
+}
+
+bool UPF::configureQosFlow(SessionId sessionId, uint8_t qfi, uint8_t fiveQi, uint32_t priorityLevel) {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end()) {
+        logger_.warning(name_, "Cannot configure QoS flow: Session not found - " + 
+                               std::to_string(sessionId));
+        return false;
+    }
+    if (qfi >= QosScheduler::MAX_QFI) {
+        logger_.warning(name_, "Invalid QFI " + std::to_string(qfi) + 
+                               " for Session=" + std::to_string(sessionId));
+        return false;
+    }
+
+    SessionMetrics& metrics = it->second;
+    if (!acceptsQosFlow(&metrics, qfi, fiveQi, priorityLevel)) {
+        logger_.warning(name_, "QFI " + std::to_string(qfi) + " is in use with 5QI " + 
+                               std::to_string(qosScheduler_.getFiveQi(qfi)) + 
+                               ", refusing 5QI " + std::to_string(fiveQi) + 
+                               " for Session=" + std::to_string(sessionId));
+        return false;
+    }
+
+    if (metrics.egressScheduled) {
+        qfiSessions_[metrics.defaultQfi]--;
+    }
+    qfiSessions_[qfi]++;
+    metrics.egressScheduled = true;
+    metrics.defaultQfi = qfi;
+    qosScheduler_.configureFlow(qfi, fiveQi, priorityLevel);
+
+    logger_.debug(name_, "QoS flow configured | Session=" + std::to_string(sessionId) + 
+                        " | QFI=" + std::to_string(qfi) + 
+                        " | 5QI=" + std::to_string(fiveQi) + 
+                        " | Priority=" + std::to_string(priorityLevel) + 
+                        (QosScheduler::isGbrFiveQi(fiveQi) ? " | GBR" : " | Non-GBR"));
+    return true;
+}
+
+uint32_t UPF::runEgressScheduler(uint32_t budget, std::vector<QosScheduler::ScheduledPacket>* sent) {
+    uint32_t count = 0;
+    QosScheduler::ScheduledPacket packet;
+    while (count < budget && qosScheduler_.dequeue(packet)) {
+        if (sent) {
+            sent->push_back(packet);
+        }
+        count++;
+    }
+    egressPackets_ += count;
+    return count;
+}
+
+void UPF::setUsageReportingRule(SessionId sessionId, uint64_t volumeThreshold,
+                                std::chrono::milliseconds timeThreshold) {
+    auto it = attachedSessions_.find(sessionId);
+    if (it == attachedSessions_.end()) {
+        logger_.warning(name_, "Cannot set URR: Session not found - " + 
+                               std::to_string(sessionId));
+        return;
+    }
+
+    it->second.volumeThreshold = volumeThreshold;
+    it->second.timeThreshold = timeThreshold;
+    armUsageDeadline(it->second);
+
+    logger_.debug(name_, "URR configured | Session=" + std::to_string(sessionId) + 
+                        " | Volume=" + std::to_string(volumeThreshold) + "B" +
+                        " | Period=" + std::to_string(timeThreshold.count()) + "ms");
+}
+
+std::shared_ptr<UsageReportMessage> UPF::collectUsageReports() {
+    return collectUsageReports(std::chrono::steady_clock::now());
+}
+
+std::shared_ptr<UsageReportMessage> UPF::collectUsageReports(std::chrono::steady_clock::time_point now) {
+    // Close the measurement period of every session whose deadline passed
+    while (!usageDeadlines_.empty() && usageDeadlines_.front().deadline <= now) {
+        std::pop_heap(usageDeadlines_.begin(), usageDeadlines_.end(), std::greater<UsageDeadline>());
+        UsageDeadline expired = usageDeadlines_.back();
+        usageDeadlines_.pop_back();
+
+        auto it = attachedSessions_.find(expired.sessionId);
+        if (it == attachedSessions_.end() || it->second.urrGeneration != expired.generation) {
+            continue;  // Detached, re-armed or already reported on volume
+        }
+
+        if (it->second.unreportedUlBytes > 0 || it->second.unreportedDlBytes > 0) {
+            emitUsageReport(it->second, UsageReportTrigger::TIME_THRESHOLD, now);
+        } else {
+            it->second.measurementStart = now;
+            armUsageDeadline(it->second);
+        }
+    }
+
+    if (pendingReports_.empty()) {
+        return nullptr;
+    }
+
+    auto message = std::make_shared<UsageReportMessage>(std::move(pendingReports_));
+    pendingReports_.clear();
+
+    logger_.debug(name_, "Usage report batch | Sessions=" + 
+                        std::to_string(message->getReports().size()));
+
+    return message;
+}
+
+uint32_t UPF::collectCounterDeltas(std::vector<CounterDelta>& deltas) {
+    deltas.reserve(deltas.size() + detachedDeltas_.size() + dirtySessions_.size());
+    deltas.insert(deltas.end(), detachedDeltas_.begin(), detachedDeltas_.end());
+    detachedDeltas_.clear();
+
+    for (SessionId sessionId : dirtySessions_) {
+        // Detached ones had their delta captured above. An ID detached and
+        // attached again can be listed twice; the first entry clears the flag
+        auto it = attachedSessions_.find(sessionId);
+        if (it == attachedSessions_.end() || !it->second.countersDirty) {
+            continue;
+        }
+
+        SessionMetrics& metrics = it->second;
+        deltas.push_back({sessionId, metrics.uplinkBytes - metrics.syncedUlBytes,
+                          metrics.downlinkBytes - metrics.syncedDlBytes});
+        metrics.syncedUlBytes = metrics.uplinkBytes;
+        metrics.syncedDlBytes = metrics.downlinkBytes;
+        metrics.countersDirty = false;
+    }
+    dirtySessions_.clear();
+
+    return ++counterEpoch_;
+}
+
+size_t UPF::publishCounterDeltas() {
+    std::vector<CounterDelta> deltas;
+    uint32_t epoch = collectCounterDeltas(deltas);
+    if (!n4Sender_ || deltas.empty()) {
+        return deltas.size();
+    }
+
+    std::vector<uint8_t> message;
+    for (size_t offset = 0; offset < deltas.size(); offset += N4Codec::MAX_BUNDLE) {
+        size_t count = std::min(deltas.size() - offset, N4Codec::MAX_BUNDLE);
+        message.clear();
+        N4Codec::encodeCounterDeltas(epoch, deltas.data() + offset, count, message);
+        n4Sender_(message.data(), message.size());
+    }
+
+    logger_.debug(name_, "Counter deltas published | Epoch=" + std::to_string(epoch) + 
+                        " | Sessions=" + std::to_string(deltas.size()));
+    return deltas.size();
+}
+
 uint32_t UPF::getQoS(SessionId sessionId) const {
     auto it = attachedSessions_.find(sessionId);
     if (it != attachedSessions_.end()) {
@@ -122,6 +473,130 @@ void UPF::handleMessage(std::shared_ptr<Message> message) {
     }
 }
 
+void UPF::handleN4Message(const uint8_t* data, size_t length) {
+    N4Header header;
+    std::vector<N4SessionOperation> operations;
+    if (!N4Codec::decodeHeader(data, length, header) || header.type != N4MessageType::SESSION_REQUEST ||
+        !N4Codec::decodeSessionRequest(data, length, operations)) {
+        logger_.warning(name_, "Malformed N4 message dropped | Length=" + std::to_string(length));
+        return;
+    }
+
+    std::vector<N4SessionResult> results;
+    results.reserve(operations.size());
+    for (const auto& operation : operations) {
+        results.push_back(applyN4Operation(operation));
+    }
+    n4Operations_ += operations.size();
+
+    logger_.debug(name_, "N4 request applied | Seq=" + std::to_string(header.sequence) + 
+                        " | Operations=" + std::to_string(operations.size()));
+
+    if (n4Sender_) {
+        std::vector<uint8_t> response;
+        response.reserve(N4Codec::HEADER_SIZE + results.size() * 10);
+        N4Codec::encodeSessionResponse(header.sequence, results.data(), results.size(), response);
+        n4Sender_(response.data(), response.size());
+    }
+}
+
+void UPF::sendUsageReports(const std::vector<UsageReport>& reports) {
+    if (!n4Sender_ || reports.empty()) {
+        return;
+    }
+
+    std::vector<uint8_t> message;
+    for (size_t offset = 0; offset < reports.size(); offset += N4Codec::MAX_BUNDLE) {
+        size_t count = std::min(reports.size() - offset, N4Codec::MAX_BUNDLE);
+        message.clear();
+        N4Codec::encodeUsageReport(++n4ReportSequence_, reports.data() + offset, count, message);
+        n4Sender_(message.data(), message.size());
+    }
+}
+
+bool UPF::acceptsQosFlow(const SessionMetrics* metrics, uint8_t qfi, uint8_t fiveQi,
+                         uint32_t priorityLevel) const {
+    if (qfi >= QosScheduler::MAX_QFI) {
+        return false;
+    }
+    uint32_t others = qfiSessions_[qfi];
+    if (metrics && metrics->egressScheduled && metrics->defaultQfi == qfi) {
+        others--;
+    }
+    return others == 0 || (qosScheduler_.getFiveQi(qfi) == fiveQi &&
+                           qosScheduler_.getPriorityLevel(qfi) == priorityLevel);
+}
+
+N4SessionResult UPF::applyN4Operation(const N4SessionOperation& operation) {
+    N4SessionResult result;
+    result.sessionId = operation.sessionId;
+    result.operation = operation.operation;
+    result.cause = N4Cause::ACCEPTED;
+    result.teid = 0;
+
+    auto it = attachedSessions_.find(operation.sessionId);
+    bool attached = it != attachedSessions_.end();
+
+    // Rules are checked before anything changes, so a refused operation
+    // leaves no half-provisioned session behind
+    bool provisions = operation.operation == N4Operation::ESTABLISH ? !attached :
+                      operation.operation == N4Operation::MODIFY && attached;
+    if (provisions && operation.fields & N4_FIELD_QOS_FLOW &&
+        !acceptsQosFlow(attached ? &it->second : nullptr, operation.rules.qfi,
+                        operation.rules.fiveQi, operation.rules.priorityLevel)) {
+        result.cause = N4Cause::INVALID_RULE;
+        return result;
+    }
+
+    switch (operation.operation) {
+        case N4Operation::ESTABLISH:
+            if (attached) {
+                result.cause = N4Cause::SESSION_EXISTS;
+                return result;
+            }
+            attachPduSession(operation.sessionId, operation.ueId);
+            break;
+        case N4Operation::MODIFY:
+            if (!attached) {
+                result.cause = N4Cause::SESSION_NOT_FOUND;
+                return result;
+            }
+            break;
+        case N4Operation::DELETE:
+            if (!attached) {
+                result.cause = N4Cause::SESSION_NOT_FOUND;
+                return result;
+            }
+            detachPduSession(operation.sessionId);
+            return result;
+        default:
+            result.cause = N4Cause::INVALID_RULE;
+            return result;
+    }
+
+    // Establishment and modification share the optional rule fields
+    if (operation.fields & N4_FIELD_QOS_FLOW) {
+        configureQosFlow(operation.sessionId, operation.rules.qfi, operation.rules.fiveQi,
+                         operation.rules.priorityLevel);
+    }
+    if (operation.fields & N4_FIELD_QOS) {
+        setQoS(operation.sessionId, operation.rules.qosRateKbps);
+    }
+    if (operation.fields & N4_FIELD_URR) {
+        setUsageReportingRule(operation.sessionId, operation.rules.urrVolumeThreshold,
+                              std::chrono::milliseconds(operation.rules.urrTimeThresholdMs));
+    }
+    if (operation.fields & N4_FIELD_PDRS) {
+        installPacketDetectionRules(operation.sessionId, operation.pdrs);
+    }
+    if (operation.fields & N4_FIELD_BUFFERING) {
+        setDownlinkBuffering(operation.sessionId, operation.buffering);
+    }
+
+    result.teid = getTeid(operation.sessionId);
+    return result;
+}
+
 void UPF::printSessionMetrics() const {
     std::cout << "\n================== UPF Session Metrics ==================\n";
     std::cout << "Attached Sessions: " << attachedSessions_.size() << "\n";
@@ -145,16 +620,294 @@ std::string UPF::getUPFStatus() const {
     oss << "UPF Status:\n"
         << "  Attached Sessions: " << attachedSessions_.size() << "\n"
         << "  Total UL Traffic: " << totalUplinkTraffic_ << " bytes\n"
-        << "  Total DL Traffic: " << totalDownlinkTraffic_ << " bytes\n";
+        << "  Total DL Traffic: " << totalDownlinkTraffic_ << " bytes\n"
+        << "  Buffered DL Packets: " << bufferPool_.getUsedCount() << "\n"
+        << "  Flow Cache Hit Ratio: " << flowCache_.getHitRatio() << "\n"
+        << "  Egress Queued/Sent: " << qosScheduler_.getQueuedCount() << "/" << egressPackets_ << "\n";
     return oss.str();
 }
 
 void UPF::logPacketForwarding(SessionId sessionId, bool isUplink, uint32_t size) {
+    if (!logger_.isEnabled(LogLevel::DEBUG)) {
+        return;  // Skip building the message on the per-packet path
+    }
     std::string direction = isUplink ? "UL" : "DL";
     logger_.debug(name_, "Packet Forward | " + direction + " | Session=" + 
                         std::to_string(sessionId) + " | Size=" + std::to_string(size) + "B");
 }
 
+void UPF::forwardUplink(SessionMetrics& metrics, uint32_t packetSize) {
+    metrics.uplinkBytes += packetSize;
+    totalUplinkTraffic_ += packetSize;
+    accountUsage(metrics, packetSize, 0);
+
+    logPacketForwarding(metrics.sessionId, true, packetSize);
+}
+
+void UPF::forwardDownlink(SessionMetrics& metrics, uint32_t packetSize, uint8_t qfi) {
+    if (metrics.isBuffering) {
+        bufferDownlinkPacket(metrics, packetSize, qfi);
+        return;
+    }
+
+    // Usage is charged on admission; the scheduler only decides egress order
+    if (metrics.egressScheduled && !qosScheduler_.enqueue(qfi, metrics.sessionId, packetSize)) {
+        droppedDownlinkPackets_++;
+        return;
+    }
+
+    metrics.downlinkBytes += packetSize;
+    totalDownlinkTraffic_ += packetSize;
+    accountUsage(metrics, 0, packetSize);
+
+    logPacketForwarding(metrics.sessionId, false, packetSize);
+}
+
+bool UPF::matchFlow(SessionMetrics& metrics, const FiveTuple& tuple, uint8_t direction,
+                    FlowMatch& match) {
+    if ((++flowClockPackets_ & 0x3FF) == 0) {
+        refreshFlowClock();
+    }
+
+    if (flowCacheEnabled_) {
+        FlowCache::Entry* cached = flowCache_.lookup(tuple, metrics.teid, direction,
+                                                     metrics.flowGeneration, flowClockSec_);
+        if (cached) {
+            match.pdrId = cached->pdrId;
+            match.farId = cached->farId;
+            match.qfi = cached->qfi;
+            match.flow = cached;
+            return true;
+        }
+    }
+
+    const PacketDetectionRule* pdr = metrics.classifier->classify(tuple);
+    if (!pdr) {
+        return false;
+    }
+
+    if (flowCacheEnabled_) {
+        match.flow = flowCache_.insert(tuple, metrics.teid, direction, metrics.flowGeneration,
+                                       flowClockSec_, *pdr);
+    }
+
+    match.pdrId = pdr->pdrId;
+    match.farId = pdr->farId;
+    match.qfi = pdr->qfi;
+    return true;
+}
+
+// Detection state lives on the flow's uplink cache entry: the ClientHello or
+// request that names the application travels uplink, and the downlink of
+// the same connection is charged to whatever its uplink was found to be.
+void UPF::detectApplication(SessionMetrics& metrics, const FiveTuple& tuple, uint8_t direction,
+                            const FlowMatch& match, const uint8_t* payload, size_t payloadLength,
+                            uint32_t packetSize) {
+    AppId appId = APP_UNKNOWN;
+    if (!flowCacheEnabled_) {
+        // No per-flow state to remember the result: inspect what we are given
+        appId = payload ? appDetector_.inspect(payload, payloadLength) : APP_UNKNOWN;
+    } else {
+        // Without a classifier on the session matchFlow did not run
+        if (!match.flow && (++flowClockPackets_ & 0x3FF) == 0) {
+            refreshFlowClock();
+        }
+
+        if (direction == 0) {
+            FlowCache::Entry* flow = match.flow;
+            if (!flow) {
+                flow = flowCache_.lookup(tuple, metrics.teid, 0, metrics.flowGeneration, flowClockSec_);
+            }
+            if (!flow) {
+                // The entry only carries detection state
+                PacketDetectionRule unclassified{};
+                unclassified.qfi = metrics.defaultQfi;
+                flow = flowCache_.insert(tuple, metrics.teid, 0, metrics.flowGeneration,
+                                         flowClockSec_, unclassified);
+            }
+            // Only the first packets of a flow carry the ClientHello / request
+            if (flow->appId == APP_UNKNOWN && payload && flow->dpiPackets < APP_DETECTION_MAX_PACKETS) {
+                flow->dpiPackets++;
+                flow->appId = appDetector_.inspect(payload, payloadLength);
+            }
+            appId = flow->appId;
+        } else {
+            FiveTuple uplink{tuple.dstIp, tuple.srcIp, tuple.dstPort, tuple.srcPort, tuple.protocol};
+            const FlowCache::Entry* flow = flowCache_.lookup(uplink, metrics.teid, 0,
+                                                             metrics.flowGeneration, flowClockSec_);
+            if (flow) {
+                appId = flow->appId;
+            }
+        }
+    }
+
+    if (appId == APP_UNKNOWN) {
+        return;
+    }
+
+    metrics.appUsage[appId] += packetSize;
+
+    if (!metrics.appUsagePending) {
+        metrics.appUsagePending = true;
+        appUsageSessions_.push_back(metrics.sessionId);
+    }
+}
+
+void UPF::drainApplicationUsage(SessionMetrics& metrics, std::vector<ApplicationUsage>& out) {
+    for (auto& entry : metrics.appUsage) {
+        if (entry.second == 0) {
+            continue;  // Keep the slot: the flow is likely still active
+        }
+        ApplicationUsage usage;
+        usage.sessionId = metrics.sessionId;
+        usage.ueId = metrics.ueId;
+        usage.appId = entry.first;
+        usage.bytes = entry.second;
+        out.push_back(usage);
+        entry.second = 0;
+    }
+    metrics.appUsagePending = false;
+}
+
+void UPF::refreshFlowClock() {
+    flowClockSec_ = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void UPF::accountUsage(SessionMetrics& metrics, uint32_t ulBytes, uint32_t dlBytes) {
+    metrics.unreportedUlBytes += ulBytes;
+    metrics.unreportedDlBytes += dlBytes;
+
+    if (!metrics.countersDirty) {
+        metrics.countersDirty = true;
+        dirtySessions_.push_back(metrics.sessionId);
+    }
+
+    if (metrics.volumeThreshold > 0 &&
+        metrics.unreportedUlBytes + metrics.unreportedDlBytes >= metrics.volumeThreshold) {
+        emitUsageReport(metrics, UsageReportTrigger::VOLUME_THRESHOLD,
+                        std::chrono::steady_clock::now());
+    }
+}
+
+void UPF::emitUsageReport(SessionMetrics& metrics, UsageReportTrigger trigger,
+                          std::chrono::steady_clock::time_point now) {
+    UsageReport report;
+    report.sessionId = metrics.sessionId;
+    report.ueId = metrics.ueId;
+    report.trigger = trigger;
+    report.ulBytes = metrics.unreportedUlBytes;
+    report.dlBytes = metrics.unreportedDlBytes;
+    report.durationMs = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - metrics.measurementStart).count());
+
+    pendingReports_.push_back(report);
+
+    metrics.unreportedUlBytes = 0;
+    metrics.unreportedDlBytes = 0;
+    metrics.measurementStart = now;
+
+    if (trigger != UsageReportTrigger::TERMINATION) {
+        armUsageDeadline(metrics);
+    }
+}
+
+void UPF::armUsageDeadline(SessionMetrics& metrics) {
+    // Bumping the generation lazily invalidates any deadline already queued
+    metrics.urrGeneration++;
+    if (metrics.timeThreshold.count() <= 0) {
+        return;
+    }
+
+    UsageDeadline entry;
+    entry.deadline = metrics.measurementStart + metrics.timeThreshold;
+    entry.sessionId = metrics.sessionId;
+    entry.generation = metrics.urrGeneration;
+    usageDeadlines_.push_back(entry);
+    std::push_heap(usageDeadlines_.begin(), usageDeadlines_.end(), std::greater<UsageDeadline>());
+    compactUsageDeadlines();
+}
+
+void UPF::compactUsageDeadlines() {
+    // Each session has at most one live entry, so past twice that the
+    // heap is mostly stale; rebuilding then keeps the cost amortized O(1)
+    if (usageDeadlines_.size() <= 2 * attachedSessions_.size() + 64) {
+        return;
+    }
+    auto stale = [this](const UsageDeadline& entry) {
+        auto it = attachedSessions_.find(entry.sessionId);
+        return it == attachedSessions_.end() || it->second.urrGeneration != entry.generation;
+    };
+    usageDeadlines_.erase(std::remove_if(usageDeadlines_.begin(), usageDeadlines_.end(), stale),
+                          usageDeadlines_.end());
+    std::make_heap(usageDeadlines_.begin(), usageDeadlines_.end(), std::greater<UsageDeadline>());
+}
+
+void UPF::bufferDownlinkPacket(SessionMetrics& metrics, uint32_t packetSize, uint8_t qfi) {
+    uint32_t index = PacketBufferPool::INVALID_INDEX;
+    if (metrics.bufferedCount < MAX_DL_BUFFERED_PER_SESSION) {
+        index = bufferPool_.acquire();
+    }
+
+    if (index == PacketBufferPool::INVALID_INDEX) {
+        droppedDownlinkPackets_++;
+        logger_.debug(name_, "DL buffer full, packet dropped | Session=" + 
+                            std::to_string(metrics.sessionId));
+        return;
+    }
+
+    PacketBufferPool::BufferedPacket& packet = bufferPool_.at(index);
+    packet.size = packetSize;
+    packet.qfi = qfi;
+    if (metrics.bufferTail == PacketBufferPool::INVALID_INDEX) {
+        metrics.bufferHead = index;
+    } else {
+        bufferPool_.at(metrics.bufferTail).next = index;
+    }
+    metrics.bufferTail = index;
+    metrics.bufferedCount++;
+
+    // First buffered packet triggers paging through SMF/AMF
+    if (!metrics.ddnSent) {
+        metrics.ddnSent = true;
+        pendingNotifications_.push_back(
+            std::make_shared<DownlinkDataNotificationMessage>(metrics.ueId, metrics.sessionId));
+        logger_.info(name_, "Downlink Data Notification | Session=" + 
+                           std::to_string(metrics.sessionId) + 
+                           " | UE=" + std::to_string(metrics.ueId));
+    }
+}
+
+uint32_t UPF::flushDownlinkBuffer(SessionMetrics& metrics, bool deliver) {
+    uint32_t flushed = 0;
+    uint32_t index = metrics.bufferHead;
+
+    while (index != PacketBufferPool::INVALID_INDEX) {
+        uint32_t next = bufferPool_.at(index).next;
+        if (deliver) {
+            // Each packet leaves on the flow it was classified to when buffered
+            const PacketBufferPool::BufferedPacket& packet = bufferPool_.at(index);
+            uint32_t size = packet.size;
+            if (!metrics.egressScheduled ||
+                qosScheduler_.enqueue(packet.qfi, metrics.sessionId, size)) {
+                metrics.downlinkBytes += size;
+                totalDownlinkTraffic_ += size;
+                accountUsage(metrics, 0, size);
+            } else {
+                droppedDownlinkPackets_++;
+            }
+        }
+        bufferPool_.release(index);
+        index = next;
+        flushed++;
+    }
+
+    metrics.bufferHead = PacketBufferPool::INVALID_INDEX;
+    metrics.bufferTail = PacketBufferPool::INVALID_INDEX;
+    metrics.bufferedCount = 0;
+    return flushed;
+}
+
 void UPF::start() {
     NetworkFunction::start();
     logger_.info(name_, "UPF started and ready for packet forwarding");
@@ -162,6 +915,19 @@ void UPF::start() {
 
 void UPF::stop() {
     NetworkFunction::stop();
+    for (auto& pair : attachedSessions_) {
+        flushDownlinkBuffer(pair.second, false);
+    }
     attachedSessions_.clear();
+    pendingNotifications_.clear();
+    flowCache_.clear();
+    qosScheduler_.clear();
+    std::fill(qfiSessions_, qfiSessions_ + QosScheduler::MAX_QFI, 0);
+    dirtySessions_.clear();
+    detachedDeltas_.clear();
+    appUsageSessions_.clear();
+    detachedAppUsage_.clear();
+    pendingReports_.clear();
+    usageDeadlines_.clear();
     logger_.info(name_, "UPF stopped");
 }
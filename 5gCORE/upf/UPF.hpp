@@ -3,11 +3,21 @@
 
 #include "../common/NetworkFunction.hpp"
 #include "../common/Types.hpp"
+#include "../common/N4Protocol.hpp"
+#include "PacketBufferPool.hpp"
+#include "PacketClassifier.hpp"
+#include "FlowCache.hpp"
+#include "QosScheduler.hpp"
+#include "AppDetector.hpp"
 #include <map>
+#include <unordered_map>
+#include <queue>
+#include <vector>
+#include <chrono>
 
 class UPF : public NetworkFunction {
 public:
-    explicit UPF();
+    explicit UPF(uint32_t dlBufferPoolSize = DL_BUFFER_POOL_SIZE);
     ~UPF() override = default;
 
     // UPF Functionality
@@ -17,17 +27,73 @@ public:
     // Packet Forwarding
     void forwardUplinkPacket(SessionId sessionId, uint32_t packetSize);
     void forwardDownlinkPacket(SessionId sessionId, uint32_t packetSize);
+    void forwardUplinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize);
+    void forwardDownlinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize);
+    void forwardUplinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize,
+                             const uint8_t* payload, size_t payloadLength);
+    void forwardDownlinkPacket(SessionId sessionId, const FiveTuple& tuple, uint32_t packetSize,
+                               const uint8_t* payload, size_t payloadLength);
+
+    // Packet Detection (PDR)
+    void installPacketDetectionRules(SessionId sessionId, const std::vector<PacketDetectionRule>& rules);
+    const PacketDetectionRule* classifyPacket(SessionId sessionId, const FiveTuple& tuple) const;
+    uint64_t getUnmatchedPackets() const { return unmatchedPackets_; }
+    uint32_t getTeid(SessionId sessionId) const;
+
+    // Application Detection (SNI / HTTP Host)
+    void installApplicationPatterns(const std::vector<ApplicationPattern>& patterns);
+    std::vector<ApplicationUsage> collectApplicationUsage();
+    const AppDetector& getAppDetector() const { return appDetector_; }
+
+    // Flow Cache
+    void setFlowCacheEnabled(bool enabled) { flowCacheEnabled_ = enabled; }
+    const FlowCache& getFlowCache() const { return flowCache_; }
+
+    // Downlink Buffering (UE in idle mode)
+    void setDownlinkBuffering(SessionId sessionId, bool enabled);
+    std::vector<std::shared_ptr<Message>> collectDownlinkDataNotifications();
+    uint32_t getBufferedPacketCount(SessionId sessionId) const;
+    uint32_t getTotalBufferedPacketCount() const { return bufferPool_.getUsedCount(); }
+    uint64_t getDroppedDownlinkPackets() const { return droppedDownlinkPackets_; }
 
     // QoS Management
     void setQoS(SessionId sessionId, uint32_t bitrate);
     uint32_t getQoS(SessionId sessionId) const;
 
+    // Egress Scheduling (per-QFI downlink queues)
+    // Queues are shared by every session on a QFI, so a QFI in use keeps
+    // its 5QI and priority: a session asking for different ones is refused
+    bool configureQosFlow(SessionId sessionId, uint8_t qfi, uint8_t fiveQi, uint32_t priorityLevel);
+    uint32_t runEgressScheduler(uint32_t budget, std::vector<QosScheduler::ScheduledPacket>* sent = nullptr);
+    const QosScheduler& getQosScheduler() const { return qosScheduler_; }
+
+    // Usage Reporting (URR)
+    void setUsageReportingRule(SessionId sessionId, uint64_t volumeThreshold,
+                               std::chrono::milliseconds timeThreshold);
+    std::shared_ptr<UsageReportMessage> collectUsageReports();
+    std::shared_ptr<UsageReportMessage> collectUsageReports(std::chrono::steady_clock::time_point now);
+    size_t getPendingUsageReportCount() const { return pendingReports_.size(); }
+
+    // Counter Sync: each epoch yields the byte deltas of only those sessions
+    // whose counters moved since the previous epoch (detached ones included)
+    uint32_t collectCounterDeltas(std::vector<CounterDelta>& deltas);
+    size_t publishCounterDeltas();   // Same batch, sent to the SMF over N4
+    uint32_t getCounterEpoch() const { return counterEpoch_; }
+    size_t getDirtySessionCount() const { return dirtySessions_.size(); }
+
     // Traffic Metrics
     uint64_t getTotalUplinkTraffic() const { return totalUplinkTraffic_; }
     uint64_t getTotalDownlinkTraffic() const { return totalDownlinkTraffic_; }
     uint64_t getSessionUplinkTraffic(SessionId sessionId) const;
     uint64_t getSessionDownlinkTraffic(SessionId sessionId) const;
 
+    // N4 (PFCP-style session provisioning from the SMF). Each request
+    // bundle is applied in order and answered with one response bundle.
+    void setN4Sender(N4Sender sender) { n4Sender_ = std::move(sender); }
+    void handleN4Message(const uint8_t* data, size_t length);
+    void sendUsageReports(const std::vector<UsageReport>& reports);
+    uint64_t getN4OperationCount() const { return n4Operations_; }
+
     // Message Handling
     void handleMessage(std::shared_ptr<Message> message) override;
 
@@ -47,13 +113,114 @@ private:
         uint64_t downlinkBytes;
         uint32_t qosRate;  // in kbps
         bool isAttached;
+
+        // Usage reporting state
+        uint64_t unreportedUlBytes;
+        uint64_t unreportedDlBytes;
+        uint64_t volumeThreshold;                 // 0 disables the volume trigger
+        std::chrono::milliseconds timeThreshold;  // 0 disables the time trigger
+        std::chrono::steady_clock::time_point measurementStart;
+        uint32_t urrGeneration;                   // Invalidates stale deadlines
+
+        // Downlink buffering state
+        bool isBuffering;
+        bool ddnSent;            // One notification per buffering episode
+        uint32_t bufferHead;     // FIFO of pooled buffers
+        uint32_t bufferTail;
+        uint32_t bufferedCount;
+
+        // SDF filters compiled when the session's PDRs are installed
+        std::shared_ptr<PacketClassifier> classifier;
+        uint32_t teid;
+        uint32_t flowGeneration;  // Bumped on any change cached flows depend on
+
+        // Egress scheduling: DL packets are queued by QFI once a flow is set up
+        bool egressScheduled;
+        uint8_t defaultQfi;
+
+        // Counters as of the last sync epoch
+        uint64_t syncedUlBytes;
+        uint64_t syncedDlBytes;
+        bool countersDirty;
+
+        // Bytes per detected application since the last collection
+        std::unordered_map<AppId, uint64_t> appUsage;
+        bool appUsagePending;
+    };
+
+    struct FlowMatch {
+        uint32_t pdrId;
+        uint32_t farId;
+        uint8_t qfi;
+        FlowCache::Entry* flow;  // Per-flow state, null when the cache is off
+    };
+
+    struct UsageDeadline {
+        std::chrono::steady_clock::time_point deadline;
+        SessionId sessionId;
+        uint32_t generation;
+
+        bool operator>(const UsageDeadline& other) const { return deadline > other.deadline; }
     };
 
     std::map<SessionId, SessionMetrics> attachedSessions_;
     uint64_t totalUplinkTraffic_;
     uint64_t totalDownlinkTraffic_;
 
+    PacketBufferPool bufferPool_;
+    uint64_t droppedDownlinkPackets_;
+    uint64_t unmatchedPackets_;
+    std::vector<std::shared_ptr<Message>> pendingNotifications_;
+
+    uint32_t teidCounter_;
+    FlowCache flowCache_;
+    bool flowCacheEnabled_;
+    uint32_t flowGenerationCounter_;
+    uint32_t flowClockPackets_;
+    uint32_t flowClockSec_;
+
+    QosScheduler qosScheduler_;
+    uint32_t qfiSessions_[QosScheduler::MAX_QFI];   // Scheduled sessions per QFI
+    uint64_t egressPackets_;
+
+    AppDetector appDetector_;
+    std::vector<SessionId> appUsageSessions_;
+    std::vector<ApplicationUsage> detachedAppUsage_;
+
+    std::vector<SessionId> dirtySessions_;
+    std::vector<CounterDelta> detachedDeltas_;
+    uint32_t counterEpoch_;
+
+    N4Sender n4Sender_;
+    uint32_t n4ReportSequence_;
+    uint64_t n4Operations_;
+
+    std::vector<UsageReport> pendingReports_;
+    // Min-heap on deadline. Re-armed and detached sessions leave stale
+    // entries behind; they are skipped by generation and compacted away
+    // once they outnumber live sessions.
+    std::vector<UsageDeadline> usageDeadlines_;
+
+    N4SessionResult applyN4Operation(const N4SessionOperation& operation);
+    bool acceptsQosFlow(const SessionMetrics* metrics, uint8_t qfi, uint8_t fiveQi,
+                        uint32_t priorityLevel) const;
     void logPacketForwarding(SessionId sessionId, bool isUplink, uint32_t size);
+    void forwardUplink(SessionMetrics& metrics, uint32_t packetSize);
+    void forwardDownlink(SessionMetrics& metrics, uint32_t packetSize, uint8_t qfi);
+    bool matchFlow(SessionMetrics& metrics, const FiveTuple& tuple, uint8_t direction,
+                   FlowMatch& match);
+    void refreshFlowClock();
+    void detectApplication(SessionMetrics& metrics, const FiveTuple& tuple, uint8_t direction,
+                           const FlowMatch& match, const uint8_t* payload, size_t payloadLength,
+                           uint32_t packetSize);
+    void drainApplicationUsage(SessionMetrics& metrics, std::vector<ApplicationUsage>& out);
+    void accountUsage(SessionMetrics& metrics, uint32_t ulBytes, uint32_t dlBytes);
+    void emitUsageReport(SessionMetrics& metrics, UsageReportTrigger trigger,
+                         std::chrono::steady_clock::time_point now);
+    void armUsageDeadline(SessionMetrics& metrics);
+    void compactUsageDeadlines();
+    void bufferDownlinkPacket(SessionMetrics& metrics, uint32_t packetSize, uint8_t qfi);
+    uint32_t flushDownlinkBuffer(SessionMetrics& metrics, bool deliver);
 };
 
 #endif // UPF_HPP